@@ -0,0 +1,101 @@
+/**
+ * File containing the implementation of the counting allocator used to
+ * check that the commands do not allocate.
+ * @file Alloc.c
+ * @author ist1102716
+*/
+#include "Alloc.h"
+
+#ifdef TRACK_ALLOC
+
+#include <stdlib.h>
+
+// Number of distinct command letters
+#define COMMAND_LETTERS 128
+
+// Entry points of the allocator of the C library
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+
+/**
+ * @struct CommandAllocations
+ * @brief Allocations made by the runs of one command.
+ */
+typedef struct {
+    unsigned long long runs;
+    unsigned long long allocating_runs;
+    unsigned long long allocations;
+} CommandAllocations;
+
+static unsigned long long allocations;
+static unsigned long long frees;
+static unsigned long long command_start;
+static CommandAllocations commands[COMMAND_LETTERS];
+
+// Counts one call; the reclaimer thread frees concurrently with the others
+static void count_call(unsigned long long *counter) {
+    __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size) {
+    count_call(&allocations);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    count_call(&allocations);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+    count_call(&allocations);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer) {
+    if (pointer != NULL) {
+        count_call(&frees);
+    }
+    __libc_free(pointer);
+}
+
+void get_alloc_counts(AllocCounts *counts) {
+    counts->allocations = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+    counts->frees = __atomic_load_n(&frees, __ATOMIC_RELAXED);
+}
+
+void begin_command_allocations(void) {
+    command_start = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
+
+void end_command_allocations(const char *command) {
+    if (command == NULL) {
+        return;
+    }
+    unsigned long long made = __atomic_load_n(&allocations,
+                                                __ATOMIC_RELAXED) -
+                                command_start;
+    CommandAllocations *entry =
+        &commands[(unsigned char)command[0] % COMMAND_LETTERS];
+    entry->runs++;
+    entry->allocating_runs += made > 0;
+    entry->allocations += made;
+}
+
+void print_alloc_report(FILE *stream) {
+    AllocCounts counts;
+    get_alloc_counts(&counts);
+    fprintf(stream, "alloc: %llu allocations, %llu frees\n",
+            counts.allocations, counts.frees);
+    for (int i = 0; i < COMMAND_LETTERS; i++) {
+        if (commands[i].runs > 0) {
+            fprintf(stream, "alloc %c: %llu runs, %llu allocating, "
+                    "%llu allocations\n", i, commands[i].runs,
+                    commands[i].allocating_runs, commands[i].allocations);
+        }
+    }
+}
+
+#endif /* TRACK_ALLOC */
@@ -0,0 +1,64 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stdio.h>
+
+/*
+ * Building with -DTRACK_ALLOC replaces malloc, calloc, realloc and free by
+ * versions that count every call before forwarding it to the C library,
+ * and makes the text mode report, when it quits, how many heap calls each
+ * command made. Without it the hooks below compile to nothing.
+ */
+
+#ifdef TRACK_ALLOC
+
+/**
+ * @struct AllocCounts
+ * @brief Heap calls made by the program so far.
+ */
+typedef struct {
+    unsigned long long allocations;     // Calls to malloc, calloc or realloc
+    unsigned long long frees;           // Calls to free
+} AllocCounts;
+
+/**
+ * Gets the heap calls made so far, by every thread.
+ *
+ * @param counts The counts.
+ */
+void get_alloc_counts(AllocCounts *counts);
+
+/**
+ * Starts counting the allocations of a command.
+ */
+void begin_command_allocations(void);
+
+/**
+ * Adds the allocations made since begin_command_allocations to the ones
+ * of a command.
+ *
+ * @param command The command, NULL for an empty line.
+ */
+void end_command_allocations(const char *command);
+
+/**
+ * Prints, for each command, how many times it ran, how many of those runs
+ * allocated and how many allocations they made in all.
+ *
+ * @param stream The stream the report is printed to.
+ */
+void print_alloc_report(FILE *stream);
+
+#define BEGIN_COMMAND_ALLOCATIONS() begin_command_allocations()
+#define END_COMMAND_ALLOCATIONS(command) end_command_allocations(command)
+#define PRINT_ALLOC_REPORT(stream) print_alloc_report(stream)
+
+#else
+
+#define BEGIN_COMMAND_ALLOCATIONS() ((void)0)
+#define END_COMMAND_ALLOCATIONS(command) ((void)(command))
+#define PRINT_ALLOC_REPORT(stream) ((void)(stream))
+
+#endif /* TRACK_ALLOC */
+
+#endif /* ALLOC_H */
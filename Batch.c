@@ -0,0 +1,61 @@
+/**
+ * File containing the implementation of the batch API used by the gate
+ * controllers to send bursts of entries and exits.
+ * @file Batch.c
+ * @author ist1102716
+*/
+#include <string.h>
+#include "Batch.h"
+#include "Engine.h"
+#include "Invariants.h"
+
+// Whether two events name the same park; a missing name matches nothing
+static int same_park_name(const GateEvent *event, const GateEvent *other) {
+    return event->park_name != NULL && other->park_name != NULL &&
+            (event->park_name == other->park_name ||
+            strcmp(event->park_name, other->park_name) == 0);
+}
+
+void process_gate_event(Parks *parks, Park *park, const GateEvent *event,
+                        GateResult *result) {
+    ParkRecord *closed = NULL;
+    memset(result, 0, sizeof(GateResult));
+    if (park == NULL) {
+        result->status = GATE_NO_SUCH_PARKING;
+    } else if (event->license_plate == NULL ||
+                !isValidLicensePlate(event->license_plate)) {
+        result->status = GATE_INVALID_PLATE;
+    } else if (event->type == BATCH_ENTRY && isParkFull(parks, park)) {
+        result->status = GATE_PARKING_FULL;
+    } else if (!isValidDateValue(event->date)) {
+        result->status = GATE_INVALID_DATE;
+    } else if (event->type == BATCH_ENTRY) {
+        result->status = register_entry(parks, park, event->license_plate,
+                                        event->date, ZONE_DEFAULT_TYPE,
+                                        &result->spot);
+    } else {
+        result->status = register_exit(parks, park, event->license_plate,
+                                        event->date, &closed);
+    }
+    result->available_spots = park != NULL ?
+                                parks->free_spots[park->handle] : 0;
+    result->cost_cents = closed != NULL ? closed->cost_cents : 0;
+    if (closed != NULL) {
+        result->in_date = *closed->in_date;
+        result->spot = closed->spot;
+    }
+}
+
+void process_gate_batch(Parks *parks, const GateEvent *events, int count,
+                        GateResult *results) {
+    Park *park = NULL;
+    for (int i = 0; i < count; i++) {
+        // Bursts usually repeat the park of the previous event, and entries
+        // and exits never add or remove a park
+        if (i == 0 || !same_park_name(&events[i], &events[i - 1])) {
+            park = events[i].park_name != NULL ?
+                    get_park(parks, (char *)events[i].park_name) : NULL;
+        }
+        process_gate_event(parks, park, &events[i], &results[i]);
+    }
+}
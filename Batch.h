@@ -0,0 +1,62 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "Parks.h"
+#include "Date.h"
+
+// Type of a gate event for the entry of a vehicle
+#define BATCH_ENTRY 'e'
+// Type of a gate event for the exit of a vehicle
+#define BATCH_EXIT 's'
+
+/**
+ * @struct GateEvent
+ * @brief One entry or exit sent by a gate controller, already parsed.
+ */
+typedef struct {
+    char type;                  // BATCH_ENTRY or BATCH_EXIT
+    const char *park_name;      // NULL for a park that does not exist
+    const char *license_plate;  // NULL for an invalid plate
+    Date date;                  // Date and time of the event
+} GateEvent;
+
+/**
+ * @struct GateResult
+ * @brief Outcome of one gate event.
+ */
+typedef struct {
+    int status;                 // GATE_OK or the reason it was refused
+    int available_spots;        // Free spots of the park after the event
+    long long cost_cents;       // Cost in cents of the stay closed by an exit
+    Date in_date;               // Entry of the stay closed by an exit
+    int spot;                   // Spot taken by an entry or freed by an exit
+} GateResult;
+
+/**
+ * Processes a burst of entries and exits, with the same rules as the e and
+ * s commands.
+ *
+ * Events are applied in the given order, so the outcome is the same as
+ * sending them one by one. Each park is looked up in the name table once
+ * per run of events that name it.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param events The events, in arrival order.
+ * @param count The number of events.
+ * @param results Array of count results, filled in the order of the events.
+ */
+void process_gate_batch(Parks *parks, const GateEvent *events, int count,
+                        GateResult *results);
+
+/**
+ * Validates and applies one gate event whose park is already resolved.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param park The park named by the event, or NULL if there is none.
+ * @param event The event; its park_name is not used.
+ * @param result The outcome of the event, to be filled.
+ */
+void process_gate_event(Parks *parks, Park *park, const GateEvent *event,
+                        GateResult *result);
+
+#endif /* BATCH_H */
@@ -0,0 +1,115 @@
+/**
+ * File containing the implementation of the network wide billing report.
+ * @file Billing.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Billing.h"
+#include "Kernels.h"
+
+// Room for the date, the total and the separators of a line
+#define BILLING_LINE_EXTRA 48
+
+/**
+ * @struct BillingJob
+ * @brief One batch of parks, in name order, and their reports.
+ */
+typedef struct {
+    Parks *parks;
+    int first_rank;         // Rank of the first park of the batch
+    BillingOutput *outputs; // Report of each park of the batch
+} BillingJob;
+
+// Makes room for a number of bytes at the end of a report
+static int reserve_output(BillingOutput *output, size_t extra) {
+    if (output->size + extra <= output->capacity) {
+        return 1;
+    }
+    size_t capacity = output->capacity > 0 ? output->capacity : extra;
+    while (capacity < output->size + extra) {
+        capacity *= 2;
+    }
+    char *data = (char *)realloc(output->data, capacity);
+    if (data == NULL) {
+        output->failed = 1;
+        return 0; // Memory allocation failed
+    }
+    output->data = data;
+    output->capacity = capacity;
+    return 1;
+}
+
+// Builds the report of one park of the batch; runs on any thread, and only
+// reads the park
+static void build_park_billing(void *context, int item) {
+    BillingJob *job = (BillingJob *)context;
+    Park *park = get_park_by_rank(job->parks, job->first_rank + item);
+    BillingOutput *output = &job->outputs[item];
+    const History *history = &park->history;
+    size_t line_size = strlen(park->name) + BILLING_LINE_EXTRA;
+    output->size = 0;
+    output->failed = 0;
+    // A line per day with revenue, so this is usually the only growth
+    reserve_output(output, (park->revenue.capacity + 1) * line_size);
+    int i = 0;
+    // Rows are sorted by exit, so the exits of each day are contiguous
+    while (i < history->count && reserve_output(output, line_size)) {
+        int day_start = history->out_minutes[i] / MINUTES_PER_DAY *
+                        MINUTES_PER_DAY;
+        RangeTotal total = kernel_range_total(history->out_minutes + i,
+                                                history->cost_cents + i,
+                                                history->count - i, day_start,
+                                                day_start + MINUTES_PER_DAY);
+        Date date = minutes_to_date(day_start);
+        char *line = output->data + output->size;
+        int written = snprintf(line, line_size, "%s %02d-%02d-%d ",
+                                park->name, date.day, date.month, date.year);
+        written += format_cents(line + written, line_size - written,
+                                total.cents);
+        line[written++] = '\n';
+        output->size += written;
+        i += total.count;
+    }
+}
+
+void print_network_billing(Parks *parks, FILE *out) {
+    // Pricing may update the network indexes, so it is done up front
+    price_parks(parks);
+    if (parks->billing == NULL) {
+        parks->billing = (BillingOutput *)calloc(BILLING_BATCH,
+                                                    sizeof(BillingOutput));
+        if (parks->billing == NULL) {
+            fprintf(out, "Memory allocation failed.\n");
+            return;
+        }
+    }
+    BillingOutput *outputs = parks->billing;
+    BillingJob job = {parks, 0, outputs};
+    for (; job.first_rank < parks->size; job.first_rank += BILLING_BATCH) {
+        int count = parks->size - job.first_rank;
+        if (count > BILLING_BATCH) {
+            count = BILLING_BATCH;
+        }
+        run_in_parallel(&parks->workers, build_park_billing, &job, count);
+        for (int i = 0; i < count; i++) {
+            if (outputs[i].failed) {
+                fprintf(out, "Memory allocation failed.\n");
+            } else {
+                fwrite(outputs[i].data, 1, outputs[i].size, out);
+            }
+        }
+    }
+}
+
+void destroy_network_billing(Parks *parks) {
+    if (parks->billing == NULL) {
+        return;
+    }
+    for (int i = 0; i < BILLING_BATCH; i++) {
+        free(parks->billing[i].data);
+    }
+    free(parks->billing);
+    parks->billing = NULL;
+}
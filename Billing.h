@@ -0,0 +1,42 @@
+#ifndef BILLING_H
+#define BILLING_H
+
+#include "Parks.h"
+
+// Number of parks whose reports are built in parallel before being printed
+#define BILLING_BATCH 256
+
+/**
+ * @struct BillingOutput
+ * @brief Text of the billing report of one park.
+ */
+typedef struct BillingOutput {
+    char *data;
+    size_t size;
+    size_t capacity;
+    int failed;             // Whether memory allocation failed
+} BillingOutput;
+
+/**
+ * Prints the daily revenue of every park, parks in name order and the days
+ * of each park in date order, one "<park> DD-MM-YYYY <total>" line each.
+ *
+ * The reports of the parks are built in parallel by the worker pool of the
+ * parks, a batch at a time, and printed as soon as their batch is done.
+ * Their buffers are kept in the parks for the next report, each sized for
+ * the days the revenue index of its park has room for, so a report only
+ * touches the heap when a park has outgrown them.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param out The stream printed to.
+ */
+void print_network_billing(Parks *parks, FILE *out);
+
+/**
+ * Frees the buffers print_network_billing keeps between reports.
+ *
+ * @param parks The pointer to the Parks struct.
+ */
+void destroy_network_billing(Parks *parks);
+
+#endif /* BILLING_H */
@@ -0,0 +1,90 @@
+/**
+ * File containing the implementation of the Bloom filter over the license
+ * plates.
+ * @file Bloom.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Bloom.h"
+
+// Size in bytes of a block, which is also its alignment
+#define BLOOM_BLOCK_BYTES (BLOOM_BLOCK_WORDS * sizeof(uint64_t))
+// Number of bits of the hash used to pick each bit of a block
+#define BLOOM_BIT_HASH_BITS 9
+// Mask picking one bit of a block
+#define BLOOM_BIT_MASK ((1 << BLOOM_BIT_HASH_BITS) - 1)
+
+// Hash of a plate, independent from the one of the vehicle index
+static uint64_t bloom_hash(uint64_t plate) {
+    plate *= 0x9E3779B97F4A7C15ull;
+    plate ^= plate >> 29;
+    plate *= 0xBF58476D1CE4E5B9ull;
+    plate ^= plate >> 32;
+    return plate;
+}
+
+// Block of a plate, from the high bits of its hash
+static uint64_t *bloom_block(const BloomFilter *filter, uint64_t hash) {
+    return &filter->blocks[((hash >> 40) & (filter->block_count - 1)) *
+                            BLOOM_BLOCK_WORDS];
+}
+
+// Bits of a plate within its block, remixed so they do not depend on the
+// bits that picked the block
+static uint64_t bloom_bits(uint64_t hash) {
+    hash *= 0xD6E8FEB86659FD93ull;
+    return hash ^ (hash >> 32);
+}
+
+void init_bloom_filter(BloomFilter *filter) {
+    filter->blocks = NULL;
+    filter->block_count = 0;
+}
+
+int reset_bloom_filter(BloomFilter *filter, int block_count) {
+    destroy_bloom_filter(filter);
+    filter->blocks = (uint64_t *)aligned_alloc(BLOOM_BLOCK_BYTES,
+                                                block_count *
+                                                BLOOM_BLOCK_BYTES);
+    if (filter->blocks == NULL) {
+        return 0; // Memory allocation failed
+    }
+    memset(filter->blocks, 0, block_count * BLOOM_BLOCK_BYTES);
+    filter->block_count = block_count;
+    return 1;
+}
+
+void bloom_add(BloomFilter *filter, uint64_t plate) {
+    if (filter->blocks == NULL) {
+        return;
+    }
+    uint64_t hash = bloom_hash(plate);
+    uint64_t *block = bloom_block(filter, hash);
+    uint64_t bits = bloom_bits(hash);
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        int bit = (bits >> (i * BLOOM_BIT_HASH_BITS)) & BLOOM_BIT_MASK;
+        block[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+int bloom_may_contain(const BloomFilter *filter, uint64_t plate) {
+    if (filter->blocks == NULL) {
+        return 1;
+    }
+    uint64_t hash = bloom_hash(plate);
+    const uint64_t *block = bloom_block(filter, hash);
+    uint64_t bits = bloom_bits(hash);
+    for (int i = 0; i < BLOOM_HASHES; i++) {
+        int bit = (bits >> (i * BLOOM_BIT_HASH_BITS)) & BLOOM_BIT_MASK;
+        if ((block[bit / 64] & (1ull << (bit % 64))) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void destroy_bloom_filter(BloomFilter *filter) {
+    free(filter->blocks);
+    init_bloom_filter(filter);
+}
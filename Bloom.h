@@ -0,0 +1,65 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stdint.h>
+
+// Number of 64 bit words of a block, one cache line
+#define BLOOM_BLOCK_WORDS 8
+// Number of bits set in its block by each plate
+#define BLOOM_HASHES 6
+
+/**
+ * @struct BloomFilter
+ * @brief Blocked Bloom filter over packed license plates.
+ *
+ * Each plate sets a few bits of a single block, so a lookup reads one
+ * cache line. A plate that was added is always reported; one that was not
+ * is only reported by a false positive.
+ */
+typedef struct {
+    uint64_t *blocks;       // BLOOM_BLOCK_WORDS words each, NULL if unsized
+    int block_count;        // Power of two
+} BloomFilter;
+
+/**
+ * Initializes a filter with no blocks, which reports every plate.
+ *
+ * @param filter The filter to be initialized.
+ */
+void init_bloom_filter(BloomFilter *filter);
+
+/**
+ * Empties a filter and gives it a new number of blocks.
+ *
+ * @param filter The filter.
+ * @param block_count The number of blocks, a power of two.
+ * @return 1 on success, 0 if memory allocation failed, leaving the filter
+ * with no blocks.
+ */
+int reset_bloom_filter(BloomFilter *filter, int block_count);
+
+/**
+ * Adds a plate to a filter.
+ *
+ * @param filter The filter.
+ * @param plate The packed license plate (see pack_license_plate).
+ */
+void bloom_add(BloomFilter *filter, uint64_t plate);
+
+/**
+ * Checks whether a plate may have been added to a filter.
+ *
+ * @param filter The filter.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @return 0 if the plate was certainly not added, 1 otherwise.
+ */
+int bloom_may_contain(const BloomFilter *filter, uint64_t plate);
+
+/**
+ * Frees the memory of a filter.
+ *
+ * @param filter The filter.
+ */
+void destroy_bloom_filter(BloomFilter *filter);
+
+#endif /* BLOOM_H */
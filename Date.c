@@ -5,6 +5,11 @@
 */
 #include "Date.h"
 
+// Number of days in a 400 year Gregorian cycle
+#define DAYS_PER_ERA 146097
+// Days between 01-03-0000 (start of the shifted calendar) and 01-01-0001
+#define DAYS_TO_YEAR_ONE 306
+
 // Function to calculate the number of days in a month
 int days_in_month(int month, int year) {
     switch (month) {
@@ -24,44 +29,18 @@ int days_in_month(int month, int year) {
 }
 
 // Function to calculate the difference in minutes between two dates
-int minutes_between_dates(Date date1, Date date2) {
-    int minutes = 0;
-
-    // Calculate total minutes for date1
-    minutes += date1.minute;
-    minutes += date1.hour * 60;
-    minutes += (date1.day - 1) * 24 * 60; // Subtract one day for the current day
-    for (int m = 1; m < date1.month; m++) {
-        minutes += days_in_month(m, date1.year) * 24 * 60;
-    }
-    for (int y = 1; y < date1.year; y++) {
-        int leap_year = (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
-        minutes += (365 + leap_year) * 24 * 60;
-    }
-
-    // Subtract total minutes for date2
-    minutes -= date2.minute;
-    minutes -= (date2.hour * 60);
-    minutes -= (date2.day - 1) * 24 * 60; // Subtract one day for the current day
-    for (int m = 1; m < date2.month; m++) {
-        minutes -= days_in_month(m, date2.year) * 24 * 60;
-    }
-    for (int y = 1; y < date2.year; y++) {
-        int leap_year = (y % 4 == 0 && y % 100 != 0) || (y % 400 == 0);
-        minutes -= (365 + leap_year) * 24 * 60;
-    }
-
-    return abs(minutes);
+long long minutes_between_dates(Date date1, Date date2) {
+    return llabs(date_to_minutes(date1) - date_to_minutes(date2));
 }
 
 // Function to print the date in the format: DD-MM-YYYY
-void printDate(Date date) {
-    printf("%02d-%02d-%04d", date.day, date.month, date.year);
+void printDate(Date date, FILE *out) {
+    fprintf(out, "%02d-%02d-%04d", date.day, date.month, date.year);
 }
 
 // Function to print the time in the format: HH:MM
-void printTime(Date date) {
-    printf("%02d:%02d", date.hour, date.minute);
+void printTime(Date date, FILE *out) {
+    fprintf(out, "%02d:%02d", date.hour, date.minute);
 }
 
 // Function to check if one date is after another date
@@ -110,6 +89,53 @@ int isValid(Date date) {
     return 1;
 }
 
+// Number of days since 01-01-0001, using a calendar shifted to start in March
+// so that the leap day is the last day of the year
+static long long days_from_civil(int day, int month, int year) {
+    long long shifted_year = (long long)year - (month <= 2);
+    long long era = (shifted_year >= 0 ? shifted_year : shifted_year - 399) /
+                    400;
+    int year_of_era = (int)(shifted_year - era * 400);
+    int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 +
+                        day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 +
+                        day_of_year;
+    return era * DAYS_PER_ERA + day_of_era - DAYS_TO_YEAR_ONE;
+}
+
+long long date_to_minutes(Date date) {
+    long long days = days_from_civil(date.day, date.month, date.year);
+    return days * MINUTES_PER_DAY + date.hour * MINUTES_PER_HOUR + date.minute;
+}
+
+int saturate_minute(long long minutes) {
+    if (minutes > LAST_MINUTE) {
+        return LAST_MINUTE;
+    }
+    return minutes < -LAST_MINUTE ? -LAST_MINUTE : (int)minutes;
+}
+
+Date minutes_to_date(long long minutes) {
+    Date date;
+    long long days = minutes / MINUTES_PER_DAY + DAYS_TO_YEAR_ONE;
+    long long era = days / DAYS_PER_ERA;
+    int day_of_era = (int)(days - era * DAYS_PER_ERA);
+    int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 -
+                        day_of_era / (DAYS_PER_ERA - 1)) / 365;
+    int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 -
+                        year_of_era / 100);
+    int shifted_month = (5 * day_of_year + 2) / 153;
+
+    date.day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    date.month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    date.year = (int)(year_of_era + era * 400 + (date.month <= 2));
+    date.hour = (int)(minutes % MINUTES_PER_DAY) / MINUTES_PER_HOUR;
+    date.minute = (int)(minutes % MINUTES_PER_HOUR);
+    date.cost = 0;
+    date.license_plate = NULL;
+    return date;
+}
+
 // Function to create a new Date object
 Date* createDate(int day, int month, int year, int hour, int minute) {
     // Allocate memory for a Date structure
@@ -3,6 +3,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
+
+// Number of minutes in an hour
+#define MINUTES_PER_HOUR 60
+// Number of minutes in a day
+#define MINUTES_PER_DAY (24 * MINUTES_PER_HOUR)
+// Last minute kept by the int columns, at the end of a day so that the
+// minute a day after any kept one still fits an int (31-12-4083 is whole)
+#define LAST_MINUTE (INT_MAX / MINUTES_PER_DAY * MINUTES_PER_DAY - 1)
 
 // Structure representing a date
 typedef struct Date {
@@ -31,21 +40,23 @@ int days_in_month(int month, int year);
  * @param date2 The second date.
  * @return The number of minutes between the two dates.
  */
-int minutes_between_dates(Date date1, Date date2);
+long long minutes_between_dates(Date date1, Date date2);
 
 /**
  * Prints the given date in the format: DD-MM-YYYY.
  *
  * @param date The date to be printed.
+ * @param out The stream printed to.
  */
-void printDate(Date date);
+void printDate(Date date, FILE *out);
 
 /**
  * Prints the time of the given date in the format: HH:MM.
  *
  * @param date The date object for which the time will be printed.
+ * @param out The stream printed to.
  */
-void printTime(Date date);
+void printTime(Date date, FILE *out);
 
 /**
  * Checks if one date is after another date.
@@ -64,6 +75,34 @@ int isAfter(Date date1, Date date2);
  */
 int isValid(Date date);
 
+/**
+ * Converts a date into the number of minutes elapsed since 01-01-0001 00:00.
+ *
+ * @param date The date to be converted.
+ * @return The number of minutes since the start of the calendar; it does
+ * not fit an int from the year 4084 on.
+ */
+long long date_to_minutes(Date date);
+
+/**
+ * Narrows a minute to the int kept by the history, occupancy and snapshot
+ * columns. Minutes past the year 4083 are kept as LAST_MINUTE (and those
+ * before the year -4083 as its opposite), so that the columns stay sorted,
+ * but they no longer tell those dates apart.
+ *
+ * @param minutes The number of minutes since the start of the calendar.
+ * @return The minutes, saturated to the range of an int.
+ */
+int saturate_minute(long long minutes);
+
+/**
+ * Converts a number of minutes elapsed since 01-01-0001 00:00 into a date.
+ *
+ * @param minutes The number of minutes since the start of the calendar.
+ * @return The corresponding date (cost and license plate are cleared).
+ */
+Date minutes_to_date(long long minutes);
+
 /**
  * Creates a new Date object.
  *
@@ -0,0 +1,130 @@
+/**
+ * File containing the implementation of the histograms of the stay lengths
+ * of each park and day.
+ * @file Dwell.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Dwell.h"
+
+// Bucket of a stay length
+static int dwell_bucket(int minutes) {
+    if (minutes < DWELL_SUB_BUCKETS) {
+        return minutes > 0 ? minutes : 0;
+    }
+    int bit = 31 - __builtin_clz((unsigned)minutes);
+    if (bit > DWELL_MAX_BIT) {
+        return DWELL_BUCKETS - 1;
+    }
+    int shift = bit - DWELL_SUB_BITS;
+    return (shift + 1) * DWELL_SUB_BUCKETS +
+            ((minutes >> shift) & (DWELL_SUB_BUCKETS - 1));
+}
+
+// Highest stay length of a bucket
+static int dwell_bucket_high(int bucket) {
+    if (bucket < DWELL_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / DWELL_SUB_BUCKETS - 1;
+    int low = (DWELL_SUB_BUCKETS + bucket % DWELL_SUB_BUCKETS) << shift;
+    return low + (1 << shift) - 1;
+}
+
+void clear_dwell_histogram(DwellHistogram *histogram) {
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+    histogram->total = 0;
+}
+
+int dwell_percentile(const DwellHistogram *histogram, double percent) {
+    if (histogram->total == 0) {
+        return 0;
+    }
+    // Rank of the stay, from 1 to total
+    int64_t rank = (int64_t)(percent / 100.0 * histogram->total + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    } else if (rank > histogram->total) {
+        rank = histogram->total;
+    }
+    int64_t seen = 0;
+    for (int bucket = 0; bucket < DWELL_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            return dwell_bucket_high(bucket);
+        }
+    }
+    return dwell_bucket_high(DWELL_BUCKETS - 1);
+}
+
+void init_daily_dwell(DailyDwell *dwell) {
+    dwell->days = NULL;
+    dwell->histograms = NULL;
+    dwell->count = 0;
+    dwell->capacity = 0;
+}
+
+int reserve_daily_dwell(DailyDwell *dwell, int days) {
+    if (days <= dwell->capacity) {
+        return 1;
+    }
+    int *day_array = (int *)realloc(dwell->days, days * sizeof(int));
+    if (day_array == NULL) {
+        return 0; // Memory allocation failed
+    }
+    dwell->days = day_array;
+    DwellHistogram *histograms = (DwellHistogram *)realloc(
+        dwell->histograms, days * sizeof(DwellHistogram));
+    if (histograms == NULL) {
+        return 0; // Memory allocation failed
+    }
+    dwell->histograms = histograms;
+    dwell->capacity = days;
+    return 1;
+}
+
+int add_daily_dwell(DailyDwell *dwell, int day, int minutes) {
+    int last = dwell->count - 1;
+    if (last < 0 || dwell->days[last] != day) {
+        if (dwell->count == dwell->capacity &&
+            !reserve_daily_dwell(dwell, dwell->capacity > 0 ?
+                                    dwell->capacity * 2 : DWELL_INITIAL_DAYS)) {
+            return 0;
+        }
+        last = dwell->count++;
+        dwell->days[last] = day;
+        clear_dwell_histogram(&dwell->histograms[last]);
+    }
+    dwell->histograms[last].counts[dwell_bucket(minutes)]++;
+    dwell->histograms[last].total++;
+    return 1;
+}
+
+void merge_daily_dwell(const DailyDwell *dwell, int first_day, int last_day,
+                        DwellHistogram *histogram) {
+    // First day of the index not before the range
+    int low = 0;
+    int high = dwell->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (dwell->days[middle] < first_day) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (int i = low; i < dwell->count && dwell->days[i] <= last_day; i++) {
+        const DwellHistogram *day = &dwell->histograms[i];
+        for (int bucket = 0; bucket < DWELL_BUCKETS; bucket++) {
+            histogram->counts[bucket] += day->counts[bucket];
+        }
+        histogram->total += day->total;
+    }
+}
+
+void destroy_daily_dwell(DailyDwell *dwell) {
+    free(dwell->days);
+    free(dwell->histograms);
+    init_daily_dwell(dwell);
+}
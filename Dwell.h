@@ -0,0 +1,108 @@
+#ifndef DWELL_H
+#define DWELL_H
+
+#include <stdint.h>
+
+// Linear buckets in each power of two of a stay length; a bucket is at
+// most 1 / DWELL_SUB_BUCKETS of the lengths it holds wide
+#define DWELL_SUB_BITS 4
+#define DWELL_SUB_BUCKETS (1 << DWELL_SUB_BITS)
+// Highest bit of a stay length with buckets of its own; longer stays, of
+// 2^21 minutes (about four years) or more, share the last bucket
+#define DWELL_MAX_BIT 20
+#define DWELL_BUCKETS (DWELL_SUB_BUCKETS * \
+                        (DWELL_MAX_BIT - DWELL_SUB_BITS + 2))
+// Initial number of days allocated for a dwell index
+#define DWELL_INITIAL_DAYS 16
+
+/**
+ * @struct DwellHistogram
+ * @brief Log-linear histogram of stay lengths, in minutes.
+ *
+ * Lengths below DWELL_SUB_BUCKETS have a bucket each; above, every power
+ * of two is split in DWELL_SUB_BUCKETS equal buckets, so a percentile is
+ * off by less than 1 / DWELL_SUB_BUCKETS of itself in fixed memory.
+ */
+typedef struct {
+    uint32_t counts[DWELL_BUCKETS];
+    int64_t total;          // Stays counted
+} DwellHistogram;
+
+/**
+ * @struct DailyDwell
+ * @brief One histogram per day with exits of a park.
+ *
+ * The exits of a park are chronological, so days are only ever appended
+ * (or the last one updated) and stay sorted.
+ */
+typedef struct {
+    int *days;              // Days with exits, as minutes / MINUTES_PER_DAY
+    DwellHistogram *histograms;
+    int count;
+    int capacity;
+} DailyDwell;
+
+/**
+ * Empties a histogram.
+ *
+ * @param histogram The histogram.
+ */
+void clear_dwell_histogram(DwellHistogram *histogram);
+
+/**
+ * Gets a percentile of the stay lengths of a histogram.
+ *
+ * @param histogram The histogram.
+ * @param percent The percentile, from 0 to 100.
+ * @return The highest length of the bucket holding it, in minutes, or 0 if
+ * the histogram is empty.
+ */
+int dwell_percentile(const DwellHistogram *histogram, double percent);
+
+/**
+ * Initializes an empty dwell index.
+ *
+ * @param dwell The index to be initialized.
+ */
+void init_daily_dwell(DailyDwell *dwell);
+
+/**
+ * Makes room for at least a number of days, so that counting stays that
+ * end on up to that many days does not touch the heap.
+ *
+ * @param dwell The index.
+ * @param days The number of days, those already in the index included.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_daily_dwell(DailyDwell *dwell, int days);
+
+/**
+ * Counts a stay that ended on a day not before the last one in the index,
+ * in O(1) (amortized when the day is new).
+ *
+ * @param dwell The index.
+ * @param day The day of the exit.
+ * @param minutes The length of the stay.
+ * @return 1 if the stay was counted, 0 if memory allocation failed.
+ */
+int add_daily_dwell(DailyDwell *dwell, int day, int minutes);
+
+/**
+ * Adds the histograms of an inclusive range of days to another one.
+ *
+ * @param dwell The index.
+ * @param first_day The first day of the range.
+ * @param last_day The last day of the range.
+ * @param histogram The histogram the stays are added to.
+ */
+void merge_daily_dwell(const DailyDwell *dwell, int first_day, int last_day,
+                        DwellHistogram *histogram);
+
+/**
+ * Frees the memory of a dwell index.
+ *
+ * @param dwell The index to be destroyed.
+ */
+void destroy_daily_dwell(DailyDwell *dwell);
+
+#endif /* DWELL_H */
@@ -6,34 +6,32 @@
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
 #include <string.h>
 #include "Engine.h"
 #include "Park.h"
 #include "Records.h"
+#include "Snapshot.h"
+#include "Billing.h"
+#include "Memory.h"
 
-void print_all_parks(Parks *parks) {
-    int count;
-    Park** ordered_parks = get_parks_ordered_by_id(parks, &count);
-    if (ordered_parks != NULL) {
-        print_park_names_ordered_by_id(ordered_parks, count);
-        free_ordered_parks(ordered_parks); // Free memory
-    } else {
-        printf("Memory allocation failed.\n");
-    }
+void print_all_parks(Parks *parks, FILE *out) {
+    print_parks(parks, out);
 }
 
-void add_park_command(Parks *parks, char *args[], int argc) {
+void add_park_command(Parks *parks, char *args[], int argc, FILE *out) {
     if (argc > 1) {
         // Check if the park already exists
         if (ParkAlreadyExists(parks, args[1])) {
-            printf("%s: parking already exists.\n", args[1]);
+            fprintf(out, "%s: parking already exists.\n", args[1]);
             return;
         }
 
         // Validate capacity
         int capacity = atoi(args[2]);
         if (!isCapacityValid(capacity)) {
-            printf("%s: invalid capacity.\n", args[2]);
+            fprintf(out, "%s: invalid capacity.\n", args[2]);
             return;
         }
 
@@ -42,13 +40,13 @@ void add_park_command(Parks *parks, char *args[], int argc) {
         float price_15_1h = atof(args[4]);
         float price_1h = atof(args[5]);
         if (!isCostValid(price_15, price_15_1h, price_1h)) {
-            printf("invalid cost.\n");
+            fprintf(out, "invalid cost.\n");
             return;
         }
 
         // Check if maximum number of parks is reached
         if (isParksMaxed(parks)) {
-            printf("too many parks.\n");
+            fprintf(out, "too many parks.\n");
             return;
         }
 
@@ -57,278 +55,820 @@ void add_park_command(Parks *parks, char *args[], int argc) {
         Park *park = create_park(args[1], capacity, price_15, price_15_1h,
                                 price_1h, id);
         if (park == NULL) {
-            printf("Failed to create park.\n");
+            fprintf(out, "Failed to create park.\n");
             return;
         }
         parks->parks_id++;
         add_park(parks, park);
     } else {
-        print_all_parks(parks);
+        print_all_parks(parks, out);
+    }
+}
+
+// Whether a date is not before the last one of a park
+static int is_park_date_current(Parks *parks, Park *park, Date date) {
+    return date_to_minutes(date) >= parks->last_minutes[park->handle];
+}
+
+// Makes a date the last one of a park and moves the overstay clock to it
+static void advance_park_date(Parks *parks, Park *park, Date date) {
+    long long minute = date_to_minutes(date);
+    parks->last_minutes[park->handle] = minute;
+    advance_overstay(&parks->overstay, minute);
+}
+
+int register_entry(Parks *parks, Park *park, const char *license_plate,
+                    Date date, int type, int *spot) {
+    if (isParkFull(parks, park) || !has_free_zone_spot(&park->zones, type)) {
+        return GATE_PARKING_FULL;
+    }
+    uint64_t plate = pack_license_plate(license_plate);
+    if (vehicle_park(&parks->vehicles, plate) != NO_PARK) {
+        return GATE_INVALID_ENTRY;
+    }
+    if (!is_park_date_current(parks, park, date)) {
+        return GATE_INVALID_DATE;
+    }
+    // The spot and the record are taken before anything else changes, so
+    // that a failed allocation leaves the park as it was
+    ParkRecord record;
+    init_park_record(&record, license_plate, &date);
+    record.spot = take_zone_spot(&park->zones, type);
+    if (record.spot == NO_SPOT) {
+        return GATE_NO_MEMORY;
+    }
+    // The record and its date are copied into a node of the park's pool
+    RecordNode *node = add_record(get_records_map(park), license_plate,
+                                    &record);
+    if (node == NULL) {
+        release_zone_spot(&park->zones, record.spot);
+        return GATE_NO_MEMORY;
     }
+    advance_park_date(parks, park, date);
+    watch_stay(&parks->overstay, node, park->id);
+    if (spot != NULL) {
+        *spot = record.spot;
+    }
+    set_vehicle_park(&parks->vehicles, plate, park->handle);
+    add_vehicle_visit(&parks->vehicles, plate, park->handle, &parks->names);
+
+    parks->free_spots[park->handle]--;
+    record_occupancy(&park->occupancy, saturate_minute(date_to_minutes(date)),
+                        0);
+    return GATE_OK;
+}
+
+int register_exit(Parks *parks, Park *park, const char *license_plate,
+                    Date date, ParkRecord **closed) {
+    uint64_t plate = pack_license_plate(license_plate);
+    if (vehicle_park(&parks->vehicles, plate) != park->handle) {
+        return GATE_INVALID_EXIT;
+    }
+    RecordNode *recordNode = get_records(get_records_map(park),
+                                            license_plate);
+    while (recordNode != NULL && recordNode->record.out_date != NULL) {
+        recordNode = recordNode->next;
+    }
+    if (recordNode == NULL) {
+        return GATE_INVALID_EXIT;
+    }
+    if (!is_park_date_current(parks, park, date)) {
+        return GATE_INVALID_DATE;
+    }
+    // The history row is taken before anything changes, so that a failed
+    // allocation leaves the stay open
+    if (!reserve_history(&park->history, park->history.count + 1)) {
+        return GATE_NO_MEMORY;
+    }
+    advance_park_date(parks, park, date);
+    parks->free_spots[park->handle]++;
+    unwatch_stay(&parks->overstay, recordNode);
+    release_zone_spot(&park->zones, recordNode->record.spot);
+    set_vehicle_park(&parks->vehicles, plate, NO_PARK);
+    int recorded = record_occupancy(&park->occupancy,
+                                    saturate_minute(date_to_minutes(date)), 1);
+
+    // Close the record and charge the stay
+    close_record(recordNode, date);
+    recordNode->record.cost_cents = calculate_cost(park,
+                                                recordNode->record.spot,
+                                                recordNode->record.in_date,
+                                                recordNode->record.out_date);
+    int percent = pass_percent(&parks->passes, plate);
+    if (percent != NO_PASS) {
+        recordNode->record.cost_cents = percent_of_cents(
+                                    recordNode->record.cost_cents, percent);
+        recordNode->record.pass = percent;
+    }
+    recorded = add_park_exit(parks, park, &recordNode->record) && recorded;
+    if (closed != NULL) {
+        *closed = &recordNode->record;
+    }
+    return recorded ? GATE_OK : GATE_NO_MEMORY;
+}
+
+// Reads the date and time arguments of an entry or exit command
+static Date parse_event_date(const char *date_arg, const char *time_arg) {
+    Date date = {0, 0, 0, 0, 0, 0, NULL};
+    sscanf(date_arg, "%d-%d-%d", &date.day, &date.month, &date.year);
+    sscanf(time_arg, "%d:%d", &date.hour, &date.minute);
+    return date;
 }
 
-void enter_parking(Parks *parks, char *args[]) {
+void enter_parking(Parks *parks, char *args[], int argc, FILE *out) {
     // First check if the park exists
     if(ParkAlreadyExists(parks, args[1]) == 0){
-        printf("%s: no such parking.\n", args[1]);
+        fprintf(out, "%s: no such parking.\n", args[1]);
         return;
     } 
     if(isValidLicensePlate(args[2]) == 0){
-        printf("%s: invalid licence plate.\n", args[2]);
+        fprintf(out, "%s: invalid licence plate.\n", args[2]);
         return;
     }
     Park *park = get_park(parks, args[1]);
-    if(isParkFull(park) == 1){
-        printf("%s: parking is full.\n", args[1]);
+    int type = ZONE_DEFAULT_TYPE;
+    if (argc > 5 && (type = find_zone_type(&park->zones, args[5])) == NO_ZONE) {
+        fprintf(out, "%s: no such zone type.\n", args[5]);
         return;
     }
-    if(isValidDate(args[3]) == 0 || isValidTime(args[4]) == 0){
-        printf("invalid date.\n");
-        return;
-    }
-    // Get the record for the license plate
-    int isInside = 0;
-    for(int i = 0; i < parks->capacity; i++){
-        if(parks->parks[i] != NULL){
-            RecordNode *recordNode = get_records(parks->parks[i]->records_map, 
-                                                    args[2]);
-            while (recordNode != NULL) {
-                if(recordNode->record.cost == -1.0){
-                    printf("%s: invalid vehicle entry.\n", args[2]);
-                    isInside = 1;
-                    break;
-                }
-                recordNode = recordNode->next;
-            }
-        }
+    if(isParkFull(parks, park) == 1 ||
+        !has_free_zone_spot(&park->zones, type)){
+        fprintf(out, "%s: parking is full.\n", args[1]);
+        return;
     }
-    if(isInside == 1){
+    if(isValidDate(args[3]) == 0 || isValidTime(args[4]) == 0){
+        fprintf(out, "invalid date.\n");
         return;
     }
-
-    int day, month, year;
-    sscanf(args[3], "%d-%d-%d", &day, &month, &year);
-    int hour, minute;
-    sscanf(args[4], "%d:%d", &hour, &minute);
-    Date *recordDate = createDate(day, month, year, hour, minute);
-    Date *parkDate = createDate(day, month, year, hour, minute);
-
-    if(park->lastDate == NULL){
-        park->lastDate = parkDate;
-    }else{
-        if(isAfter(*parkDate, *park->lastDate) == 0){
-            printf("invalid date.\n");
-            return;
-        }
-        // Delete the last date and create a new one
-        destroyDate(park->lastDate);
-        park->lastDate = parkDate;
+    int status = register_entry(parks, park, args[2],
+                                parse_event_date(args[3], args[4]), type,
+                                NULL);
+    if (status == GATE_INVALID_ENTRY) {
+        fprintf(out, "%s: invalid vehicle entry.\n", args[2]);
+    } else if (status == GATE_INVALID_DATE) {
+        fprintf(out, "invalid date.\n");
+    } else if (status == GATE_NO_MEMORY) {
+        fprintf(out, "Memory allocation failed.\n");
+    } else {
+        // Print Name of the park and available spots
+        fprintf(out, "%s %d\n", park->name, parks->free_spots[park->handle]);
     }
-
-    // Create a new record
-    ParkRecord *record = createParkRecord(args[2], recordDate);
-
-    // Add the record to the park
-    add_record(park->records_map, args[2], record);
-
-    // Update the available spots in the park
-    park->available_spots--;
-
-    // Print Name of the park and available spots
-    printf("%s %d\n", park->name, park->available_spots);
-
-    // Free the date
-    free(record);
 }
 
-void exit_parking(Parks *parks, char *args[]) {
+void exit_parking(Parks *parks, char *args[], FILE *out) {
     // First check if the park exists
     if(ParkAlreadyExists(parks, args[1]) == 0){
-        printf("%s: no such parking.\n", args[1]);
+        fprintf(out, "%s: no such parking.\n", args[1]);
         return;
     } 
     if(isValidLicensePlate(args[2]) == 0){
-        printf("%s: invalid licence plate.\n", args[2]);
+        fprintf(out, "%s: invalid licence plate.\n", args[2]);
         return;
     }
     Park *park = get_park(parks, args[1]);
     if(isValidDate(args[3]) == 0 || isValidTime(args[4]) == 0){
-        printf("invalid date.\n");
+        fprintf(out, "invalid date.\n");
         return;
     }
-    // Get the record for the license plate
-    int isInside = 0;
-
-    RecordNode *recordNode = get_records(park->records_map, args[2]);
-    while (recordNode != NULL) {
-        if(recordNode->record.cost == -1.0){
-            isInside = 1;
-            break;
-        }
-        recordNode = recordNode->next;
+    ParkRecord *record = NULL;
+    int status = register_exit(parks, park, args[2],
+                                parse_event_date(args[3], args[4]), &record);
+    if (status == GATE_INVALID_EXIT) {
+        fprintf(out, "%s: invalid vehicle exit.\n", args[2]);
+        return;
     }
-
-    if(isInside == 0){
-        printf("%s: invalid vehicle exit.\n", args[2]);
+    if (status == GATE_INVALID_DATE) {
+        fprintf(out, "invalid date.\n");
         return;
     }
-
-    int day, month, year;
-    sscanf(args[3], "%d-%d-%d", &day, &month, &year);
-    int hour, minute;
-    sscanf(args[4], "%d:%d", &hour, &minute);
-    Date *recordDate = createDate(day, month, year, hour, minute);
-    Date *parkDate = createDate(day, month, year, hour, minute);
-
-    if(park->lastDate == NULL){
-        park->lastDate = parkDate;
-    }else{
-        if(isAfter(*parkDate, *park->lastDate) == 0){
-            printf("invalid date.\n");
-            return;
-        }
-        // Delete the last date and create a new one
-        destroyDate(park->lastDate);
-        park->lastDate = parkDate;
+    if (status == GATE_NO_MEMORY) {
+        fprintf(out, "Memory allocation failed.\n");
+        return;
     }
 
-    park->available_spots++;
+    // Print values
+    fprintf(out, "%s ", record->license_plate);
+    printDate(*record->in_date, out);
+    fprintf(out, " ");
+    printTime(*record->in_date, out);
+    fprintf(out, " ");
+    printDate(*record->out_date, out);
+    fprintf(out, " ");
+    printTime(*record->out_date, out);
+    fprintf(out, " ");
+    print_cents(record->cost_cents, out);
+    fprintf(out, "\n");
+}
 
-    // Update the record with the exit date
-    recordNode->record.out_date = recordDate;
+// Prints the archived stays of a vehicle in a park, oldest first, following
+// the chain of its rows; rows chained but not archived yet are left out
+static void print_archived_stays(Park *park, const ArchivedVisit *visit,
+                                    FILE *out) {
+    const History *history = &park->history;
+    for (int i = visit->first_row; i != NO_ROW && i < park->archived_count;
+            i = park->archive_links[i]) {
+        fprintf(out, "%s ", park->name);
+        printDate(minutes_to_date(history->in_minutes[i]), out);
+        fprintf(out, " ");
+        printTime(minutes_to_date(history->in_minutes[i]), out);
+        fprintf(out, " ");
+        printDate(minutes_to_date(history->out_minutes[i]), out);
+        fprintf(out, " ");
+        printTime(minutes_to_date(history->out_minutes[i]), out);
+        fprintf(out, "\n");
+    }
+}
 
-    // Calculate the cost
-    recordNode->record.cost = calculate_cost(park, recordNode->record.in_date,
-    recordNode->record.out_date);
+// Handle of the park printed next by v: the first by name of the next
+// park with records and the next one with archived rows
+static int next_visited_park(Parks *parks, const VehicleVisit *visits,
+                                int count, int i,
+                                const ArchivedVisit *archived,
+                                int archived_count, int j) {
+    if (i == count) {
+        return archived[j].park;
+    }
+    if (j == archived_count) {
+        return visits[i].park;
+    }
+    const char **names = parks->names.names;
+    return strcmp(names[archived[j].park], names[visits[i].park]) < 0 ?
+            archived[j].park : visits[i].park;
+}
 
-    // Print values
-    printf("%s ", recordNode->record.license_plate);
-    printDate(*recordNode->record.in_date);
-    printf(" ");
-    printTime(*recordNode->record.in_date);
-    printf(" ");
-    printDate(*recordNode->record.out_date);
-    printf(" ");
-    printTime(*recordNode->record.out_date);
-    printf(" %.2f\n", recordNode->record.cost);
-}
-
-void print_vehicle_history(Parks *parks, char *args[]) {
+void print_vehicle_history(Parks *parks, char *args[], FILE *out) {
 // First check if the plate is valid
     if(isValidLicensePlate(args[1]) == 0){
-        printf("%s: invalid licence plate.\n", args[1]);
-        return;
-    }
-    // Check if the plate is in the records
-    int isInside = 0;
-    for(int i = 0; i < parks->capacity; i++){
-        if(parks->parks[i] != NULL){
-            RecordNode *recordNode = get_records(parks->parks[i]->records_map,
-                                                    args[1]);
-            while (recordNode != NULL) {
-                isInside = 1;
-                recordNode = recordNode->next;
-            }
-        }
+        fprintf(out, "%s: invalid licence plate.\n", args[1]);
+        return;
     }
-    if(isInside == 0){
-        printf("%s: no entries found in any parking.\n", args[1]);
+    // Only the parks the vehicle has records or archived rows in, both
+    // lists already in name order
+    uint64_t plate = pack_license_plate(args[1]);
+    int count;
+    const VehicleVisit *visits = vehicle_visits(&parks->vehicles, plate,
+                                                &count);
+    int archived_count;
+    const ArchivedVisit *archived = archived_visits(&parks->vehicles, plate,
+                                                    &archived_count);
+    if(count == 0 && archived_count == 0){
+        fprintf(out, "%s: no entries found in any parking.\n", args[1]);
         return;
     }
 
-    // Iterate through the parks
-    // Get the list of park names ordered alphabetically
-    int count;
-    char** park_names = get_park_names_ordered(parks, &count);
-    if (park_names != NULL) {
-        // Iterate through the sorted list of park names
-        for (int i = 0; i < count; i++) {
-            char* park_name = park_names[i];
-            // Find the park corresponding to the current name
-            Park* park = get_park(parks, park_name);
-            if (park != NULL) {
-                // Print records for the current park
-                RecordNode* recordNode = get_records(park->records_map,
-                                                        args[1]);
-                while (recordNode != NULL) {
-                    printf("%s ", park->name);
-                    printDate(*recordNode->record.in_date);
-                    printf(" ");
-                    printTime(*recordNode->record.in_date);
-                    if (recordNode->record.cost != -1.0) {
-                        printf(" ");
-                        printDate(*recordNode->record.out_date);
-                        printf(" ");
-                        printTime(*recordNode->record.out_date);
-                    }
-                    printf("\n");
-                    recordNode = recordNode->next;
-                }
+    int i = 0;
+    int j = 0;
+    while (i < count || j < archived_count) {
+        int handle = next_visited_park(parks, visits, count, i, archived,
+                                        archived_count, j);
+        Park* park = parks->parks[handle];
+        // Archived stays are older than the ones in the records
+        if (j < archived_count && archived[j].park == handle) {
+            print_archived_stays(park, &archived[j++], out);
+        }
+        if (i == count || visits[i].park != handle) {
+            continue;
+        }
+        i++;
+        // Print records for the current park
+        RecordNode* recordNode = get_records(get_records_map(park), args[1]);
+        while (recordNode != NULL) {
+            fprintf(out, "%s ", park->name);
+            printDate(*recordNode->record.in_date, out);
+            fprintf(out, " ");
+            printTime(*recordNode->record.in_date, out);
+            if (recordNode->record.out_date != NULL) {
+                fprintf(out, " ");
+                printDate(*recordNode->record.out_date, out);
+                fprintf(out, " ");
+                printTime(*recordNode->record.out_date, out);
             }
+            fprintf(out, "\n");
+            recordNode = recordNode->next;
         }
-        free_park_names(park_names, count); // Don't forget to free the memory
-    } else {
-        printf("Memory allocation failed.\n");
     }
 }
 
-void remove_park_command(Parks *parks, char *args[]) {
+void remove_park_command(Parks *parks, char *args[], FILE *out) {
     // First check if the park exists
     if(ParkAlreadyExists(parks, args[1]) == 0){
-        printf("%s: no such parking.\n", args[1]);
+        fprintf(out, "%s: no such parking.\n", args[1]);
         return;
     }
 
     // Get the park and destroy the records and the park
     remove_park(parks, args[1]);
 
-                    int count;
-    char** park_names = get_park_names_ordered(parks, &count);
-    if (park_names != NULL) {
-        // Iterate through the sorted list of park names
-        for (int i = 0; i < count; i++) {
-            char* park_name = park_names[i];
-            // Find the park corresponding to the current name
-            Park* park = get_park(parks, park_name);
-            if (park != NULL) {
-                printf("%s\n", park->name);
-                }
-            }
+    // Print the remaining parks in name order
+    for (int i = 0; i < parks->size; i++) {
+        fprintf(out, "%s\n", get_park_by_rank(parks, i)->name);
+    }
+}
+
+void snapshot_command(Parks *parks, char *args[], int argc, FILE *out) {
+    if (argc < 2) {
+        fprintf(out, "invalid snapshot.\n");
+        return;
+    }
+    if (!save_snapshot(parks, args[1])) {
+        fprintf(out, "%s: cannot write snapshot.\n", args[1]);
+    }
+}
+
+void compact_command(Parks *parks, char *args[], int argc, FILE *out) {
+    char *end = NULL;
+    long long horizon_days = argc > 1 ? strtoll(args[1], &end, 10) : -1;
+    if (argc < 2 || end == args[1] || *end != '\0' || horizon_days < 0) {
+        fprintf(out, "invalid horizon.\n");
+        return;
+    }
+
+    // The horizon is measured back from the latest event in the system
+    long long now = NO_MINUTE;
+    for (int i = 0; i < parks->size; i++) {
+        int handle = parks->by_id[i];
+        if (parks->last_minutes[handle] > now) {
+            now = parks->last_minutes[handle];
+        }
+    }
+    if (now < 0) {
+        return; // Nothing happened yet
+    }
+    // A horizon longer than the calendar archives nothing
+    int horizon = saturate_minute(horizon_days > now / MINUTES_PER_DAY ?
+                    LLONG_MIN : now - horizon_days * MINUTES_PER_DAY);
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL &&
+            !compact_park(parks, parks->parks[i], horizon)) {
+            fprintf(out, "Memory allocation failed.\n");
+            return;
+        }
+    }
+}
+
+// Reads the day (minutes / MINUTES_PER_DAY) of a DD-MM-YYYY argument
+static int parse_day(const char *arg) {
+    Date date = {0, 0, 0, 0, 0, 0, NULL};
+    sscanf(arg, "%d-%d-%d", &date.day, &date.month, &date.year);
+    return saturate_minute(date_to_minutes(date)) / MINUTES_PER_DAY;
+}
+
+void revenue_command(Parks *parks, char *args[], int argc, FILE *out) {
+    if (argc < 3) {
+        fprintf(out, "invalid date.\n");
+        return;
+    }
+    // With a park name, the dates are its second and third arguments
+    Park *park = NULL;
+    int first = 1;
+    if (argc > 3) {
+        park = get_park(parks, args[1]);
+        if (park == NULL) {
+            fprintf(out, "%s: no such parking.\n", args[1]);
+            return;
+        }
+        first = 2;
+    }
+    if (!isValidDate(args[first]) || !isValidDate(args[first + 1]) ||
+        parse_day(args[first + 1]) < parse_day(args[first])) {
+        fprintf(out, "invalid date.\n");
+        return;
+    }
+    int first_day = parse_day(args[first]);
+    int last_day = parse_day(args[first + 1]);
+    if (park != NULL) {
+        price_park(parks, park);
+        fprintf(out, "%s ", park->name);
+        print_cents(daily_revenue_between(&park->revenue, first_day,
+                                            last_day), out);
+    } else {
+        price_parks(parks);
+        print_cents(network_revenue_between(&parks->revenue, first_day,
+                                            last_day), out);
+    }
+    fprintf(out, "\n");
+}
+
+void occupancy_command(Parks *parks, char *args[], int argc, FILE *out) {
+    Park *park = argc > 1 ? get_park(parks, args[1]) : NULL;
+    if (park == NULL) {
+        fprintf(out, "%s: no such parking.\n", argc > 1 ? args[1] : "");
+        return;
+    }
+    if (argc < 4 || !isValidDate(args[2]) || !isValidTime(args[3])) {
+        fprintf(out, "invalid date.\n");
+        return;
+    }
+    Date date = {0, 0, 0, 0, 0, 0, NULL};
+    sscanf(args[2], "%d-%d-%d", &date.day, &date.month, &date.year);
+    sscanf(args[3], "%d:%d", &date.hour, &date.minute);
+    fprintf(out, "%s %d\n", park->name,
+            occupancy_at(&park->occupancy,
+                            saturate_minute(date_to_minutes(date))));
+}
+
+void occupancy_hours_command(Parks *parks, char *args[], int argc, FILE *out) {
+    Park *park = argc > 1 ? get_park(parks, args[1]) : NULL;
+    if (park == NULL) {
+        fprintf(out, "%s: no such parking.\n", argc > 1 ? args[1] : "");
+        return;
+    }
+    if (argc < 3 || !isValidDate(args[2])) {
+        fprintf(out, "invalid date.\n");
+        return;
+    }
+    OccupancyHour hours[OCCUPANCY_HOURS];
+    occupancy_hours(&park->occupancy, parse_day(args[2]) * MINUTES_PER_DAY,
+                    hours);
+    for (int h = 0; h < OCCUPANCY_HOURS; h++) {
+        fprintf(out, "%02d:00 %d %.2f\n", h, hours[h].peak, hours[h].mean);
+    }
+}
+
+void leaderboard_command(Parks *parks, char *args[], int argc, FILE *out) {
+    const Leaderboards *boards = get_leaderboards(parks);
+    const TopK *board = NULL;
+    if (argc > 1 && strcmp(args[1], "spend") == 0) {
+        board = &boards->spenders;
+    } else if (argc > 1 && strcmp(args[1], "stay") == 0) {
+        board = &boards->stays;
+    } else if (argc > 1 && strcmp(args[1], "lots") == 0) {
+        board = &boards->lots;
+    } else {
+        fprintf(out, "invalid leaderboard.\n");
+        return;
+    }
+    int k = argc > 2 ? atoi(args[2]) : TOPK_DEFAULT;
+    if (k <= 0 || k > TOPK_CAPACITY) {
+        fprintf(out, "invalid size.\n");
+        return;
+    }
+    TopKEntry entries[TOPK_CAPACITY];
+    int count = topk_sorted(board, entries, k);
+    char license_plate[LICENSE_PLATE_SIZE];
+    for (int i = 0; i < count; i++) {
+        if (board == &boards->lots) {
+            Park *park = get_park_by_id(parks, (int)entries[i].key);
+            fprintf(out, "%s %lld\n", park->name, entries[i].value);
+            continue;
         }
-        free_park_names(park_names, count); // Don't forget to free the memory
+        unpack_license_plate(entries[i].key, license_plate);
+        fprintf(out, "%s ", license_plate);
+        if (board == &boards->spenders) {
+            print_cents(entries[i].value, out);
+            fprintf(out, "\n");
+        } else {
+            fprintf(out, "%lld\n", entries[i].value);
+        }
+    }
 }
 
-void calculate_cost_command(Parks *parks, char *args[], int argc) {
-    if (argc > 2) {
+void calculate_cost_command(Parks *parks, char *args[], int argc, FILE *out) {
+    if (argc < 2) {
+        print_network_billing(parks, out);
+    } else if (argc > 2) {
         // First check if the park exists
         if(ParkAlreadyExists(parks, args[1]) == 0){
-            printf("%s: no such parking.\n", args[1]);
+            fprintf(out, "%s: no such parking.\n", args[1]);
             return;
         } 
         Park *park = get_park(parks, args[1]);
         if(isValidDate(args[2]) == 0){
-            printf("invalid date.\n");
+            fprintf(out, "invalid date.\n");
             return;
         }
+        price_park(parks, park);
         int day, month, year;
         sscanf(args[2], "%d-%d-%d", &day, &month, &year);
-        int hour, minute;
-        sscanf(args[4], "%d:%d", &hour, &minute);
-        // Allocate memory for a Date structure
-        Date *recordDate = createDate(day, month, year, hour, minute);
+        Date recordDate = {year, month, day, 0, 0, 0, NULL};
 
-
-        get_cost_records_for_date(park, recordDate);
-        // Free the date
-        destroyDate(recordDate);
+        get_cost_records_for_date(park, &recordDate, out);
     } else {
         // First check if the park exists
         if(ParkAlreadyExists(parks, args[1]) == 0){
-            printf("%s: no such parking.\n", args[1]);
+            fprintf(out, "%s: no such parking.\n", args[1]);
             return;
         }
         Park *park = get_park(parks, args[1]);
+        price_park(parks, park);
+
+        get_cost_records_per_park(park, out);
+    }
+}
+
+void tariff_command(Parks *parks, char *args[], int argc, FILE *out) {
+    Park *park = argc > 1 ? get_park(parks, args[1]) : NULL;
+    if (park == NULL) {
+        fprintf(out, "%s: no such parking.\n", argc > 1 ? args[1] : "");
+        return;
+    }
+    if (argc < 4 || !isValidDate(args[2]) || !isValidTime(args[3])) {
+        fprintf(out, "invalid date.\n");
+        return;
+    }
+    Tariff tariff;
+    tariff.from_minute = saturate_minute(date_to_minutes(
+                                parse_event_date(args[2], args[3])));
+    tariff.price_15 = argc > 4 ? atof(args[4]) : 0;
+    tariff.price_15_1h = argc > 5 ? atof(args[5]) : 0;
+    tariff.price_1h = argc > 6 ? atof(args[6]) : 0;
+    if (!isCostValid(tariff.price_15, tariff.price_15_1h, tariff.price_1h)) {
+        fprintf(out, "invalid cost.\n");
+        return;
+    }
+    if (!set_park_tariff(park, &tariff)) {
+        fprintf(out, "Memory allocation failed.\n");
+    }
+}
+
+// Prints the zones of a park in spot order, with their free spots
+static void print_park_zones(Park *park, FILE *out) {
+    const ZoneTree *tree = &park->zones;
+    // The first pool is the park's own
+    for (int p = 1; p < tree->count; p++) {
+        int zone = tree->pools[p].zone;
+        fprintf(out, "%s %s %d %d\n", tree->zones[zone].name,
+                tree->zones[zone].type, tree->zones[zone].capacity,
+                zone_free_spots(tree, zone));
+    }
+}
+
+void zone_command(Parks *parks, char *args[], int argc, FILE *out) {
+    Park *park = argc > 1 ? get_park(parks, args[1]) : NULL;
+    if (park == NULL) {
+        fprintf(out, "%s: no such parking.\n", argc > 1 ? args[1] : "");
+        return;
+    }
+    if (argc == 2) {
+        print_park_zones(park, out);
+        return;
+    }
+    if (argc < 5 || args[2][0] == '\0' ||
+        strlen(args[2]) >= ZONE_NAME_SIZE ||
+        strlen(args[3]) >= ZONE_NAME_SIZE) {
+        fprintf(out, "invalid zone.\n");
+        return;
+    }
+    Zone zone;
+    memset(&zone, 0, sizeof(zone));
+    strcpy(zone.name, args[2]);
+    strcpy(zone.type, args[3]);
+    zone.capacity = atoi(args[4]);
+    if (argc > 5) {
+        zone.has_tariff = 1;
+        zone.tariff.from_minute = TARIFF_ALWAYS;
+        zone.tariff.price_15 = atof(args[5]);
+        zone.tariff.price_15_1h = argc > 6 ? atof(args[6]) : 0;
+        zone.tariff.price_1h = argc > 7 ? atof(args[7]) : 0;
+        if (!isCostValid(zone.tariff.price_15, zone.tariff.price_15_1h,
+                            zone.tariff.price_1h)) {
+            fprintf(out, "invalid cost.\n");
+            return;
+        }
+    }
+    // Adding a zone numbers the spots again
+    if (parks->free_spots[park->handle] != park->capacity) {
+        fprintf(out, "%s: parking is not empty.\n", park->name);
+        return;
+    }
+    int status = add_park_zone(park, &zone);
+    if (status == ZONE_EXISTS) {
+        fprintf(out, "%s: zone already exists.\n", args[2]);
+    } else if (status == ZONE_NO_PARENT) {
+        fprintf(out, "%s: no such zone.\n", args[2]);
+    } else if (status == ZONE_INVALID_CAPACITY) {
+        fprintf(out, "%s: invalid capacity.\n", args[4]);
+    } else if (status == ZONE_TOO_MANY_TYPES) {
+        fprintf(out, "too many zone types.\n");
+    } else if (status == ZONE_NO_MEMORY) {
+        fprintf(out, "Memory allocation failed.\n");
+    }
+}
+
+// Starts the overstay timers of the vehicles inside every park
+static int watch_open_stays(Parks *parks) {
+    for (int i = 0; i < parks->size; i++) {
+        Park *park = parks->parks[parks->by_id[i]];
+        if (parks->free_spots[park->handle] == park->capacity) {
+            continue; // No vehicle inside
+        }
+        HashMap *map = get_records_map(park);
+        for (int b = 0; b < map->size; b++) {
+            for (HashNode *node = map->buckets[b]; node != NULL;
+                    node = node->next) {
+                for (RecordNode *rec = node->records; rec != NULL;
+                        rec = rec->next) {
+                    if (rec->record.out_date == NULL &&
+                        !watch_stay(&parks->overstay, rec, park->id)) {
+                        return 0;
+                    }
+                }
+            }
+        }
+    }
+    return 1;
+}
 
-        get_cost_records_per_park(park);
+// Reads a whole number argument from 0 to a maximum; returns 1 if it is one
+static int parse_count(const char *arg, long maximum, int *count) {
+    char *end = NULL;
+    errno = 0;
+    long value = strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || errno != 0 || value < 0 ||
+        value > maximum) {
+        return 0;
+    }
+    *count = (int)value;
+    return 1;
+}
+
+void overstay_command(Parks *parks, char *args[], int argc, FILE *out) {
+    OverstayMonitor *monitor = &parks->overstay;
+    if (argc > 1) {
+        int threshold;
+        if (!parse_count(args[1], INT_MAX, &threshold)) {
+            fprintf(out, "invalid threshold.\n");
+            return;
+        }
+        set_overstay_threshold(monitor, threshold);
+        if (threshold != OVERSTAY_OFF && !watch_open_stays(parks)) {
+            fprintf(out, "Memory allocation failed.\n");
+        }
+        return;
+    }
+    char license_plate[LICENSE_PLATE_SIZE];
+    for (int i = 0; i < monitor->alert_count; i++) {
+        const OverstayAlert *alert = overstay_alert(monitor, i);
+        Park *park = get_park_by_id(parks, alert->park_id);
+        if (park == NULL) {
+            continue; // The park was removed since
+        }
+        unpack_license_plate(alert->plate, license_plate);
+        Date in_date = minutes_to_date(alert->in_minute);
+        fprintf(out, "%s %s ", park->name, license_plate);
+        printDate(in_date, out);
+        fprintf(out, " ");
+        printTime(in_date, out);
+        fprintf(out, "\n");
+    }
+    if (monitor->dropped > 0) {
+        fprintf(out, "%d older alerts dropped.\n", monitor->dropped);
+    }
+    clear_overstay_alerts(monitor);
+}
+
+void pass_command(Parks *parks, char *args[], int argc, FILE *out) {
+    PassRegistry *registry = &parks->passes;
+    if (argc > 1) {
+        if (!load_passes(registry, args[1])) {
+            fprintf(out, registry->loading ? "pass file still loading.\n" :
+                    "Memory allocation failed.\n");
+        }
+        return;
+    }
+    finish_pass_load(registry, 0);
+    if (registry->failed_path != NULL) {
+        fprintf(out, "%s: invalid pass file.\n", registry->failed_path);
+        free(registry->failed_path);
+        registry->failed_path = NULL;
+    }
+    fprintf(out, "%d passes%s.\n", registry->current != NULL ?
+            registry->current->count : 0,
+            registry->loading ? ", loading" : "");
+}
+
+void dwell_command(Parks *parks, char *args[], int argc, FILE *out) {
+    if (argc < 3 || !isValidDate(args[argc - 2]) ||
+        !isValidDate(args[argc - 1]) ||
+        parse_day(args[argc - 1]) < parse_day(args[argc - 2])) {
+        fprintf(out, "invalid date.\n");
+        return;
+    }
+    int first_day = parse_day(args[argc - 2]);
+    int last_day = parse_day(args[argc - 1]);
+    for (int i = 1; i < argc - 2; i++) {
+        if (get_park(parks, args[i]) == NULL) {
+            fprintf(out, "%s: no such parking.\n", args[i]);
+            return;
+        }
+    }
+    DwellHistogram histogram;
+    clear_dwell_histogram(&histogram);
+    if (argc > 3) {
+        for (int i = 1; i < argc - 2; i++) {
+            merge_daily_dwell(&get_park(parks, args[i])->dwell, first_day,
+                                last_day, &histogram);
+        }
+    } else {
+        for (int i = 0; i < parks->size; i++) {
+            merge_daily_dwell(&parks->parks[parks->by_id[i]]->dwell,
+                                first_day, last_day, &histogram);
+        }
+    }
+    fprintf(out, "%lld stays p50 %d p95 %d p99 %d\n",
+            (long long)histogram.total, dwell_percentile(&histogram, 50),
+            dwell_percentile(&histogram, 95),
+            dwell_percentile(&histogram, 99));
+}
+
+void memory_command(Parks *parks, char *args[], int argc, FILE *out) {
+    MemoryReport report;
+    clear_memory_report(&report);
+    if (argc > 1) {
+        Park *park = get_park(parks, args[1]);
+        if (park == NULL) {
+            fprintf(out, "%s: no such parking.\n", args[1]);
+            return;
+        }
+        measure_park_memory(park, &report);
+    } else {
+        measure_network_memory(parks, &report);
+        for (int i = 0; i < parks->size; i++) {
+            measure_park_memory(parks->parks[parks->by_id[i]], &report);
+        }
+    }
+    int order[MEMORY_STRUCTURES];
+    sort_memory_report(&report, order);
+    size_t total = 0;
+    for (int i = 0; i < MEMORY_STRUCTURES; i++) {
+        const MemoryUsage *usage = &report.usage[order[i]];
+        if (usage->bytes > 0 || usage->objects > 0) {
+            fprintf(out, "%s %zu %zu\n", memory_structure_name(order[i]),
+                    usage->bytes, usage->objects);
+            total += usage->bytes;
+        }
+    }
+    fprintf(out, "total %zu\n", total);
+}
+
+void reserve_command(Parks *parks, char *args[], int argc, FILE *out) {
+    if (argc < 4) {
+        fprintf(out, "invalid reservation.\n");
+        return;
+    }
+    Park *park = get_park(parks, args[1]);
+    if (park == NULL) {
+        fprintf(out, "%s: no such parking.\n", args[1]);
+        return;
+    }
+    int stays;
+    int days;
+    if (!parse_count(args[2], MAX_RESERVATION, &stays) ||
+        !parse_count(args[3], MAX_RESERVATION, &days)) {
+        fprintf(out, "invalid reservation.\n");
+        return;
+    }
+    if (!reserve_park_stays(parks, park, stays, days)) {
+        fprintf(out, "Memory allocation failed.\n");
+    }
+}
+
+int execute_command(Parks *parks, char *args[], int nargs, FILE *out) {
+    if (nargs == 0) {
+        return 1;
+    }
+    if (strcmp(args[0], "q") == 0) {
+        return 0;
+    } else if (strcmp(args[0], "p") == 0) {
+        add_park_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "e") == 0) {
+        enter_parking(parks, args, nargs, out);
+    } else if (strcmp(args[0], "s") == 0) {
+        exit_parking(parks, args, out);
+    } else if (strcmp(args[0], "v") == 0) {
+        print_vehicle_history(parks, args, out);
+    } else if (strcmp(args[0], "f") == 0) {
+        calculate_cost_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "r") == 0) {
+        remove_park_command(parks, args, out);
+    } else if (strcmp(args[0], "w") == 0) {
+        snapshot_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "c") == 0) {
+        compact_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "g") == 0) {
+        revenue_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "o") == 0) {
+        occupancy_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "h") == 0) {
+        occupancy_hours_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "t") == 0) {
+        leaderboard_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "u") == 0) {
+        tariff_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "z") == 0) {
+        zone_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "l") == 0) {
+        overstay_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "m") == 0) {
+        pass_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "d") == 0) {
+        dwell_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "b") == 0) {
+        memory_command(parks, args, nargs, out);
+    } else if (strcmp(args[0], "k") == 0) {
+        reserve_command(parks, args, nargs, out);
+    } else {
+        fprintf(out, "Unknown command: %s\n", args[0]);
     }
+    return 1;
 }
@@ -1,15 +1,29 @@
 #ifndef ENGINE_H
 #define ENGINE_H
+#include <stdio.h>
 #include "Invariants.h"
 #include "Parks.h"
 
+// Outcomes of an entry or an exit (see register_entry and register_exit)
+#define GATE_OK 0
+#define GATE_NO_SUCH_PARKING 1
+#define GATE_INVALID_PLATE 2
+#define GATE_PARKING_FULL 3
+#define GATE_INVALID_DATE 4
+#define GATE_INVALID_ENTRY 5
+#define GATE_INVALID_EXIT 6
+#define GATE_NO_MEMORY 9        // 7 and 8 are frame statuses (see Protocol.h)
+// Largest number of stays or days a reservation may ask for
+#define MAX_RESERVATION 1048576
+
 /**
  * Prints all the parks in the given Parks structure.
  *
  * @param parks A pointer to the Parks structure containing the parks to be
  * printed.
+ * @param out The stream the output is printed to.
  */
-void print_all_parks(Parks *parks);
+void print_all_parks(Parks *parks, FILE *out);
 
 /**
  * Adds a park command to the Parks data structure.
@@ -21,18 +35,60 @@ void print_all_parks(Parks *parks);
  * @param args An array of strings representing the arguments for the park
  * command.
  * @param argc The number of arguments in the args array.
+ * @param out The stream the output is printed to.
+ */
+void add_park_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Registers the entry of a vehicle in a park, after the park, license plate
+ * and date have been validated.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param park The park the vehicle enters.
+ * @param license_plate The (valid) license plate of the vehicle.
+ * @param date The (valid) date and time of the entry.
+ * @param type The zone type of the spot wanted (see find_zone_type).
+ * @param spot Set to the spot given to the vehicle on success, if not NULL.
+ * @return GATE_OK, or GATE_PARKING_FULL if no spot of the type is free,
+ * GATE_INVALID_ENTRY if the vehicle is already inside a park,
+ * GATE_INVALID_DATE if the date is before the last event of the park or
+ * GATE_NO_MEMORY if memory allocation failed, leaving the park as it was.
+ */
+int register_entry(Parks *parks, Park *park, const char *license_plate,
+                    Date date, int type, int *spot);
+
+/**
+ * Registers the exit of a vehicle from a park and charges its stay, after
+ * the park, license plate and date have been validated.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param park The park the vehicle leaves.
+ * @param license_plate The (valid) license plate of the vehicle.
+ * @param date The (valid) date and time of the exit.
+ * @param closed Set to the closed record on success, if not NULL.
+ * @return GATE_OK, or GATE_INVALID_EXIT if the vehicle is not inside the
+ * park, GATE_INVALID_DATE if the date is before the last event of the park
+ * or GATE_NO_MEMORY if memory allocation failed: before the history row of
+ * the stay could be taken, leaving the stay open, or afterwards, leaving
+ * the stay closed but missing from some of the indexes.
  */
-void add_park_command(Parks *parks, char *args[], int argc);
+int register_exit(Parks *parks, Park *park, const char *license_plate,
+                    Date date, ParkRecord **closed);
 
 /**
  * Enters a vehicle into the parking system.
  *
+ * Input: e <park> <plate> <date> <time> [<type>]. The vehicle takes the
+ * lowest free spot of the given zone type, by default ZONE_DEFAULT_TYPE_NAME.
+ *
  * @param parks The pointer to the Parks struct representing the parking
  * system.
  * @param args An array of strings representing the arguments for entering the
  * parking.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
  */
-void enter_parking(Parks *parks, char *args[]);
+void enter_parking(Parks *parks, char *args[], int argc, FILE *out);
 
 /**
  * @brief Exits a parking spot.
@@ -44,32 +100,256 @@ void enter_parking(Parks *parks, char *args[]);
  *
  * @param parks The array of `Parks` structures representing the parking spots.
  * @param args The string array containing any additional arguments.
+ * @param out The stream the output is printed to.
  */
-void exit_parking(Parks *parks, char *args[]);
+void exit_parking(Parks *parks, char *args[], FILE *out);
 
 /**
  * Prints the vehicle history for a given park.
  *
  * @param parks The pointer to the Parks struct.
  * @param args The array of arguments.
+ * @param out The stream the output is printed to.
  */
-void print_vehicle_history(Parks *parks, char *args[]);
+void print_vehicle_history(Parks *parks, char *args[], FILE *out);
 
 /**
  * Removes a park from the list of parks.
  *
  * @param parks The pointer to the Parks struct.
  * @param args The array of arguments passed to the command.
+ * @param out The stream the output is printed to.
  */
-void remove_park_command(Parks *parks, char *args[]);
+void remove_park_command(Parks *parks, char *args[], FILE *out);
 
 /**
  * Calculates the cost of a command for the given parks.
  *
+ * Without a park, prints the daily revenue of every park (see
+ * print_network_billing).
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void calculate_cost_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Writes a snapshot of the whole parking system to a file.
+ *
+ * The snapshot can later be given to the program at startup to restore the
+ * parks and their records without replaying every command.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments (the file path).
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void snapshot_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Moves the closed records older than a horizon into each park's history.
+ *
+ * The horizon is given in days and measured back from the latest event in
+ * the system; archived records are still listed by the v and f commands.
+ * Vehicles left outside every park with only archived records leave the
+ * vehicle index. A horizon that is not a whole number of days, or is
+ * negative, is invalid.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments (the horizon in days).
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void compact_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Prints the revenue of a park, or of every park, between two dates.
+ *
+ * Input: g [<park>] <date> <date>. Both dates are included and the answer
+ * comes from the revenue indexes in O(log days), whatever the number of
+ * records.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void revenue_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Prints the number of vehicles inside a park at a moment.
+ *
+ * Input: o <park> <date> <time>. Every event of that minute is counted and
+ * the answer comes from the park's occupancy timeline in O(log events).
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void occupancy_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Prints the peak and the time weighted mean occupancy of a park for each
+ * hour of a day.
+ *
+ * Input: h <park> <date>. One line per hour, as HH:00 <peak> <mean>.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void occupancy_hours_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Prints a live leaderboard, from the first place down.
+ *
+ * Input: t spend|stay|lots [<k>]. spend lists the license plates that spent
+ * the most (estimated with a count-min sketch), stay the license plates with
+ * the longest single stay, in minutes, and lots the parks with the most
+ * exits. At most TOPK_CAPACITY places are kept.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void leaderboard_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Changes the tariff of a park from a given date and time on.
+ *
+ * Input: u <park> <date> <time> <price_15> <price_15_1h> <price_1h>. Stays
+ * that entered from then on, closed ones included, are charged by the new
+ * prices. Closed stays are only re-priced when a later f, g or t command
+ * needs their cost.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void tariff_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Adds a zone to a park, or lists its zones.
+ *
+ * Input: z <park> <zone> <type> <capacity> [<price_15> <price_15_1h>
+ * <price_1h>]. A zone path "P1/ev" puts zone ev inside zone P1; the zone
+ * takes its spots from the one enclosing it, and is charged by its own
+ * prices if given, or else by those of its enclosing zone or park. Zones
+ * can only be added while the park is empty.
+ *
+ * Input: z <park>. Lists the zones in spot order, one "<zone> <type>
+ * <capacity> <free>" line each, the free spots of subzones included.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void zone_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Sets the overstay threshold, or prints the overstay alerts.
+ *
+ * Input: l <minutes>. From then on, an alert is raised for each vehicle
+ * still inside a park <minutes> after it entered, by the clock of the
+ * latest entry or exit of the network; the vehicles already inside are
+ * watched too, and 0 turns the monitoring off. Anything but a whole
+ * number from 0 to INT_MAX prints "invalid threshold.".
+ *
+ * Input: l. Prints the alerts raised since the last l, oldest first, one
+ * "<park> <plate> <date> <time>" line each with the entry of the stay. Only
+ * the last OVERSTAY_LOG_SIZE alerts are kept.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void overstay_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Loads the monthly passes and contracts, or prints their status.
+ *
+ * Input: m <file>. Starts reading the file in the background, one
+ * "<plate> <percent>" line per pass; the exits charge <percent> of the
+ * regular price once the file is loaded, and the stays they close are not
+ * priced again when the tariffs change. The file replaces the passes in
+ * force, unless a line is invalid.
+ *
+ * Input: m. Prints "<file>: invalid pass file." if the last file could not
+ * be loaded, then "<n> passes." with ", loading" before the dot while a
+ * file is still being read.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void pass_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Prints percentiles of the length of the stays that ended between two
+ * dates, in the given parks or in every park.
+ *
+ * Input: d [<park> ...] <date> <date>. Both dates are included; the daily
+ * histograms of the parks are merged and "<n> stays p50 <m> p95 <m> p99
+ * <m>" is printed, in minutes. A percentile is the longest length of its
+ * histogram bucket, above the exact one by less than 1 / DWELL_SUB_BUCKETS.
+ *
  * @param parks The pointer to the Parks struct.
  * @param args The array of command arguments.
  * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void dwell_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Prints the live memory of each structure, largest first.
+ *
+ * Input: b [<park>]. One "<structure> <bytes> <objects>" line per structure
+ * in use, of the given park or of every park and the structures they
+ * share, then "total <bytes>". The sizes are those of the blocks the
+ * structures allocated, used or not.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void memory_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Makes room in a park for the stays to come, so that their entries and
+ * exits, and the billing reports, do not touch the heap (see
+ * reserve_park_stays).
+ *
+ * Input: k <park> <stays> <days>, the number of stays and the number of
+ * new days they end on, each a whole number from 0 to MAX_RESERVATION.
+ * Prints nothing on success, "invalid reservation." for bad counts.
+ * Without a reservation the structures grow by doubling as they fill.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The array of command arguments.
+ * @param argc The number of command arguments.
+ * @param out The stream the output is printed to.
+ */
+void reserve_command(Parks *parks, char *args[], int argc, FILE *out);
+
+/**
+ * Runs one tokenized text command.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param args The command and its arguments.
+ * @param nargs The number of entries in args.
+ * @param out The stream the output is printed to.
+ * @return 0 if the command asks to quit, 1 otherwise.
  */
-void calculate_cost_command(Parks *parks, char *args[], int argc);
+int execute_command(Parks *parks, char *args[], int nargs, FILE *out);
 
 #endif /* ENGINE_H */
@@ -0,0 +1,156 @@
+/**
+ * File containing the implementation of the columnar archive of closed park
+ * records.
+ * @file History.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "History.h"
+
+void init_history(History *history) {
+    history->plates = NULL;
+    history->in_minutes = NULL;
+    history->out_minutes = NULL;
+    history->cost_cents = NULL;
+    history->tariff_ids = NULL;
+    history->count = 0;
+    history->capacity = 0;
+}
+
+void borrow_history(History *history, const void *base, int count) {
+    // The snapshot keeps the columns back to back, plates first so that
+    // every column stays aligned
+    history->plates = (uint64_t *)base;
+    history->cost_cents = (long long *)(history->plates + count);
+    history->in_minutes = (int *)(history->cost_cents + count);
+    history->out_minutes = history->in_minutes + count;
+    history->tariff_ids = history->out_minutes + count;
+    history->count = count;
+    history->capacity = 0;
+}
+
+// Moves every column to a new block of the given capacity
+static int grow_history(History *history, int capacity) {
+    uint64_t *plates = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+    int *in_minutes = (int *)malloc(capacity * sizeof(int));
+    int *out_minutes = (int *)malloc(capacity * sizeof(int));
+    long long *cost_cents = (long long *)malloc(capacity *
+                                                sizeof(long long));
+    int *tariff_ids = (int *)malloc(capacity * sizeof(int));
+    if (plates == NULL || in_minutes == NULL || out_minutes == NULL ||
+        cost_cents == NULL || tariff_ids == NULL) {
+        free(plates);
+        free(in_minutes);
+        free(out_minutes);
+        free(cost_cents);
+        free(tariff_ids);
+        return 0; // Memory allocation failed
+    }
+    if (history->count > 0) {
+        memcpy(plates, history->plates, history->count * sizeof(uint64_t));
+        memcpy(in_minutes, history->in_minutes, history->count * sizeof(int));
+        memcpy(out_minutes, history->out_minutes,
+                history->count * sizeof(int));
+        memcpy(cost_cents, history->cost_cents,
+                history->count * sizeof(long long));
+        memcpy(tariff_ids, history->tariff_ids, history->count * sizeof(int));
+    }
+    destroy_history(history);
+    history->plates = plates;
+    history->in_minutes = in_minutes;
+    history->out_minutes = out_minutes;
+    history->cost_cents = cost_cents;
+    history->tariff_ids = tariff_ids;
+    history->capacity = capacity;
+    return 1;
+}
+
+int reserve_history(History *history, int rows) {
+    if (rows <= history->capacity) {
+        return 1;
+    }
+    int capacity = history->count * 2;
+    if (capacity < HISTORY_INITIAL_CAPACITY) {
+        capacity = HISTORY_INITIAL_CAPACITY;
+    }
+    if (capacity < rows) {
+        capacity = rows;
+    }
+    int count = history->count;
+    if (!grow_history(history, capacity)) {
+        return 0;
+    }
+    history->count = count;
+    return 1;
+}
+
+int own_history(History *history) {
+    return history->count == 0 || reserve_history(history, history->count);
+}
+
+int append_history(History *history, uint64_t plate, int in_minute,
+                    int out_minute, long long cost_cents, int tariff_id) {
+    if (!reserve_history(history, history->count + 1)) {
+        return 0;
+    }
+    int row = history->count++;
+    history->plates[row] = plate;
+    history->in_minutes[row] = in_minute;
+    history->out_minutes[row] = out_minute;
+    history->cost_cents[row] = cost_cents;
+    history->tariff_ids[row] = tariff_id;
+    return 1;
+}
+
+int history_lower_bound(const History *history, int minute) {
+    int low = 0;
+    int high = history->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (history->out_minutes[middle] < minute) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void destroy_history(History *history) {
+    // Borrowed columns belong to the snapshot mapping
+    if (history->capacity > 0) {
+        free(history->plates);
+        free(history->in_minutes);
+        free(history->out_minutes);
+        free(history->cost_cents);
+        free(history->tariff_ids);
+    }
+    init_history(history);
+}
+
+long long cost_to_cents(double cost) {
+    double cents = cost * CENTS;
+    return (long long)(cents < 0 ? cents - 0.5 : cents + 0.5);
+}
+
+long long percent_of_cents(long long cents, int percent) {
+    long long part = cents * percent;
+    return (part < 0 ? part - 50 : part + 50) / 100;
+}
+
+int format_cents(char *buffer, size_t size, long long cents) {
+    // The magnitude is unsigned so that even LLONG_MIN has one
+    unsigned long long magnitude = cents < 0 ?
+                                    0ULL - (unsigned long long)cents :
+                                    (unsigned long long)cents;
+    return snprintf(buffer, size, "%s%llu.%02llu", cents < 0 ? "-" : "",
+                    magnitude / CENTS, magnitude % CENTS);
+}
+
+void print_cents(long long cents, FILE *out) {
+    char text[CENTS_TEXT_SIZE];
+    format_cents(text, sizeof(text), cents);
+    fputs(text, out);
+}
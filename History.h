@@ -0,0 +1,139 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Initial number of rows allocated for a history
+#define HISTORY_INITIAL_CAPACITY 64
+// Number of cents in a unit of currency
+#define CENTS 100
+// Size of a buffer holding any amount of cents written by format_cents
+#define CENTS_TEXT_SIZE 32
+
+/**
+ * @struct History
+ * @brief Compact, append-only store of the closed records of a park.
+ *
+ * Each column is a plain array and row i of every column describes the same
+ * record. Dates are stored as minutes (see date_to_minutes) and costs in
+ * cents. Rows are appended as vehicles leave, so they are sorted by exit.
+ */
+typedef struct {
+    uint64_t *plates;       // Packed license plates (pack_license_plate)
+    long long *cost_cents;
+    int *in_minutes;
+    int *out_minutes;
+    int *tariff_ids;        // Tariff version that priced each cost
+    int count;
+    int capacity;           // 0 while the columns are borrowed from a snapshot
+} History;
+
+/**
+ * Initializes an empty history.
+ *
+ * @param history The history to be initialized.
+ */
+void init_history(History *history);
+
+/**
+ * Makes a history read the columns of a mapped snapshot.
+ *
+ * The columns are only copied to the heap when a row is first appended.
+ *
+ * @param history The (empty) history.
+ * @param base Start of the columns: plates, then costs, entry minutes, exit
+ * minutes and tariff ids, each with count elements.
+ * @param count The number of rows.
+ */
+void borrow_history(History *history, const void *base, int count);
+
+/**
+ * Appends a closed record to a history.
+ *
+ * @param history The history.
+ * @param plate The packed license plate of the vehicle.
+ * @param in_minute The minute the vehicle entered.
+ * @param out_minute The minute the vehicle left.
+ * @param cost_cents The cost of the stay, in cents.
+ * @param tariff_id The version of the tariff that priced the stay.
+ * @return 1 if the row was appended, 0 if memory allocation failed.
+ */
+int append_history(History *history, uint64_t plate, int in_minute,
+                    int out_minute, long long cost_cents, int tariff_id);
+
+/**
+ * Makes room for at least a number of rows, so that appending up to them
+ * does not touch the heap; borrowed columns are copied to the heap.
+ *
+ * @param history The history.
+ * @param rows The number of rows, those already in the history included.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_history(History *history, int rows);
+
+/**
+ * Copies the columns of a history borrowed from a snapshot to the heap, so
+ * its rows can be changed.
+ *
+ * @param history The history.
+ * @return 1 if the columns are owned by the history, 0 if memory
+ * allocation failed.
+ */
+int own_history(History *history);
+
+/**
+ * Finds the first row whose exit is not before the given minute.
+ *
+ * @param history The history.
+ * @param minute The minute (see date_to_minutes).
+ * @return The index of the row, or the number of rows if there is none.
+ */
+int history_lower_bound(const History *history, int minute);
+
+/**
+ * Frees the columns of a history.
+ *
+ * @param history The history to be destroyed.
+ */
+void destroy_history(History *history);
+
+/**
+ * Converts a cost into a whole number of cents.
+ *
+ * @param cost The cost.
+ * @return The cost in cents, rounded to the nearest cent, halves away from
+ * zero.
+ */
+long long cost_to_cents(double cost);
+
+/**
+ * Takes a percentage of an amount of cents.
+ *
+ * @param cents The amount in cents.
+ * @param percent The percentage, from 0 to 100.
+ * @return The part of the amount, rounded as cost_to_cents does.
+ */
+long long percent_of_cents(long long cents, int percent);
+
+/**
+ * Writes an amount of cents as a cost with two decimal places, with a minus
+ * sign if it is negative.
+ *
+ * @param buffer The buffer written, always terminated if size > 0.
+ * @param size The size of the buffer.
+ * @param cents The amount in cents.
+ * @return The number of characters of the whole text, as snprintf.
+ */
+int format_cents(char *buffer, size_t size, long long cents);
+
+/**
+ * Prints an amount of cents as format_cents writes it.
+ *
+ * @param cents The amount in cents.
+ * @param out The stream printed to.
+ */
+void print_cents(long long cents, FILE *out);
+
+#endif /* HISTORY_H */
@@ -12,13 +12,7 @@
 
 
 int ParkAlreadyExists(Parks *parks, char *name) {
-    for (int i = 0; i < parks->capacity; i++) {
-        if (parks->parks[i] != NULL &&
-            strcmp(parks->parks[i]->name, name) == 0) {
-            return 1;
-        }
-    }
-    return 0;
+    return find_name(&parks->names, name) != NO_HANDLE;
 }
 
 int isCostValid(float price_15, float price_15_1h, float price_1h) {
@@ -95,18 +89,15 @@ int isValidLicensePlate(const char *plate) {
     return 0; // Invalid number of letters or digits
 }
 
-int isParkFull(Park *park) {
-    if (park->available_spots == 0) {
+int isParkFull(Parks *parks, Park *park) {
+    if (parks->free_spots[park->handle] == 0) {
         return 1;
     }
     return 0;
 }
 
-int isValidDate(const char *date) {
-    int day, month, year;
-    if (sscanf(date, "%d-%d-%d", &day, &month, &year) != 3) {
-        return 0; // Format doesn't match DD-MM-YYYY
-    }
+// Checks the day, month and year of a date
+static int isValidDay(int day, int month, int year) {
     if (month < 1 || month > 12) {
         return 0; // Invalid month
     }
@@ -133,6 +124,14 @@ int isValidDate(const char *date) {
     return 1;
 }
 
+int isValidDate(const char *date) {
+    int day, month, year;
+    if (sscanf(date, "%d-%d-%d", &day, &month, &year) != 3) {
+        return 0; // Format doesn't match DD-MM-YYYY
+    }
+    return isValidDay(day, month, year);
+}
+
 
 int isValidTime(const char *time) {
     int hour, minute;
@@ -148,3 +147,8 @@ int isValidTime(const char *time) {
     return 1;
 }
 
+int isValidDateValue(Date date) {
+    return isValidDay(date.day, date.month, date.year) &&
+        date.hour >= 0 && date.hour <= 23 &&
+        date.minute >= 0 && date.minute <= 59;
+}
@@ -70,10 +70,11 @@ int isValidLicensePlate(const char *plate);
  * full.
  * A park is considered full if there are no available parking spaces.
  *
+ * @param parks The pointer to the Parks struct holding the park.
  * @param park A pointer to the Park structure.
  * @return 1 if the park is full, 0 otherwise.
  */
-int isParkFull(Park* park);
+int isParkFull(Parks* parks, Park* park);
 
 
 /**
@@ -93,4 +94,14 @@ int isValidDate(const char *date);
  */
 int isValidTime(const char *time);
 
+
+/**
+ * Checks if an already parsed date and time is valid, with the same rules as
+ * isValidDate and isValidTime.
+ *
+ * @param date The date to be checked.
+ * @return 1 if the date and time are valid, 0 otherwise.
+ */
+int isValidDateValue(Date date);
+
 #endif /* INVARIANTS_H */
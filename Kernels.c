@@ -0,0 +1,150 @@
+/**
+ * File containing the vectorized revenue aggregation kernels used by the
+ * billing queries, with a scalar fallback and runtime CPU dispatch.
+ * @file Kernels.c
+ * @author ist1102716
+*/
+#include "Kernels.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#endif
+
+// Number of 32 bit lanes in an AVX2 register
+#define AVX2_LANES 8
+// Number of 32 bit lanes in an SSE2 register
+#define SSE2_LANES 4
+// Movemask of an AVX2 block with every lane selected
+#define AVX2_ALL_LANES 0xFF
+
+/** Signature shared by every implementation of the range kernel. */
+typedef RangeTotal (*RangeKernel)(const int *, const long long *, int, int,
+                                    int);
+
+// Scalar range total, also used for the tail of the vectorized versions
+static RangeTotal range_total_scalar(const int *minutes,
+                                        const long long *cents, int count,
+                                        int from, int to) {
+    RangeTotal total = {0, 0};
+    for (int i = 0; i < count && minutes[i] < to; i++) {
+        if (minutes[i] >= from) {
+            total.cents += cents[i];
+            total.count++;
+        }
+    }
+    return total;
+}
+
+// Adds the scalar total of the rows left after the last full block
+static RangeTotal add_tail(RangeTotal total, const int *minutes,
+                            const long long *cents, int count, int from,
+                            int to) {
+    RangeTotal tail = range_total_scalar(minutes, cents, count, from, to);
+    total.cents += tail.cents;
+    total.count += tail.count;
+    return total;
+}
+
+#ifdef KERNELS_X86
+// Sums the four 64 bit lanes of an AVX2 register
+__attribute__((target("avx2")))
+static long long horizontal_sum_avx2(__m256i sums) {
+    __m128i pair = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                                    _mm256_extracti128_si256(sums, 1));
+    return _mm_cvtsi128_si64(pair) +
+            _mm_cvtsi128_si64(_mm_unpackhi_epi64(pair, pair));
+}
+
+// AVX2 range total: eight rows per step, the mask of their minutes widened
+// to the 64 bit costs
+__attribute__((target("avx2")))
+static RangeTotal range_total_avx2(const int *minutes, const long long *cents,
+                                    int count, int from, int to) {
+    const __m256i low = _mm256_set1_epi32(from - 1);
+    const __m256i high = _mm256_set1_epi32(to);
+    __m256i sums = _mm256_setzero_si256();
+    RangeTotal total = {0, 0};
+    int i = 0;
+    for (; i + AVX2_LANES <= count; i += AVX2_LANES) {
+        __m256i minute = _mm256_loadu_si256((const __m256i *)(minutes + i));
+        __m256i first = _mm256_loadu_si256((const __m256i *)(cents + i));
+        __m256i second = _mm256_loadu_si256((const __m256i *)(cents + i + 4));
+        __m256i inside = _mm256_and_si256(_mm256_cmpgt_epi32(minute, low),
+                                        _mm256_cmpgt_epi32(high, minute));
+        // Sign extension turns each selected lane into a 64 bit one
+        sums = _mm256_add_epi64(sums, _mm256_and_si256(first,
+                    _mm256_cvtepi32_epi64(_mm256_castsi256_si128(inside))));
+        sums = _mm256_add_epi64(sums, _mm256_and_si256(second,
+                    _mm256_cvtepi32_epi64(_mm256_extracti128_si256(inside,
+                                                                    1))));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(inside));
+        total.count += __builtin_popcount(mask);
+        if (mask != AVX2_ALL_LANES && minutes[i + AVX2_LANES - 1] >= to) {
+            total.cents = horizontal_sum_avx2(sums);
+            return total; // Sorted rows: nothing after this block is inside
+        }
+    }
+    total.cents = horizontal_sum_avx2(sums);
+    return add_tail(total, minutes + i, cents + i, count - i, from, to);
+}
+
+// SSE2 range total: four rows per step, the mask of their minutes widened
+// to the 64 bit costs
+static RangeTotal range_total_sse2(const int *minutes, const long long *cents,
+                                    int count, int from, int to) {
+    const __m128i low = _mm_set1_epi32(from - 1);
+    const __m128i high = _mm_set1_epi32(to);
+    __m128i sums = _mm_setzero_si128();
+    RangeTotal total = {0, 0};
+    int i = 0;
+    int stop = 0;
+    for (; i + SSE2_LANES <= count && !stop; i += SSE2_LANES) {
+        __m128i minute = _mm_loadu_si128((const __m128i *)(minutes + i));
+        __m128i first = _mm_loadu_si128((const __m128i *)(cents + i));
+        __m128i second = _mm_loadu_si128((const __m128i *)(cents + i + 2));
+        __m128i inside = _mm_and_si128(_mm_cmpgt_epi32(minute, low),
+                                        _mm_cmpgt_epi32(high, minute));
+        // Pairing each lane of the mask with itself makes a 64 bit lane
+        sums = _mm_add_epi64(sums, _mm_and_si128(first,
+                                    _mm_unpacklo_epi32(inside, inside)));
+        sums = _mm_add_epi64(sums, _mm_and_si128(second,
+                                    _mm_unpackhi_epi32(inside, inside)));
+        total.count += __builtin_popcount(
+                        _mm_movemask_ps(_mm_castsi128_ps(inside)));
+        stop = minutes[i + SSE2_LANES - 1] >= to;
+    }
+    total.cents = _mm_cvtsi128_si64(sums) +
+                    _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+    if (stop) {
+        return total;
+    }
+    return add_tail(total, minutes + i, cents + i, count - i, from, to);
+}
+#endif
+
+// Picks the best implementation supported by the running CPU
+static RangeKernel select_range_kernel(void) {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return range_total_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return range_total_sse2;
+    }
+#endif
+    return range_total_scalar;
+}
+
+RangeTotal kernel_range_total(const int *minutes, const long long *cents,
+                                int count, int from, int to) {
+    // Selected on the first call; threads racing on it pick the same one
+    static RangeKernel selected = NULL;
+    RangeKernel kernel = __atomic_load_n(&selected, __ATOMIC_RELAXED);
+    if (kernel == NULL) {
+        kernel = select_range_kernel();
+        __atomic_store_n(&selected, kernel, __ATOMIC_RELAXED);
+    }
+    return kernel(minutes, cents, count, from, to);
+}
@@ -0,0 +1,32 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+/**
+ * @struct RangeTotal
+ * @brief Sum and number of the rows selected by a revenue kernel.
+ */
+typedef struct {
+    long long cents;
+    int count;
+} RangeTotal;
+
+/**
+ * Sums the costs of the rows whose minute lies in [from, to).
+ *
+ * The minutes must be sorted, as the exits of a History are: the scan stops
+ * at the first block past the range, so the count is also the length of the
+ * run of rows that starts at a row inside the range (e.g. the exits of one
+ * day). The AVX2 or SSE2 version is picked on the first call according to
+ * the running CPU, with a scalar fallback.
+ *
+ * @param minutes The sorted minutes of the rows.
+ * @param cents The costs of the rows, in cents.
+ * @param count The number of rows.
+ * @param from The first minute of the range.
+ * @param to The minute right after the range.
+ * @return The total cost and the number of rows in the range.
+ */
+RangeTotal kernel_range_total(const int *minutes, const long long *cents,
+                                int count, int from, int to);
+
+#endif /* KERNELS_H */
@@ -0,0 +1,180 @@
+/**
+ * File containing the implementation of the streaming leaderboards of the
+ * parking system.
+ * @file Leaderboard.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Leaderboard.h"
+
+// Odd constant spreading the rows of a count-min sketch apart
+#define HASH_ROW_STEP 0x9E3779B97F4A7C15ull
+
+// Mixes the bits of a key (splitmix64 finalizer)
+static uint64_t mix_key(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    return key ^ (key >> 31);
+}
+
+// Home slot of a key in the index of a leaderboard
+static int home_slot(uint64_t key) {
+    return mix_key(key) % TOPK_SLOTS;
+}
+
+void init_topk(TopK *topk) {
+    memset(topk, 0, sizeof(TopK));
+}
+
+// Slot holding the key, or the empty slot where it would be inserted
+static int find_slot(const TopK *topk, uint64_t key) {
+    int slot = home_slot(key);
+    while (topk->slots[slot].position != 0 && topk->slots[slot].key != key) {
+        slot = (slot + 1) % TOPK_SLOTS;
+    }
+    return slot;
+}
+
+// Empties a slot, shifting back the keys that probed past it
+static void delete_slot(TopK *topk, int hole) {
+    for (int slot = (hole + 1) % TOPK_SLOTS; topk->slots[slot].position != 0;
+            slot = (slot + 1) % TOPK_SLOTS) {
+        int home = home_slot(topk->slots[slot].key);
+        int distance = (slot - home + TOPK_SLOTS) % TOPK_SLOTS;
+        if (distance >= (slot - hole + TOPK_SLOTS) % TOPK_SLOTS) {
+            topk->slots[hole] = topk->slots[slot];
+            hole = slot;
+        }
+    }
+    topk->slots[hole].position = 0;
+}
+
+// Whether an entry ranks below another: smaller value, then larger key
+static int ranks_below(const TopKEntry *a, const TopKEntry *b) {
+    return a->value < b->value || (a->value == b->value && a->key > b->key);
+}
+
+// Puts an entry at a heap position and points its slot to it
+static void place_entry(TopK *topk, int position, TopKEntry entry) {
+    topk->heap[position] = entry;
+    topk->slots[find_slot(topk, entry.key)].position = position + 1;
+}
+
+static void sift_up(TopK *topk, int position) {
+    TopKEntry entry = topk->heap[position];
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (!ranks_below(&entry, &topk->heap[parent])) {
+            break;
+        }
+        place_entry(topk, position, topk->heap[parent]);
+        position = parent;
+    }
+    place_entry(topk, position, entry);
+}
+
+static void sift_down(TopK *topk, int position) {
+    TopKEntry entry = topk->heap[position];
+    while (2 * position + 1 < topk->count) {
+        int child = 2 * position + 1;
+        if (child + 1 < topk->count &&
+            ranks_below(&topk->heap[child + 1], &topk->heap[child])) {
+            child++;
+        }
+        if (!ranks_below(&topk->heap[child], &entry)) {
+            break;
+        }
+        place_entry(topk, position, topk->heap[child]);
+        position = child;
+    }
+    place_entry(topk, position, entry);
+}
+
+void topk_offer(TopK *topk, uint64_t key, long long value) {
+    TopKEntry entry = {key, value};
+    int slot = find_slot(topk, key);
+    if (topk->slots[slot].position != 0) {
+        int position = topk->slots[slot].position - 1;
+        if (value > topk->heap[position].value) {
+            topk->heap[position].value = value;
+            sift_down(topk, position);
+        }
+        return;
+    }
+    if (topk->count < TOPK_CAPACITY) {
+        topk->slots[slot].key = key;
+        topk->slots[slot].position = topk->count + 1;
+        topk->heap[topk->count++] = entry;
+        sift_up(topk, topk->count - 1);
+    } else if (ranks_below(&topk->heap[0], &entry)) {
+        // Evict the smallest entry, which is at the root
+        delete_slot(topk, find_slot(topk, topk->heap[0].key));
+        slot = find_slot(topk, key);
+        topk->slots[slot].key = key;
+        topk->slots[slot].position = 1;
+        topk->heap[0] = entry;
+        sift_down(topk, 0);
+    }
+}
+
+// Orders entries from the largest value down, ties by increasing key
+static int compare_entries(const void *a, const void *b) {
+    const TopKEntry *x = (const TopKEntry *)a;
+    const TopKEntry *y = (const TopKEntry *)b;
+    if (x->value != y->value) {
+        return x->value < y->value ? 1 : -1;
+    }
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+int topk_sorted(const TopK *topk, TopKEntry *entries, int k) {
+    TopKEntry sorted[TOPK_CAPACITY];
+    memcpy(sorted, topk->heap, topk->count * sizeof(TopKEntry));
+    qsort(sorted, topk->count, sizeof(TopKEntry), compare_entries);
+    if (k > topk->count) {
+        k = topk->count;
+    }
+    memcpy(entries, sorted, k * sizeof(TopKEntry));
+    return k;
+}
+
+void init_count_min(CountMin *sketch) {
+    memset(sketch, 0, sizeof(CountMin));
+}
+
+long long count_min_add(CountMin *sketch, uint64_t key, long long amount) {
+    long long *counters[COUNT_MIN_DEPTH];
+    long long estimate = 0;
+    for (int row = 0; row < COUNT_MIN_DEPTH; row++) {
+        uint64_t hash = mix_key(key + row * HASH_ROW_STEP);
+        counters[row] = &sketch->counters[row][hash % COUNT_MIN_WIDTH];
+        if (row == 0 || *counters[row] < estimate) {
+            estimate = *counters[row];
+        }
+    }
+    // Conservative update: no counter is raised past the new estimate
+    estimate += amount;
+    for (int row = 0; row < COUNT_MIN_DEPTH; row++) {
+        if (*counters[row] < estimate) {
+            *counters[row] = estimate;
+        }
+    }
+    return estimate;
+}
+
+void init_leaderboards(Leaderboards *boards) {
+    init_count_min(&boards->spend);
+    init_topk(&boards->spenders);
+    init_topk(&boards->stays);
+    init_topk(&boards->lots);
+}
+
+void add_leaderboard_stay(Leaderboards *boards, uint64_t plate, int minutes,
+                            long long cents) {
+    topk_offer(&boards->spenders, plate,
+                count_min_add(&boards->spend, plate, cents));
+    topk_offer(&boards->stays, plate, minutes);
+}
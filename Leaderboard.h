@@ -0,0 +1,138 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+
+// Largest number of entries kept (and returned) by a leaderboard
+#ifndef TOPK_CAPACITY
+#define TOPK_CAPACITY 32
+#endif
+// Number of places listed when no size is asked for
+#define TOPK_DEFAULT 10
+// Slots of the index from a key to its position in the heap
+#define TOPK_SLOTS (TOPK_CAPACITY * 4)
+// Number of rows (independent hashes) of a count-min sketch
+#define COUNT_MIN_DEPTH 4
+// Number of counters in each row of a count-min sketch
+#ifndef COUNT_MIN_WIDTH
+#define COUNT_MIN_WIDTH 65536
+#endif
+
+/**
+ * @struct TopKEntry
+ * @brief One key of a leaderboard and its value.
+ */
+typedef struct {
+    uint64_t key;
+    long long value;
+} TopKEntry;
+
+/**
+ * @struct TopKSlot
+ * @brief Slot of the index of a leaderboard.
+ */
+typedef struct {
+    uint64_t key;
+    int position;           // Heap position + 1 of the key, 0 if empty
+} TopKSlot;
+
+/**
+ * @struct TopK
+ * @brief The TOPK_CAPACITY largest values seen, one per key.
+ *
+ * Entries are kept in a min-heap, so the smallest one is the first to be
+ * evicted, and an open addressing index finds the entry of a key in O(1).
+ * The memory used is fixed, whatever the number of keys offered.
+ */
+typedef struct {
+    TopKEntry heap[TOPK_CAPACITY];
+    int count;
+    TopKSlot slots[TOPK_SLOTS];
+} TopK;
+
+/**
+ * @struct CountMin
+ * @brief Count-min sketch of the totals of an unbounded set of keys.
+ *
+ * Estimates never fall below the true total and, with conservative update,
+ * only exceed it on hash collisions with other keys.
+ */
+typedef struct {
+    long long counters[COUNT_MIN_DEPTH][COUNT_MIN_WIDTH];
+} CountMin;
+
+/**
+ * @struct Leaderboards
+ * @brief Live leaderboards of the whole parking system.
+ */
+typedef struct {
+    CountMin spend;         // Total spent by each license plate, in cents
+    TopK spenders;          // Packed plates by total spent
+    TopK stays;             // Packed plates by their longest stay, in minutes
+    TopK lots;              // Park ids by number of exits
+} Leaderboards;
+
+/**
+ * Initializes an empty leaderboard.
+ *
+ * @param topk The leaderboard to be initialized.
+ */
+void init_topk(TopK *topk);
+
+/**
+ * Raises the value of a key to the given one, if that is larger, keeping
+ * the key only while it is among the largest TOPK_CAPACITY values.
+ *
+ * @param topk The leaderboard.
+ * @param key The key.
+ * @param value The new value of the key.
+ */
+void topk_offer(TopK *topk, uint64_t key, long long value);
+
+/**
+ * Copies the largest entries of a leaderboard, from the largest value down
+ * (ties by increasing key), in O(k log k).
+ *
+ * @param topk The leaderboard.
+ * @param entries Array of at least k entries to be filled.
+ * @param k The number of entries wanted.
+ * @return The number of entries copied.
+ */
+int topk_sorted(const TopK *topk, TopKEntry *entries, int k);
+
+/**
+ * Initializes a count-min sketch with every total at zero.
+ *
+ * @param sketch The sketch to be initialized.
+ */
+void init_count_min(CountMin *sketch);
+
+/**
+ * Adds a non-negative amount to the total of a key.
+ *
+ * @param sketch The sketch.
+ * @param key The key.
+ * @param amount The amount to be added.
+ * @return The new estimate of the total of the key.
+ */
+long long count_min_add(CountMin *sketch, uint64_t key, long long amount);
+
+/**
+ * Initializes empty leaderboards.
+ *
+ * @param boards The leaderboards to be initialized.
+ */
+void init_leaderboards(Leaderboards *boards);
+
+/**
+ * Adds a closed stay to the spenders and stays leaderboards.
+ *
+ * @param boards The leaderboards.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param minutes The length of the stay.
+ * @param cents The cost of the stay.
+ */
+void add_leaderboard_stay(Leaderboards *boards, uint64_t plate, int minutes,
+                            long long cents);
+
+#endif /* LEADERBOARD_H */
@@ -0,0 +1,189 @@
+/**
+ * File containing the implementation of the memory report of the parks and
+ * of the structures they share.
+ * @file Memory.c
+ * @author ist1102716
+*/
+#include <string.h>
+#include "Memory.h"
+#include "Billing.h"
+
+// Names of the structures, by MEMORY_ index
+static const char *const structure_names[MEMORY_STRUCTURES] = {
+    "park", "record-buckets", "record-nodes", "record-dates",
+    "vehicle-nodes", "history", "occupancy", "revenue", "dwell", "tariffs",
+    "zones", "registry", "names", "vehicles", "visits", "bloom",
+    "leaderboards", "network-revenue", "overstay", "passes", "snapshot",
+    "archive", "billing"
+};
+
+// Adds memory to a structure of a report
+static void add_usage(MemoryReport *report, int structure, size_t bytes,
+                        size_t objects) {
+    report->usage[structure].bytes += bytes;
+    report->usage[structure].objects += objects;
+}
+
+void clear_memory_report(MemoryReport *report) {
+    for (int i = 0; i < MEMORY_STRUCTURES; i++) {
+        report->usage[i].bytes = 0;
+        report->usage[i].objects = 0;
+    }
+}
+
+// Adds the memory of the hash map of the records of a park; records still
+// held by a mapped snapshot are counted with the snapshot
+static void measure_records(const HashMap *map, MemoryReport *report) {
+    if (map == NULL) {
+        return;
+    }
+    add_usage(report, MEMORY_RECORD_BUCKETS,
+                sizeof(HashMap) + map->size * sizeof(HashNode *), 1);
+    // The dates of a node are its own copies, so they are split out
+    size_t date_bytes = map->record_nodes.live * 2 * sizeof(Date);
+    add_usage(report, MEMORY_RECORD_NODES,
+                map->record_nodes.block_bytes - date_bytes,
+                map->record_nodes.live);
+    add_usage(report, MEMORY_RECORD_DATES, date_bytes,
+                2 * map->record_nodes.live);
+    add_usage(report, MEMORY_VEHICLE_NODES, map->vehicle_nodes.block_bytes,
+                map->vehicle_nodes.live);
+}
+
+// Adds the memory of the zones of a park
+static void measure_zones(const ZoneTree *tree, MemoryReport *report) {
+    size_t bytes = tree->count * (sizeof(Zone) + sizeof(ZonePool) +
+                                    sizeof(int) + ZONE_NAME_SIZE) +
+                    2 * tree->leaves * sizeof(ZoneNode);
+    for (int i = 0; i < tree->count; i++) {
+        const SpotMap *spots = &tree->pools[i].spots;
+        bytes += (spots->word_count + spots->summary_count) *
+                    sizeof(uint64_t);
+    }
+    add_usage(report, MEMORY_ZONES, bytes, tree->count);
+}
+
+void measure_park_memory(const Park *park, MemoryReport *report) {
+    add_usage(report, MEMORY_PARK, sizeof(Park) + strlen(park->name) + 1, 1);
+    measure_records(park->records_map, report);
+    // Columns borrowed from a snapshot have no capacity of their own
+    const History *history = &park->history;
+    add_usage(report, MEMORY_HISTORY, history->capacity *
+                (sizeof(uint64_t) + sizeof(long long) + 3 * sizeof(int)),
+                history->count);
+    const Occupancy *occupancy = &park->occupancy;
+    if (occupancy->capacity > 0) {
+        add_usage(report, MEMORY_OCCUPANCY, occupancy->capacity *
+                    sizeof(uint32_t) + (occupancy->capacity /
+                    OCCUPANCY_CHECKPOINT_EVERY + 1) * sizeof(int),
+                    occupancy->count);
+    }
+    add_usage(report, MEMORY_REVENUE, park->revenue.capacity *
+                (sizeof(int) + sizeof(long long)), park->revenue.count);
+    add_usage(report, MEMORY_DWELL, park->dwell.capacity *
+                (sizeof(int) + sizeof(DwellHistogram)), park->dwell.count);
+    add_usage(report, MEMORY_TARIFFS, park->tariffs.capacity *
+                sizeof(Tariff), park->tariffs.count);
+    add_usage(report, MEMORY_ARCHIVE, park->linked_rows * sizeof(int),
+                park->linked_rows);
+    measure_zones(&park->zones, report);
+}
+
+// Capacity of a visit array: the next power of two of its visits
+static int visit_capacity(int count) {
+    int capacity = 1;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Adds the memory of the table of the archived rows of each vehicle
+static void measure_archive(const VehicleIndex *index, MemoryReport *report) {
+    size_t bytes = index->archived_slot_count * sizeof(ArchivedVehicle);
+    for (int i = 0; i < index->archived_slot_count; i++) {
+        int count = index->archived[i].visit_count;
+        if (count > 0) {
+            bytes += visit_capacity(count) * sizeof(ArchivedVisit);
+        }
+    }
+    add_usage(report, MEMORY_ARCHIVE, bytes, index->archived_count);
+}
+
+// Adds the memory of the vehicle index and of the parks each vehicle has
+// visited
+static void measure_vehicles(const VehicleIndex *index, MemoryReport *report) {
+    add_usage(report, MEMORY_VEHICLES, index->slot_count *
+                sizeof(VehicleSlot) + MAX_LOTS * sizeof(unsigned),
+                index->count);
+    size_t visit_bytes = 0;
+    size_t visits = 0;
+    for (int i = 0; i < index->slot_count; i++) {
+        int count = index->slots[i].visit_count;
+        if (count > 0) {
+            visit_bytes += visit_capacity(count) * sizeof(VehicleVisit);
+            visits += count;
+        }
+    }
+    add_usage(report, MEMORY_VISITS, visit_bytes, visits);
+    add_usage(report, MEMORY_BLOOM, index->seen.block_count *
+                BLOOM_BLOCK_WORDS * sizeof(uint64_t),
+                index->seen.block_count);
+    measure_archive(index, report);
+}
+
+void measure_network_memory(const Parks *parks, MemoryReport *report) {
+    add_usage(report, MEMORY_REGISTRY, sizeof(Parks) - sizeof(Leaderboards) +
+                MAX_LOTS * (sizeof(Park *) + 3 * sizeof(int) +
+                sizeof(long long)), 1);
+    const NameTable *names = &parks->names;
+    add_usage(report, MEMORY_NAMES, (names->capacity + 1) *
+                (sizeof(char *) + sizeof(int)) +
+                names->slot_count * sizeof(int), names->count);
+    measure_vehicles(&parks->vehicles, report);
+    add_usage(report, MEMORY_LEADERBOARDS, sizeof(Leaderboards), 1);
+    const NetworkRevenue *revenue = &parks->revenue;
+    add_usage(report, MEMORY_NETWORK_REVENUE, revenue->capacity > 0 ?
+                revenue->capacity * (sizeof(int) + 2 * sizeof(long long)) +
+                sizeof(long long) : 0, revenue->count);
+    const OverstayMonitor *overstay = &parks->overstay;
+    add_usage(report, MEMORY_OVERSTAY, overstay->timers.block_bytes +
+                (overstay->alerts != NULL ?
+                OVERSTAY_LOG_SIZE * sizeof(OverstayAlert) : 0),
+                overstay->timers.live + overstay->alert_count);
+    const PassTable *passes = parks->passes.current;
+    if (passes != NULL) {
+        add_usage(report, MEMORY_PASSES, sizeof(PassTable) +
+                    (passes->bucket_count + 1) * sizeof(uint32_t) +
+                    (passes->count > 0 ? passes->count : 1) *
+                    sizeof(PassEntry), passes->count);
+    }
+    if (parks->snapshot != NULL) {
+        add_usage(report, MEMORY_SNAPSHOT, parks->snapshot_size, 1);
+    }
+    if (parks->billing != NULL) {
+        size_t bytes = BILLING_BATCH * sizeof(BillingOutput);
+        for (int i = 0; i < BILLING_BATCH; i++) {
+            bytes += parks->billing[i].capacity;
+        }
+        add_usage(report, MEMORY_BILLING, bytes, BILLING_BATCH);
+    }
+}
+
+const char *memory_structure_name(int structure) {
+    return structure_names[structure];
+}
+
+void sort_memory_report(const MemoryReport *report,
+                        int order[MEMORY_STRUCTURES]) {
+    // Insertion sort: there are only a few structures
+    for (int i = 0; i < MEMORY_STRUCTURES; i++) {
+        int j = i;
+        while (j > 0 && report->usage[order[j - 1]].bytes <
+                report->usage[i].bytes) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+#include "Parks.h"
+
+// Structures accounted in a memory report; the first ones belong to a park
+#define MEMORY_PARK 0           // The Park struct and its name
+#define MEMORY_RECORD_BUCKETS 1 // Bucket array of the hash map of records
+#define MEMORY_RECORD_NODES 2   // Record nodes, their dates aside
+#define MEMORY_RECORD_DATES 3   // Entry and exit dates inside record nodes
+#define MEMORY_VEHICLE_NODES 4  // Vehicle nodes of the hash map of records
+#define MEMORY_HISTORY 5
+#define MEMORY_OCCUPANCY 6
+#define MEMORY_REVENUE 7
+#define MEMORY_DWELL 8
+#define MEMORY_TARIFFS 9
+#define MEMORY_ZONES 10
+#define MEMORY_REGISTRY 11      // The Parks struct and its handle arrays
+#define MEMORY_NAMES 12
+#define MEMORY_VEHICLES 13
+#define MEMORY_VISITS 14
+#define MEMORY_BLOOM 15
+#define MEMORY_LEADERBOARDS 16
+#define MEMORY_NETWORK_REVENUE 17
+#define MEMORY_OVERSTAY 18
+#define MEMORY_PASSES 19
+#define MEMORY_SNAPSHOT 20      // Mapped snapshot file, not on the heap
+#define MEMORY_ARCHIVE 21       // Archived rows of each vehicle and park
+#define MEMORY_BILLING 22       // Buffers kept by the billing report
+#define MEMORY_STRUCTURES 23
+
+/**
+ * @struct MemoryUsage
+ * @brief Live memory of one structure.
+ */
+typedef struct {
+    size_t bytes;
+    size_t objects;
+} MemoryUsage;
+
+/**
+ * @struct MemoryReport
+ * @brief Live memory of each structure, by MEMORY_ index.
+ *
+ * The sizes are read from the capacities the structures already keep, and
+ * the pools count their live nodes, so measuring costs nothing until a
+ * report is asked for, and then O(parks + vehicles).
+ */
+typedef struct {
+    MemoryUsage usage[MEMORY_STRUCTURES];
+} MemoryReport;
+
+/**
+ * Empties a report.
+ *
+ * @param report The report.
+ */
+void clear_memory_report(MemoryReport *report);
+
+/**
+ * Adds the memory of a park to a report.
+ *
+ * @param park The park.
+ * @param report The report.
+ */
+void measure_park_memory(const Park *park, MemoryReport *report);
+
+/**
+ * Adds the memory of the structures shared by every park to a report.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param report The report.
+ */
+void measure_network_memory(const Parks *parks, MemoryReport *report);
+
+/**
+ * Gets the name of a structure.
+ *
+ * @param structure Its MEMORY_ index.
+ * @return The name, without spaces.
+ */
+const char *memory_structure_name(int structure);
+
+/**
+ * Sorts the structures of a report, largest first.
+ *
+ * @param report The report.
+ * @param order Filled with the MEMORY_STRUCTURES indices in that order.
+ */
+void sort_memory_report(const MemoryReport *report,
+                        int order[MEMORY_STRUCTURES]);
+
+#endif /* MEMORY_H */
@@ -0,0 +1,109 @@
+/**
+ * File containing the implementation of the table of interned park names.
+ * @file Names.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "Names.h"
+
+// Hashes a name (FNV-1a)
+static uint64_t hash_name(const char *name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (; *name != '\0'; name++) {
+        hash = (hash ^ (unsigned char)*name) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Slot holding the name, or the empty slot where it would be inserted
+static int find_slot(const NameTable *table, const char *name) {
+    int mask = table->slot_count - 1;
+    int slot = hash_name(name) & mask;
+    while (table->slots[slot] != 0 &&
+            strcmp(table->names[table->slots[slot] - 1], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Position of a name in the ordered handles, or where it would be inserted
+static int find_rank(const NameTable *table, const char *name) {
+    int low = 0;
+    int high = table->count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (strcmp(table->names[table->ordered[middle]], name) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int init_name_table(NameTable *table, int capacity) {
+    table->count = 0;
+    table->capacity = capacity;
+    table->slot_count = 1;
+    while (table->slot_count < 2 * capacity) {
+        table->slot_count *= 2;
+    }
+    table->names = (const char **)calloc(capacity + 1, sizeof(char *));
+    table->slots = (int *)calloc(table->slot_count, sizeof(int));
+    table->ordered = (int *)calloc(capacity + 1, sizeof(int));
+    if (table->names == NULL || table->slots == NULL ||
+        table->ordered == NULL) {
+        destroy_name_table(table);
+        return 0; // Memory allocation failed
+    }
+    return 1;
+}
+
+void intern_name(NameTable *table, const char *name, int handle) {
+    table->slots[find_slot(table, name)] = handle + 1;
+    int rank = find_rank(table, name);
+    memmove(table->ordered + rank + 1, table->ordered + rank,
+            (table->count - rank) * sizeof(int));
+    table->ordered[rank] = handle;
+    table->names[handle] = name;
+    table->count++;
+}
+
+int find_name(const NameTable *table, const char *name) {
+    return table->slots[find_slot(table, name)] - 1;
+}
+
+void release_name(NameTable *table, int handle) {
+    const char *name = table->names[handle];
+    int rank = find_rank(table, name);
+    memmove(table->ordered + rank, table->ordered + rank + 1,
+            (table->count - rank - 1) * sizeof(int));
+
+    // Empty the slot, shifting back the names that probed past it
+    int mask = table->slot_count - 1;
+    int slot = find_slot(table, name);
+    int next = (slot + 1) & mask;
+    while (table->slots[next] != 0) {
+        int home = hash_name(table->names[table->slots[next] - 1]) & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            table->slots[slot] = table->slots[next];
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+    table->slots[slot] = 0;
+    table->names[handle] = NULL;
+    table->count--;
+}
+
+void destroy_name_table(NameTable *table) {
+    free(table->names);
+    free(table->slots);
+    free(table->ordered);
+    table->names = NULL;
+    table->slots = NULL;
+    table->ordered = NULL;
+    table->count = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+// Handle of a name that is not in the table
+#define NO_HANDLE -1
+
+/**
+ * @struct NameTable
+ * @brief Interned park names, each one bound to a dense integer handle.
+ *
+ * Names are hashed once, when they are interned or looked up; everything
+ * else refers to a park by its handle. The table also keeps the handles in
+ * name order, so listings by name need no copy and no sort.
+ *
+ * The table does not copy the names: each one must stay valid until its
+ * handle is released.
+ */
+typedef struct {
+    const char **names;     // Name of each handle, NULL if the handle is free
+    int *slots;             // Open addressing index of handle + 1, 0 if empty
+    int *ordered;           // Handles in name order
+    int count;
+    int capacity;           // Number of handles
+    int slot_count;         // Power of two, at least twice the capacity
+} NameTable;
+
+/**
+ * Initializes an empty table.
+ *
+ * @param table The table to be initialized.
+ * @param capacity The number of handles, from 0 to capacity - 1.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int init_name_table(NameTable *table, int capacity);
+
+/**
+ * Binds a name to a free handle.
+ *
+ * @param table The table.
+ * @param name The name, not yet in the table.
+ * @param handle The handle, not yet bound.
+ */
+void intern_name(NameTable *table, const char *name, int handle);
+
+/**
+ * Finds the handle of a name.
+ *
+ * @param table The table.
+ * @param name The name to look for.
+ * @return The handle of the name, or NO_HANDLE if it is not in the table.
+ */
+int find_name(const NameTable *table, const char *name);
+
+/**
+ * Unbinds a handle from its name, so both can be used again.
+ *
+ * @param table The table.
+ * @param handle The bound handle.
+ */
+void release_name(NameTable *table, int handle);
+
+/**
+ * Frees the memory of a table.
+ *
+ * @param table The table.
+ */
+void destroy_name_table(NameTable *table);
+
+#endif /* NAMES_H */
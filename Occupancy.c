@@ -0,0 +1,159 @@
+/**
+ * File containing the implementation of the occupancy timeline of a park.
+ * @file Occupancy.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Occupancy.h"
+#include "Date.h"
+
+// Low bit of an event, set for exits
+#define EXIT_BIT 1u
+
+// Minute of an encoded event
+static int event_minute(uint32_t event) {
+    return (int)(event >> 1);
+}
+
+// Change in occupancy caused by an encoded event
+static int event_delta(uint32_t event) {
+    return (event & EXIT_BIT) ? -1 : 1;
+}
+
+void init_occupancy(Occupancy *occupancy) {
+    occupancy->events = NULL;
+    occupancy->checkpoints = NULL;
+    occupancy->count = 0;
+    occupancy->capacity = 0;
+    occupancy->occupied = 0;
+}
+
+void borrow_occupancy(Occupancy *occupancy, const void *base, int count,
+                        int occupied) {
+    occupancy->events = (uint32_t *)base;
+    occupancy->checkpoints = (int *)(occupancy->events + count);
+    occupancy->count = count;
+    occupancy->capacity = 0;
+    occupancy->occupied = occupied;
+}
+
+int occupancy_checkpoints(int count) {
+    return (count + OCCUPANCY_CHECKPOINT_EVERY - 1) /
+            OCCUPANCY_CHECKPOINT_EVERY;
+}
+
+// Moves the events and checkpoints to blocks of the given capacity
+static int grow_occupancy(Occupancy *occupancy, int capacity) {
+    uint32_t *events = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    int *checkpoints = (int *)malloc((capacity / OCCUPANCY_CHECKPOINT_EVERY
+                                        + 1) * sizeof(int));
+    if (events == NULL || checkpoints == NULL) {
+        free(events);
+        free(checkpoints);
+        return 0; // Memory allocation failed
+    }
+    if (occupancy->count > 0) {
+        memcpy(events, occupancy->events, occupancy->count * sizeof(uint32_t));
+        memcpy(checkpoints, occupancy->checkpoints,
+                occupancy_checkpoints(occupancy->count) * sizeof(int));
+    }
+    // Borrowed arrays belong to the snapshot mapping
+    if (occupancy->capacity > 0) {
+        free(occupancy->events);
+        free(occupancy->checkpoints);
+    }
+    occupancy->events = events;
+    occupancy->checkpoints = checkpoints;
+    occupancy->capacity = capacity;
+    return 1;
+}
+
+int reserve_occupancy(Occupancy *occupancy, int events) {
+    return events <= occupancy->capacity ||
+            grow_occupancy(occupancy, events);
+}
+
+int record_occupancy(Occupancy *occupancy, int minute, int is_exit) {
+    if (occupancy->count >= occupancy->capacity) {
+        int capacity = occupancy->count * 2;
+        if (capacity < OCCUPANCY_INITIAL_CAPACITY) {
+            capacity = OCCUPANCY_INITIAL_CAPACITY;
+        }
+        if (!grow_occupancy(occupancy, capacity)) {
+            return 0;
+        }
+    }
+    if (occupancy->count % OCCUPANCY_CHECKPOINT_EVERY == 0) {
+        occupancy->checkpoints[occupancy->count / OCCUPANCY_CHECKPOINT_EVERY] =
+            occupancy->occupied;
+    }
+    uint32_t event = ((uint32_t)minute << 1) | (is_exit ? EXIT_BIT : 0);
+    occupancy->events[occupancy->count++] = event;
+    occupancy->occupied += event_delta(event);
+    return 1;
+}
+
+// Number of events at or before the given minute
+static int events_until(const Occupancy *occupancy, int minute) {
+    int low = 0;
+    int high = occupancy->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (event_minute(occupancy->events[middle]) <= minute) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Occupancy after the first given number of events
+static int occupancy_after(const Occupancy *occupancy, int events) {
+    if (events == 0) {
+        return 0;
+    }
+    int block = (events - 1) / OCCUPANCY_CHECKPOINT_EVERY;
+    int occupied = occupancy->checkpoints[block];
+    for (int i = block * OCCUPANCY_CHECKPOINT_EVERY; i < events; i++) {
+        occupied += event_delta(occupancy->events[i]);
+    }
+    return occupied;
+}
+
+int occupancy_at(const Occupancy *occupancy, int minute) {
+    return occupancy_after(occupancy, events_until(occupancy, minute));
+}
+
+void occupancy_hours(const Occupancy *occupancy, int day_start,
+                        OccupancyHour *hours) {
+    int next = events_until(occupancy, day_start - 1);
+    int occupied = occupancy_after(occupancy, next);
+    for (int h = 0; h < OCCUPANCY_HOURS; h++) {
+        int hour_end = day_start + (h + 1) * MINUTES_PER_HOUR;
+        int since = hour_end - MINUTES_PER_HOUR;
+        long long area = 0; // Occupied spot minutes within the hour
+        hours[h].peak = occupied;
+        for (; next < occupancy->count &&
+                event_minute(occupancy->events[next]) < hour_end; next++) {
+            int minute = event_minute(occupancy->events[next]);
+            area += (long long)occupied * (minute - since);
+            since = minute;
+            occupied += event_delta(occupancy->events[next]);
+            if (occupied > hours[h].peak) {
+                hours[h].peak = occupied;
+            }
+        }
+        area += (long long)occupied * (hour_end - since);
+        hours[h].mean = (double)area / MINUTES_PER_HOUR;
+    }
+}
+
+void destroy_occupancy(Occupancy *occupancy) {
+    if (occupancy->capacity > 0) {
+        free(occupancy->events);
+        free(occupancy->checkpoints);
+    }
+    init_occupancy(occupancy);
+}
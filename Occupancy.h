@@ -0,0 +1,112 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <stdint.h>
+
+// Number of events between two occupancy checkpoints
+#define OCCUPANCY_CHECKPOINT_EVERY 64
+// Initial number of events allocated for a timeline
+#define OCCUPANCY_INITIAL_CAPACITY 256
+// Number of hours in the rollup of a day
+#define OCCUPANCY_HOURS 24
+
+/**
+ * @struct Occupancy
+ * @brief Delta encoded timeline of the occupancy of one park.
+ *
+ * Every entry or exit is stored as its minute shifted left by one bit, with
+ * the low bit set for exits. The occupancy before every
+ * OCCUPANCY_CHECKPOINT_EVERY events is kept as a checkpoint, so the
+ * occupancy at any moment is a binary search plus a short scan away.
+ */
+typedef struct {
+    uint32_t *events;
+    int *checkpoints;
+    int count;
+    int capacity;           // 0 while the arrays are borrowed from a snapshot
+    int occupied;           // Occupancy after the last event
+} Occupancy;
+
+/**
+ * @struct OccupancyHour
+ * @brief Peak and time weighted mean occupancy of one hour.
+ */
+typedef struct {
+    int peak;
+    double mean;
+} OccupancyHour;
+
+/**
+ * Initializes an empty timeline.
+ *
+ * @param occupancy The timeline to be initialized.
+ */
+void init_occupancy(Occupancy *occupancy);
+
+/**
+ * Makes a timeline read the arrays of a mapped snapshot.
+ *
+ * @param occupancy The (empty) timeline.
+ * @param base Start of the events, followed by the checkpoints.
+ * @param count The number of events.
+ * @param occupied The occupancy after the last event.
+ */
+void borrow_occupancy(Occupancy *occupancy, const void *base, int count,
+                        int occupied);
+
+/**
+ * Gets the number of checkpoints of a timeline with the given events.
+ *
+ * @param count The number of events.
+ * @return The number of checkpoints.
+ */
+int occupancy_checkpoints(int count);
+
+/**
+ * Makes room for at least a number of events, so that recording up to them
+ * does not touch the heap.
+ *
+ * @param occupancy The timeline.
+ * @param events The number of events, those already recorded included.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_occupancy(Occupancy *occupancy, int events);
+
+/**
+ * Appends an entry or an exit, not before the last event, to a timeline.
+ *
+ * @param occupancy The timeline.
+ * @param minute The minute of the event (see date_to_minutes).
+ * @param is_exit 1 for an exit, 0 for an entry.
+ * @return 1 if the event was added, 0 if memory allocation failed.
+ */
+int record_occupancy(Occupancy *occupancy, int minute, int is_exit);
+
+/**
+ * Gets the occupancy at a moment, after every event of that minute, in
+ * O(log events).
+ *
+ * @param occupancy The timeline.
+ * @param minute The minute (see date_to_minutes).
+ * @return The number of vehicles inside.
+ */
+int occupancy_at(const Occupancy *occupancy, int minute);
+
+/**
+ * Computes the peak and the mean occupancy of each hour of a day.
+ *
+ * @param occupancy The timeline.
+ * @param day_start The first minute of the day.
+ * @param hours Array of OCCUPANCY_HOURS entries to be filled.
+ */
+void occupancy_hours(const Occupancy *occupancy, int day_start,
+                        OccupancyHour *hours);
+
+/**
+ * Frees the memory of a timeline.
+ *
+ * @param occupancy The timeline to be destroyed.
+ */
+void destroy_occupancy(Occupancy *occupancy);
+
+#endif /* OCCUPANCY_H */
@@ -0,0 +1,203 @@
+/**
+ * File containing the implementation of the timing wheel that raises the
+ * overstay alerts of the open stays.
+ * @file Overstay.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include "Overstay.h"
+
+void init_overstay_monitor(OverstayMonitor *monitor) {
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        monitor->slots[i] = NULL;
+    }
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        monitor->occupied[level] = 0;
+    }
+    monitor->now = 0;
+    monitor->threshold = OVERSTAY_OFF;
+    monitor->pending = 0;
+    init_node_pool(&monitor->timers, sizeof(OverstayTimer));
+    monitor->alerts = NULL;
+    monitor->first_alert = 0;
+    monitor->alert_count = 0;
+    monitor->dropped = 0;
+}
+
+// Appends an alert to the ring, dropping the oldest one if it is full
+static void raise_alert(OverstayMonitor *monitor, const RecordNode *node,
+                        int park_id) {
+    if (monitor->alerts == NULL) {
+        monitor->alerts = (OverstayAlert *)malloc(OVERSTAY_LOG_SIZE *
+                                                    sizeof(OverstayAlert));
+        if (monitor->alerts == NULL) {
+            monitor->dropped++;
+            return; // Memory allocation failed
+        }
+    }
+    if (monitor->alert_count == OVERSTAY_LOG_SIZE) {
+        monitor->first_alert = (monitor->first_alert + 1) % OVERSTAY_LOG_SIZE;
+        monitor->alert_count--;
+        monitor->dropped++;
+    }
+    OverstayAlert *alert = &monitor->alerts[(monitor->first_alert +
+                                monitor->alert_count) % OVERSTAY_LOG_SIZE];
+    alert->plate = pack_license_plate(node->record.license_plate);
+    alert->park_id = park_id;
+    alert->in_minute = date_to_minutes(*node->record.in_date);
+    monitor->alert_count++;
+}
+
+// Puts a timer due after the clock in the slot of the highest group of
+// bits in which its due minute differs from the clock
+static void insert_timer(OverstayMonitor *monitor, OverstayTimer *timer) {
+    unsigned long long differ = (unsigned long long)(timer->due ^
+                                                        monitor->now);
+    int level = (63 - __builtin_clzll(differ)) / WHEEL_SLOT_BITS;
+    int slot = (timer->due >> (level * WHEEL_SLOT_BITS)) & (WHEEL_SLOTS - 1);
+    timer->slot = level * WHEEL_SLOTS + slot;
+    timer->prev = NULL;
+    timer->next = monitor->slots[timer->slot];
+    if (timer->next != NULL) {
+        timer->next->prev = timer;
+    }
+    monitor->slots[timer->slot] = timer;
+    monitor->occupied[level] |= 1ull << slot;
+}
+
+// Takes a timer out of its slot
+static void unlink_timer(OverstayMonitor *monitor, OverstayTimer *timer) {
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        monitor->slots[timer->slot] = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    if (monitor->slots[timer->slot] == NULL) {
+        monitor->occupied[timer->slot / WHEEL_SLOTS] &=
+            ~(1ull << (timer->slot % WHEEL_SLOTS));
+    }
+}
+
+// Gives a timer back to the pool, detaching it from its record
+static void free_timer(OverstayMonitor *monitor, OverstayTimer *timer) {
+    timer->record->timer = NULL;
+    pool_free(&monitor->timers, timer);
+    monitor->pending--;
+}
+
+void set_overstay_threshold(OverstayMonitor *monitor, int threshold) {
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SLOTS; i++) {
+        while (monitor->slots[i] != NULL) {
+            OverstayTimer *timer = monitor->slots[i];
+            unlink_timer(monitor, timer);
+            free_timer(monitor, timer);
+        }
+    }
+    monitor->threshold = threshold;
+}
+
+int watch_stay(OverstayMonitor *monitor, RecordNode *node, int park_id) {
+    node->timer = NULL;
+    if (monitor->threshold == OVERSTAY_OFF) {
+        return 1;
+    }
+    long long due = date_to_minutes(*node->record.in_date) +
+                    monitor->threshold;
+    if (due <= monitor->now) {
+        raise_alert(monitor, node, park_id);
+        return 1;
+    }
+    OverstayTimer *timer = (OverstayTimer *)pool_alloc(&monitor->timers);
+    if (timer == NULL) {
+        return 0; // Memory allocation failed
+    }
+    timer->record = node;
+    timer->due = due;
+    timer->park_id = park_id;
+    insert_timer(monitor, timer);
+    node->timer = timer;
+    monitor->pending++;
+    return 1;
+}
+
+void unwatch_stay(OverstayMonitor *monitor, RecordNode *node) {
+    if (node->timer != NULL) {
+        unlink_timer(monitor, node->timer);
+        free_timer(monitor, node->timer);
+    }
+}
+
+// Finds the first slot after the clock that holds timers and the minute it
+// starts at, returning 0 if there is none
+static int next_slot(const OverstayMonitor *monitor, int *slot,
+                        long long *start) {
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = level * WHEEL_SLOT_BITS;
+        int group = (monitor->now >> shift) & (WHEEL_SLOTS - 1);
+        // Slots up to the group of the clock hold nothing at this level
+        uint64_t later = group == WHEEL_SLOTS - 1 ? 0 :
+                        monitor->occupied[level] & (~0ull << (group + 1));
+        if (later != 0) {
+            int found = __builtin_ctzll(later);
+            long long above = monitor->now >> (shift + WHEEL_SLOT_BITS)
+                                << (shift + WHEEL_SLOT_BITS);
+            *slot = level * WHEEL_SLOTS + found;
+            *start = above | ((long long)found << shift);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void advance_overstay(OverstayMonitor *monitor, long long minute) {
+    while (monitor->pending > 0 && monitor->now < minute) {
+        int slot;
+        long long start;
+        if (!next_slot(monitor, &slot, &start) || start > minute) {
+            break;
+        }
+        // Lower levels are empty, so every timer of the slot is due from
+        // its start on: it fires or moves down
+        monitor->now = start;
+        OverstayTimer *timer = monitor->slots[slot];
+        monitor->slots[slot] = NULL;
+        monitor->occupied[slot / WHEEL_SLOTS] &=
+            ~(1ull << (slot % WHEEL_SLOTS));
+        while (timer != NULL) {
+            OverstayTimer *next = timer->next;
+            if (timer->due == monitor->now) {
+                raise_alert(monitor, timer->record, timer->park_id);
+                free_timer(monitor, timer);
+            } else {
+                insert_timer(monitor, timer);
+            }
+            timer = next;
+        }
+    }
+    if (minute > monitor->now) {
+        monitor->now = minute;
+    }
+}
+
+const OverstayAlert *overstay_alert(const OverstayMonitor *monitor,
+                                    int index) {
+    return &monitor->alerts[(monitor->first_alert + index) %
+                            OVERSTAY_LOG_SIZE];
+}
+
+void clear_overstay_alerts(OverstayMonitor *monitor) {
+    monitor->first_alert = 0;
+    monitor->alert_count = 0;
+    monitor->dropped = 0;
+}
+
+void destroy_overstay_monitor(OverstayMonitor *monitor) {
+    destroy_node_pool(&monitor->timers);
+    free(monitor->alerts);
+    monitor->alerts = NULL;
+    monitor->alert_count = 0;
+    monitor->pending = 0;
+}
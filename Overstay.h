@@ -0,0 +1,137 @@
+#ifndef OVERSTAY_H
+#define OVERSTAY_H
+
+#include <stdint.h>
+#include "Pool.h"
+#include "Records.h"
+
+// Levels of the timing wheel; 9 levels of 64 slots cover 2^54 minutes,
+// more than any date with an int year
+#define WHEEL_LEVELS 9
+// Bits of a minute that select the slot of a level
+#define WHEEL_SLOT_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+// Threshold of a monitor that watches no stay
+#define OVERSTAY_OFF 0
+// Most alerts kept until they are read; older ones are dropped
+#define OVERSTAY_LOG_SIZE 1024
+
+/**
+ * @struct OverstayTimer
+ * @brief Timer of one open stay, in a slot of the timing wheel.
+ */
+typedef struct OverstayTimer {
+    struct OverstayTimer *prev;     // Timers of the same slot
+    struct OverstayTimer *next;
+    RecordNode *record;             // Open record watched; points back to it
+    long long due;                  // Minute the stay overstays at
+    int slot;                       // Index in the slots of the wheel
+    int park_id;
+} OverstayTimer;
+
+/**
+ * @struct OverstayAlert
+ * @brief A vehicle that stayed in a park past the threshold.
+ */
+typedef struct {
+    uint64_t plate;         // See pack_license_plate
+    int park_id;
+    long long in_minute;    // Entry of the stay (see date_to_minutes)
+} OverstayAlert;
+
+/**
+ * @struct OverstayMonitor
+ * @brief Hierarchical timing wheel of the open stays of every park.
+ *
+ * A timer is kept at the level of the highest group of WHEEL_SLOT_BITS
+ * bits in which its due minute differs from the clock, in the slot given
+ * by that group of its due minute. When the clock reaches the start of a
+ * slot, its timers fire or move down to lower levels, so each timer moves
+ * at most WHEEL_LEVELS times; a bitmap of the non-empty slots of each level
+ * lets the clock jump straight to the next one.
+ *
+ * The clock is the latest entry or exit minute of the whole network, since
+ * each park only orders its own events.
+ */
+typedef struct {
+    OverstayTimer *slots[WHEEL_LEVELS * WHEEL_SLOTS];
+    uint64_t occupied[WHEEL_LEVELS];    // Bit s: slot s of the level is used
+    long long now;          // Clock of the wheel, in minutes
+    int threshold;          // Minutes a stay may last, or OVERSTAY_OFF
+    int pending;            // Timers in the wheel
+    NodePool timers;
+    OverstayAlert *alerts;  // Ring of the alerts not read yet
+    int first_alert;
+    int alert_count;
+    int dropped;            // Alerts dropped since they were last read
+} OverstayMonitor;
+
+/**
+ * Initializes a monitor that watches no stay.
+ *
+ * @param monitor The monitor to be initialized.
+ */
+void init_overstay_monitor(OverstayMonitor *monitor);
+
+/**
+ * Changes the threshold, dropping every timer; the open stays have to be
+ * watched again.
+ *
+ * @param monitor The monitor.
+ * @param threshold The minutes a stay may last, or OVERSTAY_OFF.
+ */
+void set_overstay_threshold(OverstayMonitor *monitor, int threshold);
+
+/**
+ * Starts the timer of an open stay, or raises its alert right away if it
+ * is already past the threshold. Does nothing while the monitor is off.
+ *
+ * @param monitor The monitor.
+ * @param node The node of the open record; its timer is set.
+ * @param park_id The id of the park of the stay.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int watch_stay(OverstayMonitor *monitor, RecordNode *node, int park_id);
+
+/**
+ * Cancels the timer of a stay, if it has one, in O(1).
+ *
+ * @param monitor The monitor.
+ * @param node The node of the record.
+ */
+void unwatch_stay(OverstayMonitor *monitor, RecordNode *node);
+
+/**
+ * Moves the clock forward, raising the alerts of the stays that reach the
+ * threshold. A minute before the clock leaves it unchanged.
+ *
+ * @param monitor The monitor.
+ * @param minute The minute of an entry or exit.
+ */
+void advance_overstay(OverstayMonitor *monitor, long long minute);
+
+/**
+ * Gets one of the alerts not read yet, oldest first.
+ *
+ * @param monitor The monitor.
+ * @param index From 0 to alert_count - 1.
+ * @return The alert.
+ */
+const OverstayAlert *overstay_alert(const OverstayMonitor *monitor,
+                                    int index);
+
+/**
+ * Marks every alert as read.
+ *
+ * @param monitor The monitor.
+ */
+void clear_overstay_alerts(OverstayMonitor *monitor);
+
+/**
+ * Frees the memory of a monitor.
+ *
+ * @param monitor The monitor.
+ */
+void destroy_overstay_monitor(OverstayMonitor *monitor);
+
+#endif /* OVERSTAY_H */
@@ -9,6 +9,9 @@
 #include "Park.h"
 #include "Records.h" // Include Records.h for ParkRecord structure and hash functions
 #include "Date.h"
+#include "Snapshot.h"
+#include "Kernels.h"
+#include "Names.h"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 
@@ -27,14 +30,27 @@ Park *create_park(const char *name, int capacity, float price_15,
     }
     strcpy(park->name, name);
     park->capacity = capacity;
-    park->available_spots = capacity;
     park->price_15 = price_15;
     park->price_15_1h = price_15_1h;
     park->price_1h = price_1h;
     park->id = id;
+    park->handle = NO_HANDLE; // Given by add_park
     park->records_map = create_hash_map();
-    park->lastDate = NULL;
-    if(park->records_map == NULL){
+    park->snapshot_records = NULL;
+    park->snapshot_record_count = 0;
+    init_history(&park->history);
+    park->archived_count = 0;
+    park->archive_links = NULL;
+    park->linked_rows = 0;
+    init_daily_revenue(&park->revenue);
+    init_daily_dwell(&park->dwell);
+    init_occupancy(&park->occupancy);
+    park->priced_rows = 0;
+    int zones_ready = init_zone_tree(&park->zones, capacity);
+    if(park->records_map == NULL || !zones_ready ||
+        !init_tariff_plan(&park->tariffs, price_15, price_15_1h, price_1h)){
+        destroy_zone_tree(&park->zones);
+        destroy_records_in_park(park);
         free(park->name);
         free(park);
         return NULL;
@@ -42,34 +58,19 @@ Park *create_park(const char *name, int capacity, float price_15,
     return park;
 }
 
-void print_park(Park *park) {
-    printf("%s ", park->name);
-    printf("%d ", park->capacity);
-    printf("%d\n", park->available_spots);
+HashMap *get_records_map(Park *park) {
+    if (park->snapshot_records != NULL) {
+        materialize_snapshot_records(park);
+    }
+    return park->records_map;
 }
 
 void destroy_records_in_park(Park *park) {
     if (park == NULL || park->records_map == NULL) {
         return;
     }
-
-    for (int i = 0; i < park->records_map->size; i++) {
-        HashNode *current = park->records_map->buckets[i];
-        while (current != NULL) {
-            RecordNode *record_current = current->records;
-            while (record_current != NULL) {
-                RecordNode *temp = record_current;
-                record_current = record_current->next;
-                free(temp);  // Free each RecordNode individually
-            }
-            // Move to the next HashNode without freeing it
-            HashNode *temp = current;
-            current = current->next;
-            free(temp);  // Free the HashNode once all records are freed
-        }
-    }
-    free(park->records_map->buckets);
-    free(park->records_map);
+    // Every node of the map comes from its pools
+    destroy_hash_map(park->records_map);
 }
 
 void destroy_records_for_license_plate(Park *park, const char *license_plate) {
@@ -90,7 +91,7 @@ void destroy_records_for_license_plate(Park *park, const char *license_plate) {
             while (record_current != NULL) {
                 RecordNode *temp = record_current;
                 record_current = record_current->next;
-                free(temp);
+                free_record_node(park->records_map, temp);
             }
             current->records = NULL; // Reset records pointer
             // Remove the hash node if there are no more records associated 
@@ -100,7 +101,7 @@ void destroy_records_for_license_plate(Park *park, const char *license_plate) {
             } else {
                 prev->next = current->next;
             }
-            free(current);
+            free_vehicle_node(park->records_map, current);
             return;
         }
         prev = current;
@@ -108,6 +109,75 @@ void destroy_records_for_license_plate(Park *park, const char *license_plate) {
     }
 }
 
+// Gets the tariff that charges a stay: the prices of the zone of its spot,
+// if it has its own, or else the tariff of the park at its entry
+static const Tariff *stay_tariff(Park *park, int spot, int in_minute) {
+    const Tariff *tariff = zone_tariff(&park->zones, spot);
+    return tariff != NULL ? tariff : tariff_at(&park->tariffs, in_minute);
+}
+
+int add_closed_record(Park *park, const ParkRecord *record) {
+    long long in_time = date_to_minutes(*record->in_date);
+    long long out_time = date_to_minutes(*record->out_date);
+    int in_minute = saturate_minute(in_time);
+    int out_minute = saturate_minute(out_time);
+    long long cents = record->cost_cents;
+    if (!append_history(&park->history,
+                        pack_license_plate(record->license_plate),
+                        in_minute, out_minute, cents,
+                        record->pass != NO_PASS ? PASS_TARIFF_ID :
+                        stay_tariff(park, record->spot, in_minute)->id)) {
+        return 0; // Memory allocation failed
+    }
+    if (park->priced_rows == park->history.count - 1) {
+        park->priced_rows++; // Priced right now, by the current tariffs
+    }
+    int indexed = add_daily_revenue(&park->revenue,
+                                    out_minute / MINUTES_PER_DAY, cents);
+    return add_daily_dwell(&park->dwell, out_minute / MINUTES_PER_DAY,
+                            saturate_minute(out_time - in_time)) && indexed;
+}
+
+// Frees the records at the head of a vehicle's list that ended before the
+// horizon; they are already in the history of the park
+static int drop_vehicle_records(HashMap *map, HashNode *node, int horizon) {
+    int archived = 0;
+    // Stays of a vehicle never overlap, so the closed records that ended
+    // before the horizon are always the first ones of its list
+    while (node->records != NULL && node->records->record.out_date != NULL &&
+            date_to_minutes(*node->records->record.out_date) < horizon) {
+        RecordNode *oldest = node->records;
+        node->records = oldest->next;
+        free_record_node(map, oldest);
+        archived++;
+    }
+    return archived;
+}
+
+int compact_park_records(Park *park, int horizon) {
+    HashMap *records_map = get_records_map(park);
+    int archived = 0;
+    for (int i = 0; i < records_map->size; i++) {
+        HashNode **link = &records_map->buckets[i];
+        while (*link != NULL) {
+            HashNode *node = *link;
+            archived += drop_vehicle_records(records_map, node, horizon);
+            if (node->records == NULL) {
+                *link = node->next; // Every record of the vehicle archived
+                free_vehicle_node(records_map, node);
+            } else {
+                link = &node->next;
+            }
+        }
+    }
+    // The history is sorted by exit, so the dropped records are its prefix
+    int prefix = history_lower_bound(&park->history, horizon);
+    if (prefix > park->archived_count) {
+        park->archived_count = prefix;
+    }
+    return archived;
+}
+
 int isLeapYear(int year){
     if(year % 4 == 0){
         if(year % 100 == 0){
@@ -121,22 +191,23 @@ int isLeapYear(int year){
     return 0;
 };
 
-float calculate_cost(Park* park, Date* in_date, Date* out_date){
+// Calculates the cost of a stay by the given tariff, in cents
+static long long tariff_cost(const Tariff* tariff, Date* in_date, Date* out_date){
 
-    int total_minutes = minutes_between_dates(*out_date, *in_date);
+    long long total_minutes = minutes_between_dates(*out_date, *in_date);
 
-    float X = park->price_15;
-    float Y = park->price_15_1h;
-    float Z = park->price_1h;
+    float X = tariff->price_15;
+    float Y = tariff->price_15_1h;
+    float Z = tariff->price_1h;
 
     // Total number of minutes in a day
     int total_minutes_in_day = 24 * 60;
 
     // Calculate the number of days
-    int days = total_minutes / total_minutes_in_day;
+    long long days = total_minutes / total_minutes_in_day;
 
     // Calculate the remaining minutes
-    int remaining_minutes = total_minutes % total_minutes_in_day;
+    int remaining_minutes = (int)(total_minutes % total_minutes_in_day);
 
     // Calculate the number of 15 minute intervals
     float intervals = ceil(remaining_minutes / 15.);
@@ -181,202 +252,128 @@ float calculate_cost(Park* park, Date* in_date, Date* out_date){
             }
         }
     }
-    return total_cost - count * Z;
+    return cost_to_cents(total_cost - count * Z);
 }
 
-void destroy_park(Park *park) {
-    if (park == NULL) {
-        return;
-    }
-    free(park->name);
-    destroyDate(park->lastDate);
-
-    destroy_records_in_park(park);
+long long calculate_cost(Park* park, int spot, Date* in_date, Date* out_date){
+    int in_minute = saturate_minute(date_to_minutes(*in_date));
+    const Tariff *tariff = stay_tariff(park, spot, in_minute);
+    return tariff_cost(tariff, in_date, out_date);
 }
 
-// Function to compare dates
-int compare_dates(const void *a, const void *b) {
-    const Date *date1 = (const Date *)a;
-    const Date *date2 = (const Date *)b;
-
-    // Compare years
-    if (date1->year != date2->year)
-        return date1->year - date2->year;
-
-    // Compare months
-    if (date1->month != date2->month)
-        return date1->month - date2->month;
-
-    // Compare days
-    if (date1->day != date2->day)
-        return date1->day - date2->day;
-
-    // Compare hours
-    if (date1->hour != date2->hour)
-        return date1->hour - date2->hour;
-
-    // Compare minutes
-    return date1->minute - date2->minute;
+int add_park_zone(Park *park, const Zone *zone) {
+    return add_zone(&park->zones, zone);
 }
 
-// Bubble sort implementation for sorting dates
-void bubble_sort_dates(Date *dates, int num_dates) {
-    int i, j;
-    for (i = 0; i < num_dates - 1; i++) {
-        for (j = 0; j < num_dates - i - 1; j++) {
-            // Compare two consecutive dates
-            if (compare_dates(&dates[j], &dates[j + 1]) > 0) {
-                // Swap the dates if they are in the wrong order
-                Date temp = dates[j];
-                dates[j] = dates[j + 1];
-                dates[j + 1] = temp;
-            }
-        }
+int set_park_tariff(Park *park, Tariff *tariff) {
+    if (!set_tariff(&park->tariffs, tariff)) {
+        return 0;
     }
-}
-
-void get_cost_records_per_park(Park* park) {
-    // Allocate memory for the dates array
-    int num_dates = 0; // Actual number of different dates
-    Date *dates = (Date *)malloc(sizeof(Date) * park->records_map->size);
-
-    // Initialize the dates array
-    for (int i = 0; i < park->records_map->size; i++) {
-        dates[i].day = 0;
-        dates[i].month = 0;
-        dates[i].year = 0;
-        dates[i].cost = 0.0;
+    // Stays that left before the change also entered before it
+    int first = history_lower_bound(&park->history, tariff->from_minute);
+    if (first < park->priced_rows) {
+        park->priced_rows = first;
     }
+    return 1;
+}
 
-    // Iterate through the records and update the dates array
-    for (int i = 0; i < park->records_map->size; i++) {
-        HashNode *current = park->records_map->buckets[i];
-        while (current != NULL) {
-            RecordNode *record_current = current->records;
-            while (record_current != NULL) {
-                if (record_current->record.out_date != NULL) {
-                    int found = 0;
-                    for (int j = 0; j < num_dates; j++) {
-                        if (dates[j].day == record_current->record.out_date->day &&
-                            dates[j].month == record_current->record.out_date->month &&
-                            dates[j].year == record_current->record.out_date->year) {
-                            dates[j].cost += record_current->record.cost;
-                            found = 1;
-                            break;
-                        }
-                    }
-                    if (!found) {
-                        dates[num_dates].day = record_current->record.out_date->day;
-                        dates[num_dates].month = record_current->record.out_date->month;
-                        dates[num_dates].year = record_current->record.out_date->year;
-                        dates[num_dates].cost += record_current->record.cost;
-                        num_dates++;
-                    }
-                }
-                record_current = record_current->next;
+int reprice_park(Park *park, NetworkRevenue *network) {
+    History *history = &park->history;
+    int first_changed = -1;
+    int repriced = 0;
+    for (int i = park->priced_rows; i < history->count; i++) {
+        if (history->tariff_ids[i] < 0) {
+            continue; // Zone and pass prices never change
+        }
+        const Tariff *tariff = tariff_at(&park->tariffs,
+                                            history->in_minutes[i]);
+        if (history->tariff_ids[i] == tariff->id) {
+            continue;
+        }
+        if (first_changed < 0) {
+            if (!own_history(history)) {
+                return 0; // Memory allocation failed
             }
-            current = current->next;
+            first_changed = i;
         }
+        Date in_date = minutes_to_date(history->in_minutes[i]);
+        Date out_date = minutes_to_date(history->out_minutes[i]);
+        long long cents = tariff_cost(tariff, &in_date, &out_date);
+        add_network_revenue(network, history->out_minutes[i] /
+                            MINUTES_PER_DAY, cents - history->cost_cents[i]);
+        history->cost_cents[i] = cents;
+        history->tariff_ids[i] = tariff->id;
+        repriced++;
     }
-
-    // Sort dates array based on date values
-    bubble_sort_dates(dates, num_dates);
-
-    // Print the Dates and the total cost
-    for (int i = 0; i < num_dates; i++) {
-        printf("%02d-%02d-%d %.2f\n", dates[i].day, dates[i].month,
-        dates[i].year, dates[i].cost);
+    if (first_changed >= 0) {
+        // Rebuild the daily sums from the day of the first changed stay on
+        int day = history->out_minutes[first_changed] / MINUTES_PER_DAY;
+        truncate_daily_revenue(&park->revenue, day);
+        for (int i = history_lower_bound(history, day * MINUTES_PER_DAY);
+                i < history->count; i++) {
+            add_daily_revenue(&park->revenue,
+                                history->out_minutes[i] / MINUTES_PER_DAY,
+                                history->cost_cents[i]);
+        }
     }
-
-    // Free allocated memory
-    free(dates);
+    park->priced_rows = history->count;
+    return repriced;
 }
 
-void get_cost_records_for_date(Park* park, Date* date) {
-    // Allocate memory for the dates array
-    int num_dates = 0; // Actual number of different dates
-    Date* dates = (Date*)malloc(sizeof(Date) * park->records_map->size);
-    if (dates == NULL) {
-        // Handle memory allocation failure
-        fprintf(stderr, "Memory allocation failed\n");
+void destroy_park(Park *park) {
+    if (park == NULL) {
         return;
     }
+    free(park->name);
+    destroy_tariff_plan(&park->tariffs);
+    destroy_zone_tree(&park->zones);
+    destroy_history(&park->history);
+    free(park->archive_links);
+    park->archive_links = NULL;
+    park->linked_rows = 0;
+    destroy_daily_revenue(&park->revenue);
+    destroy_daily_dwell(&park->dwell);
+    destroy_occupancy(&park->occupancy);
 
-    // Initialize the dates array
-    for (int i = 0; i < park->records_map->size; i++) {
-        dates[i].day = 0;
-        dates[i].month = 0;
-        dates[i].year = 0;
-        dates[i].hour = 0;
-        dates[i].minute = 0;
-        dates[i].cost = 0.0;
-        // Assuming license_plate is a string, allocate memory and copy it
-        dates[i].license_plate = strdup("");
-        if (dates[i].license_plate == NULL) {
-            // Handle memory allocation failure
-            fprintf(stderr, "Memory allocation failed\n");
-            // Free previously allocated memory
-            for (int j = 0; j < num_dates; j++) {
-                free(dates[j].license_plate);
-            }
-            free(dates);
-            return;
-        }
-    }
-
-    // Traverse the records map to find records for the given date
-    for (int i = 0; i < park->records_map->size; i++) {
-        HashNode* current = park->records_map->buckets[i];
-        while (current != NULL) {
-            RecordNode* record_current = current->records;
-            while (record_current != NULL) {
-                if (record_current->record.out_date != NULL &&
-                    record_current->record.out_date->day == date->day &&
-                    record_current->record.out_date->month == date->month &&
-                    record_current->record.out_date->year == date->year) {
-                    
-                    // Update the date
-                    dates[num_dates].day = record_current->record.out_date->day;
-                    dates[num_dates].month = record_current->record.out_date->month;
-                    dates[num_dates].year = record_current->record.out_date->year;
-                    dates[num_dates].hour = record_current->record.out_date->hour;
-                    dates[num_dates].minute = record_current->record.out_date->minute;
-                    dates[num_dates].cost = record_current->record.cost;
-                    // Copy license_plate
-                    free(dates[num_dates].license_plate); // Free previously allocated memory
-                    dates[num_dates].license_plate = strdup(record_current->record.license_plate);
-                    if (dates[num_dates].license_plate == NULL) {
-                        // Handle memory allocation failure
-                        fprintf(stderr, "Memory allocation failed\n");
-                        // Free allocated memory before returning
-                        for (int j = 0; j < num_dates; j++) {
-                            free(dates[j].license_plate);
-                        }
-                        free(dates);
-                        return;
-                    }
-                    num_dates++;
-                }
-                record_current = record_current->next;
-            }
-            current = current->next;
-        }
-    }
-
-    // Sort dates array based on date and time values
-    bubble_sort_dates(dates, num_dates);
+    destroy_records_in_park(park);
+}
 
-    // Print the License Plates, Dates, and the total cost
-    for (int i = 0; i < num_dates; i++) {
-        printf("%s ", dates[i].license_plate);
-        // Print date and time
-        printf("%02d:%02d ", dates[i].hour, dates[i].minute);
-        printf("%.2f\n", dates[i].cost);
+void get_cost_records_per_park(Park* park, FILE *out) {
+    const History *history = &park->history;
+    int i = 0;
+    // Rows are sorted by exit, so the exits of each day are contiguous
+    while (i < history->count) {
+        int day_start = history->out_minutes[i] / MINUTES_PER_DAY *
+                        MINUTES_PER_DAY;
+        RangeTotal total = kernel_range_total(history->out_minutes + i,
+                                                history->cost_cents + i,
+                                                history->count - i, day_start,
+                                                day_start + MINUTES_PER_DAY);
+        Date date = minutes_to_date(day_start);
+        fprintf(out, "%02d-%02d-%d ", date.day, date.month, date.year);
+        print_cents(total.cents, out);
+        fprintf(out, "\n");
+        i += total.count;
     }
+}
 
-    // Free allocated memory
-    for (int i = 0; i < num_dates; i++) {
-        free(dates[i].license_plate);
+void get_cost_records_for_date(Park* park, Date* date, FILE *out) {
+    const History *history = &park->history;
+    Date start = *date;
+    start.hour = 0;
+    start.minute = 0;
+    int day_start = saturate_minute(date_to_minutes(start)) /
+                    MINUTES_PER_DAY * MINUTES_PER_DAY;
+
+    char license_plate[LICENSE_PLATE_SIZE];
+    for (int i = history_lower_bound(history, day_start);
+            i < history->count &&
+            history->out_minutes[i] < day_start + MINUTES_PER_DAY; i++) {
+        unpack_license_plate(history->plates[i], license_plate);
+        fprintf(out, "%s ", license_plate);
+        printTime(minutes_to_date(history->out_minutes[i]), out);
+        fprintf(out, " ");
+        print_cents(history->cost_cents[i], out);
+        fprintf(out, "\n");
     }
-    free(dates);
 }
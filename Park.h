@@ -4,20 +4,42 @@
 #include <stdlib.h>
 #include "Records.h" // Include Records.h for ParkRecord structure
 #include "Date.h"
-
+#include "History.h"
+#include "Revenue.h"
+#include "Dwell.h"
+#include "Occupancy.h"
+#include "Tariff.h"
+#include "Zones.h"
+
+// Cold part of a park: its available spots and the minute of its last event
+// are kept by the Parks struct, in arrays indexed by the park handle
 typedef struct Park{
     char* name;
     int capacity;
-    int available_spots;
-    float price_15;
+    float price_15;     // Prices it was created with
     float price_15_1h;
     float price_1h;
+    TariffPlan tariffs; // Every tariff, by the entry minute it applies from
+    ZoneTree zones;     // Its zones and which of their spots are free
 
     HashMap *records_map;
 
     int id;
-
-    Date *lastDate;  // Pointer to Date for lastDateIn
+    int handle;      // Index in the Parks struct and in its name table
+
+    History history;    // Every closed record, in exit order
+    int archived_count; // Leading rows of history no longer in records_map
+    int *archive_links; // Next archived row of the same vehicle, or NO_ROW
+    int linked_rows;    // Leading rows of history chained in archive_links
+    DailyRevenue revenue; // Prefix sums of the daily revenue of history
+    DailyDwell dwell;     // Histograms of the stay lengths of each day
+    Occupancy occupancy;  // Every entry and exit, in event order
+    int priced_rows;      // Leading rows of history priced by their tariff
+
+    // Records still held by a mapped snapshot, moved into records_map on
+    // first use (NULL once materialized)
+    const void *snapshot_records;
+    int snapshot_record_count;
 } Park;
 
 
@@ -37,11 +59,15 @@ Park* create_park(const char *name, int capacity, float price_15,
 
 
 /**
- * Prints the details of a park.
+ * Gets the hash map with the records of a park.
  *
- * @param park A pointer to the Park structure to be printed.
+ * Records restored from a snapshot are only materialized here, the first
+ * time they are needed; every access to the records should go through it.
+ *
+ * @param park A pointer to the Park structure.
+ * @return The hash map with all the records of the park.
  */
-void print_park(Park* park);
+HashMap *get_records_map(Park *park);
 
 
 /**
@@ -67,17 +93,85 @@ void destroy_records_in_park(Park *park);
 void destroy_records_for_license_plate(Park *park, const char *license_plate);
 
 
+/**
+ * Adds a record that has just been closed to the history of a park, to its
+ * daily revenue and to the histogram of its stay lengths.
+ *
+ * @param park The park.
+ * @param record The closed record, with its exit date and cost set.
+ * @return 1 on success, 0 if memory allocation failed: either no history
+ * row was added, or the row was added but is missing from the daily
+ * revenue or stay lengths.
+ */
+int add_closed_record(Park *park, const ParkRecord *record);
+
+
+/**
+ * Removes from the hash map of a park the closed records that ended before
+ * the horizon, leaving them only in its history.
+ *
+ * Vehicles left without records in the hash map are removed from it.
+ *
+ * @param park The park to be compacted.
+ * @param horizon Minute (see date_to_minutes) before which a closed record is
+ * archived.
+ * @return The number of records archived.
+ */
+int compact_park_records(Park *park, int horizon);
+
+
+/**
+ * Adds a zone to a park that has no vehicle inside.
+ *
+ * @param park The park.
+ * @param zone The zone, named by its path from the park.
+ * @return ZONE_OK or the reason it was refused (see add_zone).
+ */
+int add_park_zone(Park *park, const Zone *zone);
+
+
+/**
+ * Changes the tariff of a park from a given minute on.
+ *
+ * Stays that entered from that minute on are charged by the new tariff.
+ * The closed ones are only re-priced when a query needs their cost (see
+ * reprice_park). The prices the park was created with are kept.
+ *
+ * @param park The park.
+ * @param tariff The new prices and the entry minute they apply from.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int set_park_tariff(Park *park, Tariff *tariff);
+
+
+/**
+ * Re-prices the closed stays of a park whose tariff changed since they
+ * were priced, updating its daily revenue and the network revenue.
+ *
+ * Only the rows after the earliest tariff change are looked at, and only
+ * those whose tariff version differs are priced again.
+ *
+ * @param park The park.
+ * @param network The network revenue index.
+ * @return The number of stays re-priced.
+ */
+int reprice_park(Park *park, NetworkRevenue *network);
+
+
 /**
  * Calculates the cost of parking at the specified park for the given in and
- * out dates.
+ * out dates, by the prices of the zone of the spot if it has its own, or
+ * else by the tariff of the park in force at the in date.
  *
  * @param park      The park for which to calculate the cost.
+ * @param spot      The spot the vehicle took.
  * @param in_date   The date and time the vehicle entered the park.
  * @param out_date  The date and time the vehicle exited the park.
  *
- * @return The cost of parking at the park for the specified duration.
+ * @return The cost of parking at the park for the specified duration, in
+ * cents.
  */
-float calculate_cost(Park* park, Date* in_date, Date* out_date);
+long long calculate_cost(Park* park, int spot, Date* in_date, Date* out_date);
 
 
 /**
@@ -96,23 +190,25 @@ void destroy_park(Park *park);
  *
  * This function retrieves the cost records for a specific date in the park.
  * The cost records include information about the expenses and revenues for
- * that date.
+ * that date. Only the columnar history is scanned.
  *
  * @param park The park for which to retrieve the cost records.
  * @param date The date for which to retrieve the cost records.
+ * @param out The stream the records are printed to.
  */
-void get_cost_records_for_date(Park* park, Date* date);
+void get_cost_records_for_date(Park* park, Date* date, FILE *out);
 
 
 /**
  * Calculates the cost of records per park.
  *
  * This function takes a pointer to a Park structure and calculates the cost of
- * records per park.
+ * records per park, scanning only its columnar history.
  *
  * @param park A pointer to a Park structure.
+ * @param out The stream the costs are printed to.
  * @return The cost of records per park as a float value.
  */
-void get_cost_records_per_park(Park* park);
+void get_cost_records_per_park(Park* park, FILE *out);
 
 #endif /* PARK_H */
@@ -5,20 +5,43 @@
 */
 #include "Parks.h"
 #include "Park.h"
+#include "Snapshot.h"
+#include "Billing.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 
 Parks *create_parks() {
-    Parks *parking_lots = (Parks *)malloc(sizeof(Parks));
+    Parks *parking_lots = (Parks *)calloc(1, sizeof(Parks));
     if (parking_lots == NULL) {
         return NULL; // Memory allocation failed
     }
     parking_lots->size = 0;
     parking_lots->capacity = MAX_LOTS;
+    parking_lots->lowest_free = 0;
     parking_lots->parks_id = 0;
+    parking_lots->snapshot = NULL;
+    parking_lots->snapshot_size = 0;
+    init_network_revenue(&parking_lots->revenue);
+    init_leaderboards(&parking_lots->boards);
+    parking_lots->boards_stale = 0;
+    init_reclaimer(&parking_lots->reclaimer);
+    init_worker_pool(&parking_lots->workers);
+    init_overstay_monitor(&parking_lots->overstay);
+    init_pass_registry(&parking_lots->passes);
+    parking_lots->billing = NULL;
     parking_lots->parks = (Park **)calloc(MAX_LOTS, sizeof(Park *));
-    if (parking_lots->parks == NULL) {
-        free(parking_lots);
+    parking_lots->free_spots = (int *)calloc(MAX_LOTS, sizeof(int));
+    parking_lots->last_minutes = (long long *)calloc(MAX_LOTS,
+                                                        sizeof(long long));
+    parking_lots->ids = (int *)calloc(MAX_LOTS, sizeof(int));
+    parking_lots->by_id = (int *)calloc(MAX_LOTS, sizeof(int));
+    if (parking_lots->parks == NULL || parking_lots->free_spots == NULL ||
+        parking_lots->last_minutes == NULL || parking_lots->ids == NULL ||
+        parking_lots->by_id == NULL ||
+        !init_name_table(&parking_lots->names, MAX_LOTS) ||
+        !init_vehicle_index(&parking_lots->vehicles, MAX_LOTS)) {
+        free_parks(parking_lots);
         return NULL; // Memory allocation failed
     }
     for (int i = 0; i < MAX_LOTS; i++) {
@@ -27,162 +50,281 @@ Parks *create_parks() {
     return parking_lots;
 }
 
+// Position of the first park in by_id whose id is not below the given one
+static int id_rank(const Parks* parks, int id) {
+    int low = 0;
+    int high = parks->size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (parks->ids[parks->by_id[middle]] < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
 void add_park(Parks* parks, Park* park){
     if (parks->size >= parks->capacity) {
         return; // Maximum lots reached
     }
 
-    for (int i = 0; i < parks->capacity; i++) {
+    for (int i = parks->lowest_free; i < parks->capacity; i++) {
         if (parks->parks[i] == NULL) {
+            parks->lowest_free = i + 1;
             parks->parks[i] = park;
+            park->handle = i;
+            intern_name(&parks->names, park->name, i);
+            parks->free_spots[i] = park->capacity;
+            parks->last_minutes[i] = NO_MINUTE;
+            parks->ids[i] = park->id;
+            // New parks have the largest id, so this is usually an append
+            int rank = id_rank(parks, park->id);
+            memmove(parks->by_id + rank + 1, parks->by_id + rank,
+                    (parks->size - rank) * sizeof(int));
+            parks->by_id[rank] = i;
             parks->size++;
             return;
         }
     }
 }
 
-void remove_park(Parks* parks, const char* park_name) {
-    for (int i = 0; i < parks->size; i++) {
-        if (strcmp(parks->parks[i]->name, park_name) == 0) {
-            destroy_park(parks->parks[i]);
-            free(parks->parks[i]);
-            parks->parks[i] = parks->parks[parks->size - 1];
-            parks->parks[parks->size - 1] = NULL;
-            parks->size--;
-            break;
-        }
+// Adds one row of the history of a park to the leaderboards
+static void add_row_to_leaderboards(Parks* parks, const History* history,
+                                    int row) {
+    add_leaderboard_stay(&parks->boards, history->plates[row],
+                            saturate_minute((long long)history->out_minutes[row]
+                                            - history->in_minutes[row]),
+                            history->cost_cents[row]);
+}
+
+int add_park_exit(Parks* parks, Park* park, const ParkRecord* record) {
+    const History *history = &park->history;
+    int row = history->count;
+    int recorded = add_closed_record(park, record);
+    if (history->count == row) {
+        return 0; // No row to index
     }
+    recorded = add_network_revenue(&parks->revenue,
+                                    history->out_minutes[row] /
+                                    MINUTES_PER_DAY,
+                                    history->cost_cents[row]) && recorded;
+    add_row_to_leaderboards(parks, history, row);
+    topk_offer(&parks->boards.lots, park->id, history->count);
+    return recorded;
 }
 
-Park* get_park(Parks* parks, char* name){
-    for (int i = 0; i < parks->capacity; i++) {
-        if (parks->parks[i] != NULL && strcmp(parks->parks[i]->name, name) == 0) {
-            return parks->parks[i];
-        }
+void index_park_history(Parks* parks, Park* park) {
+    const History *history = &park->history;
+    for (int i = 0; i < history->count; i++) {
+        int day = history->out_minutes[i] / MINUTES_PER_DAY;
+        add_daily_revenue(&park->revenue, day, history->cost_cents[i]);
+        add_daily_dwell(&park->dwell, day,
+                        saturate_minute((long long)history->out_minutes[i] -
+                                        history->in_minutes[i]));
+        add_network_revenue(&parks->revenue, day, history->cost_cents[i]);
+        add_row_to_leaderboards(parks, history, i);
+    }
+    if (history->count > 0) {
+        topk_offer(&parks->boards.lots, park->id, history->count);
     }
-    return NULL;
 }
 
-void print_parks(Parks* parks){
-    for (int i = 0; i < parks->capacity; i++) {
-        if (parks->parks[i] != NULL) {
-            print_park(parks->parks[i]);
+int link_archived_rows(Parks* parks, Park* park, int end) {
+    if (end <= park->linked_rows) {
+        return 1;
+    }
+    int *links = (int *)realloc(park->archive_links, end * sizeof(int));
+    if (links == NULL) {
+        return 0; // Memory allocation failed
+    }
+    park->archive_links = links;
+    while (park->linked_rows < end) {
+        int row = park->linked_rows;
+        if (!archive_vehicle_row(&parks->vehicles, park->history.plates[row],
+                                    park->handle, row, links, &parks->names)) {
+            return 0;
         }
+        park->linked_rows++;
     }
+    return 1;
 }
 
-void free_parks(Parks* parks) {
-    if (parks == NULL) {
-        return;
+int compact_park(Parks* parks, Park* park, int horizon) {
+    int first = park->archived_count;
+    if (!link_archived_rows(parks, park,
+                            history_lower_bound(&park->history, horizon))) {
+        return 0;
     }
-    for (int i = 0; i < parks->size; i++) {
-        if (parks->parks[i] != NULL) {
-            destroy_park(parks->parks[i]);
+    compact_park_records(park, horizon);
+    // Vehicles left without records in the park no longer visit it
+    HashMap *map = get_records_map(park);
+    char license_plate[LICENSE_PLATE_SIZE];
+    for (int i = first; i < park->archived_count; i++) {
+        uint64_t plate = park->history.plates[i];
+        unpack_license_plate(plate, license_plate);
+        if (get_records(map, license_plate) == NULL) {
+            drop_vehicle_visit(&parks->vehicles, plate, park->handle);
         }
     }
-    free(parks->parks);
-    free(parks);
+    return 1;
 }
 
-// Helper function to compare two park names
-int compare_names(const char *a, const char *b) {
-    return strcmp(a, b);
+int reserve_park_stays(Parks* parks, Park* park, int stays, int days) {
+    HashMap *map = get_records_map(park);
+    // Every stay keeps its record, a history row and two occupancy events
+    return map != NULL && reserve_pool(&map->record_nodes, stays) &&
+            reserve_history(&park->history, park->history.count + stays) &&
+            reserve_occupancy(&park->occupancy,
+                                park->occupancy.count + 2 * stays) &&
+            reserve_daily_revenue(&park->revenue, park->revenue.count + days) &&
+            reserve_daily_dwell(&park->dwell, park->dwell.count + days) &&
+            reserve_network_revenue(&parks->revenue,
+                                    parks->revenue.count + days);
 }
 
-// Function to return a list of park names ordered alphabetically
-char** get_park_names_ordered(Parks* parks, int* count) {
-    char** names = (char**)malloc(parks->size * sizeof(char*));
-    if (names == NULL) {
-        *count = 0;
-        return NULL; // Memory allocation failed
-    }
-
-    *count = 0;
+// Rebuilds the leaderboards from the histories of the remaining parks, as
+// a sketch cannot forget the stays of a removed park
+static void rebuild_leaderboards(Parks* parks) {
+    parks->boards_stale = 0;
+    init_leaderboards(&parks->boards);
     for (int i = 0; i < parks->capacity; i++) {
-        if (parks->parks[i] != NULL) {
-            // Allocate memory for the name and copy it
-            names[*count] = strdup(parks->parks[i]->name);
-            if (names[*count] == NULL) {
-                // Memory allocation failed, clean up and return
-                for (int j = 0; j < *count; j++) {
-                    free(names[j]);
-                }
-                free(names);
-                *count = 0;
-                return NULL;
-            }
-            (*count)++;
+        Park *park = parks->parks[i];
+        if (park == NULL) {
+            continue;
         }
-    }
-
-    // Sort the names alphabetically using bubble sort
-    for (int i = 0; i < *count - 1; i++) {
-        for (int j = 0; j < *count - i - 1; j++) {
-            if (compare_names(names[j], names[j + 1]) > 0) {
-                char* temp = names[j];
-                names[j] = names[j + 1];
-                names[j + 1] = temp;
-            }
+        for (int row = 0; row < park->history.count; row++) {
+            add_row_to_leaderboards(parks, &park->history, row);
+        }
+        if (park->history.count > 0) {
+            topk_offer(&parks->boards.lots, park->id, park->history.count);
         }
     }
+}
 
-    return names;
+void price_park(Parks* parks, Park* park) {
+    if (park->priced_rows < park->history.count &&
+        reprice_park(park, &parks->revenue) > 0) {
+        parks->boards_stale = 1; // The sketch cannot take costs back
+    }
 }
 
-// Function to free memory allocated for the list of park names
-void free_park_names(char** names, int count) {
-    if (names != NULL) {
-        for (int i = 0; i < count; i++) {
-            free(names[i]);
+void price_parks(Parks* parks) {
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            price_park(parks, parks->parks[i]);
         }
-        free(names);
     }
 }
 
-// Function to return a list of parks ordered by ID
-Park** get_parks_ordered_by_id(Parks* parks, int* count) {
-    // Allocate memory for an array of park pointers
-    Park** ordered_parks = (Park**)malloc(parks->size * sizeof(Park*));
-    if (ordered_parks == NULL) {
-        *count = 0;
-        return NULL; // Memory allocation failed
+const Leaderboards* get_leaderboards(Parks* parks) {
+    price_parks(parks);
+    if (parks->boards_stale) {
+        rebuild_leaderboards(parks);
     }
+    return &parks->boards;
+}
 
-    // Initialize ordered_parks array to NULL
-    for (int i = 0; i < parks->size; i++) {
-        ordered_parks[i] = NULL;
+// Takes the revenue of a park out of the network wide index
+static void remove_park_revenue(Parks* parks, Park* park) {
+    const DailyRevenue *revenue = &park->revenue;
+    for (int i = 0; i < revenue->count; i++) {
+        long long before = i > 0 ? revenue->prefix[i - 1] : 0;
+        add_network_revenue(&parks->revenue, revenue->days[i],
+                            before - revenue->prefix[i]);
     }
+}
 
-    // Fill the array with park pointers
-    *count = 0;
-    for (int i = 0; i < parks->capacity; i++) {
-        if (parks->parks[i] != NULL && parks->parks[i]->name != NULL) {
-            ordered_parks[*count] = parks->parks[i];
-            (*count)++;
-        }
+// Cancels the overstay timers of the vehicles inside a park; records still
+// in a snapshot have none, since watching them materializes them
+static void unwatch_park_stays(Parks *parks, Park *park) {
+    if (parks->overstay.pending == 0 || park->snapshot_records != NULL) {
+        return;
     }
-
-    // Sort the parks by ID using bubble sort
-    for (int i = 0; i < *count - 1; i++) {
-        for (int j = 0; j < *count - i - 1; j++) {
-            if (ordered_parks[j]->id > ordered_parks[j + 1]->id) {
-                Park* temp = ordered_parks[j];
-                ordered_parks[j] = ordered_parks[j + 1];
-                ordered_parks[j + 1] = temp;
+    HashMap *map = park->records_map;
+    for (int i = 0; i < map->size; i++) {
+        for (HashNode *node = map->buckets[i]; node != NULL;
+                node = node->next) {
+            for (RecordNode *rec = node->records; rec != NULL;
+                    rec = rec->next) {
+                unwatch_stay(&parks->overstay, rec);
             }
         }
     }
+}
 
-    return ordered_parks;
+void remove_park(Parks* parks, const char* park_name) {
+    int handle = find_name(&parks->names, park_name);
+    if (handle == NO_HANDLE) {
+        return;
+    }
+    Park *park = parks->parks[handle];
+    remove_park_revenue(parks, park);
+    unwatch_park_stays(parks, park);
+    forget_park_vehicles(&parks->vehicles, handle);
+    release_name(&parks->names, handle);
+    int rank = id_rank(parks, park->id);
+    memmove(parks->by_id + rank, parks->by_id + rank + 1,
+            (parks->size - rank - 1) * sizeof(int));
+    parks->parks[handle] = NULL;
+    if (handle < parks->lowest_free) {
+        parks->lowest_free = handle;
+    }
+    parks->size--;
+    parks->boards_stale = 1;
+    reclaim_park(&parks->reclaimer, park);
 }
 
-// Function to free memory allocated for the list of parks
-void free_ordered_parks(Park** parks) {
-    free(parks);
+Park* get_park(Parks* parks, char* name){
+    int handle = find_name(&parks->names, name);
+    return handle == NO_HANDLE ? NULL : parks->parks[handle];
+}
+
+Park* get_park_by_rank(Parks* parks, int rank){
+    return parks->parks[parks->names.ordered[rank]];
+}
+
+Park* get_park_by_id(Parks* parks, int id){
+    int rank = id_rank(parks, id);
+    if (rank < parks->size && parks->ids[parks->by_id[rank]] == id) {
+        return parks->parks[parks->by_id[rank]];
+    }
+    return NULL;
 }
 
-void print_park_names_ordered_by_id(Park** ordered_parks, int count) {
-    for (int i = 0; i < count; i++) {
-        print_park(ordered_parks[i]);
+void print_parks(Parks* parks, FILE *out){
+    for (int i = 0; i < parks->size; i++) {
+        int handle = parks->by_id[i];
+        Park *park = parks->parks[handle];
+        fprintf(out, "%s %d %d\n", park->name, park->capacity,
+                parks->free_spots[handle]);
     }
 }
+
+void free_parks(Parks* parks) {
+    if (parks == NULL) {
+        return;
+    }
+    stop_reclaimer(&parks->reclaimer);
+    stop_worker_pool(&parks->workers);
+    for (int i = 0; parks->parks != NULL && i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            destroy_park(parks->parks[i]);
+            free(parks->parks[i]);
+        }
+    }
+    release_snapshot(parks);
+    destroy_network_revenue(&parks->revenue);
+    destroy_name_table(&parks->names);
+    destroy_vehicle_index(&parks->vehicles);
+    destroy_overstay_monitor(&parks->overstay);
+    destroy_pass_registry(&parks->passes);
+    destroy_network_billing(parks);
+    free(parks->parks);
+    free(parks->free_spots);
+    free(parks->last_minutes);
+    free(parks->ids);
+    free(parks->by_id);
+    free(parks);
+}
@@ -2,8 +2,20 @@
 #define PARKS_H
 
 #include "Park.h"
-
+#include "Revenue.h"
+#include "Leaderboard.h"
+#include "Names.h"
+#include "Vehicles.h"
+#include "Reclaim.h"
+#include "Workers.h"
+#include "Overstay.h"
+#include "Passes.h"
+
+#ifndef MAX_LOTS
 #define MAX_LOTS 20
+#endif
+// Last event minute of a park that has had no entry or exit yet
+#define NO_MINUTE -1
 
 /**
  * @struct Parks
@@ -13,11 +25,35 @@
  * It can be used to represent various attributes of a park.
  */
 typedef struct Parks{
-    Park** parks;
+    Park** parks;           // Indexed by park handle, NULL if free
     int size;
     int capacity;
 
+    // Hot state of the parks, in parallel arrays indexed by park handle, so
+    // scans of the whole registry do not load the Park structs
+    int *free_spots;        // Available spots of each park
+    long long *last_minutes;    // Minute of its last entry or exit, or
+                                // NO_MINUTE
+    int *ids;               // Id of each park
+    int *by_id;             // Handles of the parks, in id order
+    int lowest_free;        // No handle below it is free
+
     int parks_id;
+
+    void *snapshot;         // Mapped snapshot backing unmaterialized records
+    size_t snapshot_size;
+
+    NetworkRevenue revenue; // Daily revenue of every park
+    Leaderboards boards;    // Top spenders, longest stays and busiest parks
+    int boards_stale;       // Whether boards still count a removed park
+    NameTable names;        // Park names, interned to the park handles
+    VehicleIndex vehicles;  // Parks each vehicle is inside and has visited
+    Reclaimer reclaimer;    // Frees removed parks in the background
+    WorkerPool workers;     // Threads of the network wide reports
+    OverstayMonitor overstay; // Timers of the open stays
+    PassRegistry passes;    // Monthly passes and contracts
+    struct BillingOutput *billing;  // Buffers of the billing report, kept
+                                    // between reports (see Billing.h)
 } Parks;
 
 
@@ -29,7 +65,8 @@ typedef struct Parks{
 Parks* create_parks();
 
 /**
- * Adds a park to the parks collection.
+ * Adds a park to the parks collection, interning its name and giving it the
+ * lowest free handle.
  *
  * @param parks The pointer to the Parks struct.
  * @param park The pointer to the Park struct to be added.
@@ -37,97 +74,146 @@ Parks* create_parks();
 void add_park(Parks* parks, Park* park);
 
 /**
- * Removes a park from the parks collection.
+ * Records the exit of a vehicle in the history of its park, in the revenue
+ * indexes and in the leaderboards.
  *
  * @param parks The pointer to the Parks struct.
- * @param name The name of the park to be removed.
+ * @param park The park the vehicle left.
+ * @param record The closed record, with its exit date and cost set.
+ * @return 1 on success, 0 if memory allocation failed (see
+ * add_closed_record); without a history row nothing else is indexed.
  */
-void remove_park(Parks* parks, const char* name);
+int add_park_exit(Parks* parks, Park* park, const ParkRecord* record);
 
 /**
- * Gets a park from the parks collection.
+ * Rebuilds the revenue indexes, the stay length histograms and the
+ * leaderboards of a park from the rows of its history.
  *
  * @param parks The pointer to the Parks struct.
- * @param name The name of the park to be retrieved.
- * @return A pointer to the Park struct if found, NULL otherwise.
+ * @param park The park, whose daily revenue and histograms must be empty.
  */
-Park* get_park(Parks* parks, char* name);
+void index_park_history(Parks* parks, Park* park);
 
 /**
- * Prints the details of all parks in the parks collection.
+ * Chains the history rows of a park up to a given one into the archived
+ * rows of their vehicles (see archive_vehicle_row), so that v finds them
+ * once they are archived.
  *
  * @param parks The pointer to the Parks struct.
+ * @param park The park.
+ * @param end The first row left out.
+ * @return 1 on success, 0 if memory allocation failed; the rows chained
+ * so far stay chained.
  */
-void print_parks(Parks* parks);
+int link_archived_rows(Parks* parks, Park* park, int end);
 
 /**
- * Frees the memory allocated for the Parks struct.
+ * Archives the closed records of a park that ended before the horizon:
+ * chains their history rows to their vehicles and only then removes them
+ * from the hash map of the park (see compact_park_records).
  *
- * @param parks The pointer to the Parks struct to be freed.
+ * @param parks The pointer to the Parks struct.
+ * @param park The park.
+ * @param horizon Minute (see date_to_minutes) before which a closed record
+ * is archived.
+ * @return 1 on success, 0 if memory allocation failed, in which case no
+ * record is removed.
  */
-void free_parks(Parks* parks);
+int compact_park(Parks* parks, Park* park, int horizon);
 
+/**
+ * Makes room in a park and in the network indexes for a number of stays
+ * ending on a number of new days, so that the entries and exits of those
+ * stays, and the billing reports, do not touch the heap. Vehicles new to
+ * the park or to the network still grow their indexes.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param park The park.
+ * @param stays The number of stays to come.
+ * @param days The number of days, not yet in the park, they end on.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_park_stays(Parks* parks, Park* park, int stays, int days);
+
+/**
+ * Re-prices the closed stays of a park after a tariff change (see
+ * reprice_park), keeping the network indexes up to date.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param park The park.
+ */
+void price_park(Parks* parks, Park* park);
 
 /**
- * Compares two names.
+ * Re-prices the closed stays of every park after tariff changes.
  *
- * This function compares two names, `a` and `b`, and returns an integer value
- * indicating their relative order. The comparison is case-sensitive.
+ * @param parks The pointer to the Parks struct.
+ */
+void price_parks(Parks* parks);
+
+/**
+ * Gets the leaderboards, first rebuilding them from the remaining parks if
+ * a park was removed or re-priced since they were last read.
  *
- * @param a The first name to compare.
- * @param b The second name to compare.
- * @return An integer value less than, equal to, or greater than zero if `a` is
- *         found, respectively, to be less than, equal to, or greater than `b`.
+ * @param parks The pointer to the Parks struct.
+ * @return The leaderboards.
  */
-int compare_names(const char *a, const char *b);
+const Leaderboards* get_leaderboards(Parks* parks);
 
 /**
- * Frees the memory allocated for an array of park names.
+ * Removes a park from the parks collection.
+ *
+ * The park is unlinked in time independent of the size of its history:
+ * its memory is freed by the reclaimer thread and the leaderboards are
+ * only rebuilt when next read.
  *
- * @param names The array of park names to be freed.
- * @param count The number of park names in the array.
+ * @param parks The pointer to the Parks struct.
+ * @param name The name of the park to be removed.
  */
-void free_park_names(char** names, int count);
+void remove_park(Parks* parks, const char* name);
 
 /**
- * Gets an array of park names ordered by name.
+ * Gets a park from the parks collection.
  *
  * @param parks The pointer to the Parks struct.
- * @param count A pointer to an integer to store the number of park names.
- * @return An array of park names ordered by name.
+ * @param name The name of the park to be retrieved.
+ * @return A pointer to the Park struct if found, NULL otherwise.
  */
-char** get_park_names_ordered(Parks* parks, int* count);
+Park* get_park(Parks* parks, char* name);
 
 /**
- * Compares the ids of the parks for sort.
+ * Gets the park with the given rank in name order.
  *
- * @param names The array of park names to be printed.
- * @param count The number of park names in the array.
+ * @param parks The pointer to the Parks struct.
+ * @param rank The rank, from 0 to the number of parks - 1.
+ * @return A pointer to the Park struct.
  */
-int compare_ids(const void *a, const void *b);
+Park* get_park_by_rank(Parks* parks, int rank);
 
 /**
- * Gets an array of parks ordered by id.
+ * Gets a park from the parks collection by its id.
  *
  * @param parks The pointer to the Parks struct.
- * @param count A pointer to an integer to store the number of parks.
- * @return An array of parks ordered by id.
+ * @param id The id of the park to be retrieved.
+ * @return A pointer to the Park struct if found, NULL otherwise.
  */
-Park** get_parks_ordered_by_id(Parks* parks, int* count);
+Park* get_park_by_id(Parks* parks, int id);
 
 /**
- * Frees the memory allocated for an array of parks.
+ * Prints the name, capacity and available spots of every park, in id
+ * order.
  *
- * @param parks The array of parks to be freed.
+ * @param parks The pointer to the Parks struct.
+ * @param out The stream printed to.
  */
-void free_ordered_parks(Park** parks);
+void print_parks(Parks* parks, FILE *out);
 
 /**
- * Prints the names of the parks in the given array.
+ * Frees the memory allocated for the Parks struct.
  *
- * @param ordered_parks The array of park names to be printed.
- * @param count The number of park names in the array.
+ * @param parks The pointer to the Parks struct to be freed.
  */
-void print_park_names_ordered_by_id(Park** ordered_parks, int count);
+void free_parks(Parks* parks);
+
 
 #endif /* PARKS_H */
@@ -0,0 +1,389 @@
+/**
+ * File containing the implementation of the registry of monthly passes and
+ * contracts, compiled into a minimal perfect hash.
+ * @file Passes.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "Passes.h"
+#include "Records.h"
+#include "Invariants.h"
+
+// Size of the buffer of a line of a pass file
+#define PASS_LINE_SIZE 128
+// Multiplier that mixes the seed of a bucket into the hash of a plate
+#define PASS_SEED_MIX 0x9E3779B97F4A7C15ull
+
+// Scrambles the bits of a plate code (splitmix64 finalizer)
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Maps a hash onto 0 .. range - 1 with a multiplication, not a division
+static int reduce(uint64_t hash, int range) {
+    return (int)(((hash >> 32) * (uint64_t)range) >> 32);
+}
+
+// Slot of a plate, given its hash and the seed of its bucket
+static int slot_of(const PassTable *table, uint64_t hash, uint32_t seed) {
+    if (seed & PASS_DIRECT) {
+        return seed & ~PASS_DIRECT;
+    }
+    return reduce(mix(hash + seed * PASS_SEED_MIX), table->count);
+}
+
+void init_pass_registry(PassRegistry *registry) {
+    registry->current = NULL;
+    registry->loading = 0;
+    registry->done = 0;
+    registry->ready = NULL;
+    registry->path = NULL;
+    registry->failed_path = NULL;
+}
+
+// Frees a table
+static void free_pass_table(PassTable *table) {
+    if (table != NULL) {
+        free(table->seeds);
+        free(table->entries);
+        free(table);
+    }
+}
+
+// Orders passes by plate, the smallest percent first
+static int compare_passes(const void *a, const void *b) {
+    const PassEntry *x = (const PassEntry *)a;
+    const PassEntry *y = (const PassEntry *)b;
+    if (x->plate != y->plate) {
+        return x->plate < y->plate ? -1 : 1;
+    }
+    return x->percent - y->percent;
+}
+
+// Reads a pass file, keeping the smallest percent of a plate listed twice;
+// returns NULL if a line is invalid or memory allocation failed
+static PassEntry *read_pass_file(const char *path, int *count) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+    int capacity = PASS_BUCKET_KEYS;
+    PassEntry *passes = (PassEntry *)malloc(capacity * sizeof(PassEntry));
+    char line[PASS_LINE_SIZE];
+    char plate[PASS_LINE_SIZE];
+    char extra;
+    int percent;
+    *count = 0;
+    while (passes != NULL && fgets(line, sizeof(line), file) != NULL) {
+        int fields = sscanf(line, "%127s %d %c", plate, &percent, &extra);
+        if (fields <= 0) {
+            continue; // Blank line
+        }
+        if (fields != 2 || !isValidLicensePlate(plate) || percent < 0 ||
+            percent > 100) {
+            free(passes);
+            passes = NULL;
+            break;
+        }
+        if (*count == capacity) {
+            capacity *= 2;
+            PassEntry *grown = (PassEntry *)realloc(passes, capacity *
+                                                    sizeof(PassEntry));
+            if (grown == NULL) {
+                free(passes);
+                passes = NULL;
+                break; // Memory allocation failed
+            }
+            passes = grown;
+        }
+        passes[*count].plate = pack_license_plate(plate);
+        passes[*count].percent = percent;
+        passes[*count].reserved = 0;
+        (*count)++;
+    }
+    fclose(file);
+    if (passes == NULL) {
+        return NULL;
+    }
+    qsort(passes, *count, sizeof(PassEntry), compare_passes);
+    int unique = 0;
+    for (int i = 0; i < *count; i++) {
+        if (unique == 0 || passes[unique - 1].plate != passes[i].plate) {
+            passes[unique++] = passes[i];
+        }
+    }
+    *count = unique;
+    return passes;
+}
+
+// Finds a seed that sends every plate of a bucket to a distinct free slot,
+// taking those slots; members are indices into passes
+static int place_bucket(PassTable *table, const PassEntry *passes,
+                        const uint64_t *hashes, const int *members, int size,
+                        char *taken, int bucket) {
+    int slots[size];
+    for (uint32_t seed = 0; seed < PASS_MAX_SEEDS; seed++) {
+        int placed = 0;
+        while (placed < size) {
+            int slot = slot_of(table, hashes[members[placed]], seed);
+            if (taken[slot]) {
+                break;
+            }
+            taken[slot] = 1;
+            slots[placed++] = slot;
+        }
+        if (placed == size) {
+            table->seeds[bucket] = seed;
+            for (int i = 0; i < size; i++) {
+                table->entries[slots[i]] = passes[members[i]];
+            }
+            return 1;
+        }
+        while (placed > 0) {
+            taken[slots[--placed]] = 0;
+        }
+    }
+    return 0;
+}
+
+// Places every pass with the salt of the table: the buckets with the most
+// plates first, by seed search, and the single ones straight into the free
+// slots left
+static int place_passes(PassTable *table, const PassEntry *passes,
+                        uint64_t *hashes, int *buckets, int *starts,
+                        int *members, int *order, char *taken) {
+    int count = table->count;
+    int bucket_count = table->bucket_count;
+    memset(starts, 0, (bucket_count + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        hashes[i] = mix(passes[i].plate ^ table->salt);
+        buckets[i] = reduce(hashes[i], bucket_count);
+        starts[buckets[i] + 1]++;
+    }
+    int largest = 0;
+    for (int b = 0; b < bucket_count; b++) {
+        if (starts[b + 1] > largest) {
+            largest = starts[b + 1];
+        }
+        starts[b + 1] += starts[b];
+    }
+    // Members of each bucket, contiguous; order[] fills them
+    for (int b = 0; b < bucket_count; b++) {
+        order[b] = starts[b];
+    }
+    for (int i = 0; i < count; i++) {
+        members[order[buckets[i]]++] = i;
+    }
+    for (int i = 0; i < count; i++) {
+        taken[i] = 0;
+    }
+    for (int size = largest; size >= 2; size--) {
+        for (int b = 0; b < bucket_count; b++) {
+            if (starts[b + 1] - starts[b] == size &&
+                !place_bucket(table, passes, hashes, members + starts[b],
+                                size, taken, b)) {
+                return 0;
+            }
+        }
+    }
+    int free_slot = 0;
+    for (int b = 0; b < bucket_count; b++) {
+        int size = starts[b + 1] - starts[b];
+        if (size == 0) {
+            table->seeds[b] = 0;
+        } else if (size == 1) {
+            while (taken[free_slot]) {
+                free_slot++;
+            }
+            taken[free_slot] = 1;
+            table->seeds[b] = PASS_DIRECT | free_slot;
+            table->entries[free_slot] = passes[members[starts[b]]];
+        }
+    }
+    return 1;
+}
+
+// Reads and compiles a pass file, returning NULL if it is invalid or
+// memory allocation failed
+static PassTable *build_pass_table(const char *path) {
+    int count;
+    PassEntry *passes = read_pass_file(path, &count);
+    if (passes == NULL) {
+        return NULL;
+    }
+    PassTable *table = (PassTable *)malloc(sizeof(PassTable));
+    int bucket_count = (count + PASS_BUCKET_KEYS - 1) / PASS_BUCKET_KEYS;
+    int slots = count > 0 ? count : 1;
+    uint64_t *hashes = (uint64_t *)malloc(slots * sizeof(uint64_t));
+    int *buckets = (int *)malloc(slots * sizeof(int));
+    int *starts = (int *)malloc((bucket_count + 1) * sizeof(int));
+    int *members = (int *)malloc(slots * sizeof(int));
+    int *order = (int *)malloc((bucket_count + 1) * sizeof(int));
+    char *taken = (char *)malloc(slots);
+    int ok = table != NULL && hashes != NULL && buckets != NULL &&
+                starts != NULL && members != NULL && order != NULL &&
+                taken != NULL;
+    if (ok) {
+        table->count = count;
+        table->bucket_count = bucket_count;
+        table->seeds = (uint32_t *)malloc((bucket_count + 1) *
+                                            sizeof(uint32_t));
+        table->entries = (PassEntry *)malloc(slots * sizeof(PassEntry));
+        ok = table->seeds != NULL && table->entries != NULL;
+        if (!ok) {
+            free_pass_table(table);
+            table = NULL;
+        }
+    }
+    // A few buckets may find no seed; another salt moves every plate
+    int placed = 0;
+    for (int salt = 0; ok && !placed && salt < PASS_MAX_SALTS; salt++) {
+        table->salt = mix(salt + 1);
+        placed = place_passes(table, passes, hashes, buckets, starts,
+                                members, order, taken);
+    }
+    if (ok && !placed) {
+        free_pass_table(table);
+        table = NULL;
+    } else if (!ok) {
+        free(table);
+        table = NULL;
+    }
+    free(passes);
+    free(hashes);
+    free(buckets);
+    free(starts);
+    free(members);
+    free(order);
+    free(taken);
+    return table;
+}
+
+// Body of the loader thread
+static void *run_pass_loader(void *argument) {
+    PassRegistry *registry = (PassRegistry *)argument;
+    registry->ready = build_pass_table(registry->path);
+    __atomic_store_n(&registry->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int load_passes(PassRegistry *registry, const char *path) {
+    finish_pass_load(registry, 0);
+    if (registry->loading) {
+        return 0;
+    }
+    registry->path = (char *)malloc(strlen(path) + 1);
+    if (registry->path == NULL) {
+        return 0; // Memory allocation failed
+    }
+    strcpy(registry->path, path);
+    registry->ready = NULL;
+    registry->done = 0;
+    // Signals keep going to the thread that waits for them
+    sigset_t all_signals;
+    sigset_t previous;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+    int started = pthread_create(&registry->thread, NULL, run_pass_loader,
+                                    registry) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (!started) {
+        free(registry->path);
+        registry->path = NULL;
+        return 0;
+    }
+    registry->loading = 1;
+    return 1;
+}
+
+void finish_pass_load(PassRegistry *registry, int wait) {
+    if (!registry->loading ||
+        (!wait && !__atomic_load_n(&registry->done, __ATOMIC_ACQUIRE))) {
+        return;
+    }
+    pthread_join(registry->thread, NULL);
+    registry->loading = 0;
+    free(registry->failed_path);
+    registry->failed_path = NULL;
+    if (registry->ready != NULL) {
+        free_pass_table(registry->current);
+        registry->current = registry->ready;
+        registry->ready = NULL;
+        free(registry->path);
+    } else {
+        registry->failed_path = registry->path;
+    }
+    registry->path = NULL;
+}
+
+int pass_percent(PassRegistry *registry, uint64_t plate) {
+    if (registry->loading) {
+        finish_pass_load(registry, 0);
+    }
+    const PassTable *table = registry->current;
+    if (table == NULL || table->count == 0) {
+        return NO_PASS;
+    }
+    uint64_t hash = mix(plate ^ table->salt);
+    uint32_t seed = table->seeds[reduce(hash, table->bucket_count)];
+    const PassEntry *entry = &table->entries[slot_of(table, hash, seed)];
+    return entry->plate == plate ? entry->percent : NO_PASS;
+}
+
+int restore_pass_table(PassRegistry *registry, uint64_t salt,
+                        const uint32_t *seeds, int bucket_count,
+                        const PassEntry *entries, int count) {
+    if (count < 0 ||
+        bucket_count != (count + PASS_BUCKET_KEYS - 1) / PASS_BUCKET_KEYS) {
+        return 0;
+    }
+    PassTable *table = (PassTable *)malloc(sizeof(PassTable));
+    if (table == NULL) {
+        return 0; // Memory allocation failed
+    }
+    int slots = count > 0 ? count : 1;
+    table->seeds = (uint32_t *)malloc((bucket_count + 1) * sizeof(uint32_t));
+    table->entries = (PassEntry *)malloc(slots * sizeof(PassEntry));
+    if (table->seeds == NULL || table->entries == NULL) {
+        free_pass_table(table);
+        return 0; // Memory allocation failed
+    }
+    table->salt = salt;
+    table->bucket_count = bucket_count;
+    table->count = count;
+    memcpy(table->seeds, seeds, bucket_count * sizeof(uint32_t));
+    memcpy(table->entries, entries, count * sizeof(PassEntry));
+    int valid = 1;
+    for (int b = 0; valid && b < bucket_count; b++) {
+        valid = !(seeds[b] & PASS_DIRECT) ||
+                (int)(seeds[b] & ~PASS_DIRECT) < count;
+    }
+    for (int i = 0; valid && i < count; i++) {
+        uint64_t hash = mix(entries[i].plate ^ salt);
+        uint32_t seed = seeds[reduce(hash, bucket_count)];
+        valid = entries[i].percent >= 0 && entries[i].percent <= 100 &&
+                slot_of(table, hash, seed) == i;
+    }
+    if (!valid) {
+        free_pass_table(table);
+        return 0;
+    }
+    free_pass_table(registry->current);
+    registry->current = table;
+    return 1;
+}
+
+void destroy_pass_registry(PassRegistry *registry) {
+    finish_pass_load(registry, 1);
+    free_pass_table(registry->current);
+    free(registry->failed_path);
+    registry->current = NULL;
+    registry->failed_path = NULL;
+}
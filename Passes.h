@@ -0,0 +1,127 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+// Share of the price charged to a vehicle without a pass
+#define NO_PASS -1
+// Tariff id recorded in the history for stays priced by a pass, which are
+// not priced again when the tariffs change
+#define PASS_TARIFF_ID -2
+// Average number of plates per bucket of the displacement table
+#define PASS_BUCKET_KEYS 4
+// Seed flag of a bucket with a single plate, placed straight in the slot
+// given by the rest of the seed
+#define PASS_DIRECT 0x80000000u
+// Seeds tried for a bucket, and salts tried for the whole table, before
+// the build gives up
+#define PASS_MAX_SEEDS (1 << 20)
+#define PASS_MAX_SALTS 16
+
+/**
+ * @struct PassEntry
+ * @brief The pass of one plate.
+ */
+typedef struct {
+    uint64_t plate;         // See pack_license_plate
+    int32_t percent;        // Share of the regular price charged
+    int32_t reserved;
+} PassEntry;
+
+/**
+ * @struct PassTable
+ * @brief Minimal perfect hash of the plates with a pass.
+ *
+ * A plate hashes to a bucket, and the seed of its bucket then picks its
+ * slot among exactly count entries, with no two plates on the same slot.
+ * The seeds take 4 bytes per bucket, about one byte per pass, so the only
+ * cold memory a lookup touches is the 16-byte entry it compares against.
+ */
+typedef struct {
+    uint64_t salt;
+    uint32_t *seeds;
+    int bucket_count;
+    PassEntry *entries;
+    int count;
+} PassTable;
+
+/**
+ * @struct PassRegistry
+ * @brief The passes in force and the one being loaded.
+ *
+ * A pass file is read and compiled by a background thread; the engine keeps
+ * pricing with the current table and switches to the new one at its next
+ * lookup after the thread is done.
+ */
+typedef struct {
+    PassTable *current;     // NULL while no file was loaded
+    pthread_t thread;
+    int loading;            // Whether the thread was started and not joined
+    int done;               // Set by the thread once ready or failed is set
+    PassTable *ready;       // Table built by the thread, NULL on failure
+    char *path;             // File being loaded
+    char *failed_path;      // Last file that could not be loaded, or NULL
+} PassRegistry;
+
+/**
+ * Initializes a registry without passes.
+ *
+ * @param registry The registry to be initialized.
+ */
+void init_pass_registry(PassRegistry *registry);
+
+/**
+ * Starts loading a pass file in the background, one "<plate> <percent>"
+ * line per pass, the percent being the share of the regular price charged.
+ *
+ * @param registry The registry.
+ * @param path The path of the file.
+ * @return 1 if the load was started, 0 if another one is still running or
+ * the thread could not be started.
+ */
+int load_passes(PassRegistry *registry, const char *path);
+
+/**
+ * Finishes a background load that is done, switching to its table.
+ *
+ * @param registry The registry.
+ * @param wait Whether to wait for a load that is still running.
+ */
+void finish_pass_load(PassRegistry *registry, int wait);
+
+/**
+ * Replaces the passes in force with a copy of a compiled table, such as one
+ * saved in a snapshot, checking that every pass sits in the slot its plate
+ * leads to.
+ *
+ * @param registry The registry, with no load running.
+ * @param salt The salt of the table.
+ * @param seeds The seed of each bucket.
+ * @param bucket_count The number of buckets.
+ * @param entries The passes, by slot.
+ * @param count The number of passes.
+ * @return 1 on success, 0 if the table is inconsistent or memory allocation
+ * failed, in which case the registry is left as it was.
+ */
+int restore_pass_table(PassRegistry *registry, uint64_t salt,
+                        const uint32_t *seeds, int bucket_count,
+                        const PassEntry *entries, int count);
+
+/**
+ * Gets the pass of a plate.
+ *
+ * @param registry The registry.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @return The share of the regular price charged, in percent, or NO_PASS.
+ */
+int pass_percent(PassRegistry *registry, uint64_t plate);
+
+/**
+ * Waits for a running load and frees the memory of a registry.
+ *
+ * @param registry The registry.
+ */
+void destroy_pass_registry(PassRegistry *registry);
+
+#endif /* PASSES_H */
@@ -0,0 +1,262 @@
+/**
+ * File containing the implementation of the pipelined text mode, in which
+ * parsing, executing and printing the commands run on separate threads.
+ * @file Pipeline.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <pthread.h>
+#include "Pipeline.h"
+#include "parser.h"
+#include "Engine.h"
+#include "Invariants.h"
+#include "Alloc.h"
+
+// Polls of a cursor before a waiting stage gives up its processor
+#define PIPELINE_SPINS 64
+// Times a waiting stage gives up its processor before it sleeps
+#define PIPELINE_YIELDS 16
+
+// Whether the cursor of another stage has reached a value
+static int has_reached(const unsigned long long *cursor,
+                        unsigned long long value) {
+    return __atomic_load_n(cursor, __ATOMIC_SEQ_CST) >= value;
+}
+
+// Waits until the cursor of another stage reaches a value: polls first,
+// then sleeps until a cursor moves
+static void wait_for(Pipeline *pipeline, const unsigned long long *cursor,
+                        unsigned long long value) {
+    for (int yields = 0; yields < PIPELINE_YIELDS; yields++) {
+        for (int spins = 0; spins < PIPELINE_SPINS; spins++) {
+            if (has_reached(cursor, value)) {
+                return;
+            }
+        }
+        sched_yield();
+    }
+    pthread_mutex_lock(&pipeline->lock);
+    // Counted before the last check, so a stage that moves the cursor
+    // after it sees the sleeper and wakes it
+    __atomic_add_fetch(&pipeline->sleepers, 1, __ATOMIC_SEQ_CST);
+    while (!has_reached(cursor, value)) {
+        pthread_cond_wait(&pipeline->moved, &pipeline->lock);
+    }
+    __atomic_sub_fetch(&pipeline->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+// Marks the slots before a value as done by a stage, waking the stages
+// that sleep
+static void advance_cursor(Pipeline *pipeline, unsigned long long *cursor,
+                            unsigned long long value) {
+    __atomic_store_n(cursor, value, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pipeline->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pipeline->lock);
+        pthread_cond_broadcast(&pipeline->moved);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+}
+
+// Tokenizes a line and, for an entry or exit, checks its plate and date,
+// which depend on nothing but the line
+static void parse_slot(PipelineSlot *slot) {
+    slot->line[strcspn(slot->line, "\n")] = '\0';
+    slot->nargs = tokenize_input(slot->line, slot->args, PIPELINE_MAX_ARGS);
+    slot->last = slot->nargs > 0 && strcmp(slot->args[0], "q") == 0;
+    slot->kind = PIPELINE_COMMAND;
+    // An entry into a zone type takes the serial path
+    if (slot->nargs > 0 && ((strcmp(slot->args[0], "e") == 0 &&
+            slot->nargs == 5) ||
+            (strcmp(slot->args[0], "s") == 0 && slot->nargs >= 5))) {
+        slot->kind = PIPELINE_GATE;
+        slot->plate_valid = isValidLicensePlate(slot->args[2]);
+        slot->date_valid = isValidDate(slot->args[3]) &&
+                            isValidTime(slot->args[4]);
+        Date date = {0, 0, 0, 0, 0, 0, NULL};
+        sscanf(slot->args[3], "%d-%d-%d", &date.day, &date.month,
+                &date.year);
+        sscanf(slot->args[4], "%d:%d", &date.hour, &date.minute);
+        slot->date = date;
+    }
+}
+
+// Body of the parser thread
+static void *run_parser(void *argument) {
+    Pipeline *pipeline = (Pipeline *)argument;
+    for (unsigned long long next = 0; ; next++) {
+        if (next >= PIPELINE_SLOTS) {
+            wait_for(pipeline, &pipeline->formatted, next - PIPELINE_SLOTS + 1);
+        }
+        PipelineSlot *slot = &pipeline->slots[next % PIPELINE_SLOTS];
+        if (fgets(slot->line, PIPELINE_LINE_SIZE, pipeline->input) == NULL) {
+            slot->kind = PIPELINE_END;
+            slot->nargs = 0;
+            slot->last = 1;
+        } else {
+            parse_slot(slot);
+        }
+        advance_cursor(pipeline, &pipeline->parsed, next + 1);
+        if (slot->last) {
+            return NULL;
+        }
+    }
+}
+
+// Applies an entry or exit with the checks of enter_parking and
+// exit_parking, in the same order, keeping what the formatter prints
+static void execute_gate(Parks *parks, PipelineSlot *slot) {
+    Park *park = get_park(parks, slot->args[1]);
+    int entry = slot->args[0][0] == 'e';
+    if (park == NULL) {
+        slot->status = GATE_NO_SUCH_PARKING;
+    } else if (!slot->plate_valid) {
+        slot->status = GATE_INVALID_PLATE;
+    } else if (entry && (isParkFull(parks, park) ||
+                !has_free_zone_spot(&park->zones, ZONE_DEFAULT_TYPE))) {
+        slot->status = GATE_PARKING_FULL;
+    } else if (!slot->date_valid) {
+        slot->status = GATE_INVALID_DATE;
+    } else if (entry) {
+        slot->status = register_entry(parks, park, slot->args[2], slot->date,
+                                        ZONE_DEFAULT_TYPE, NULL);
+        slot->available_spots = parks->free_spots[park->handle];
+    } else {
+        ParkRecord *record = NULL;
+        slot->status = register_exit(parks, park, slot->args[2], slot->date,
+                                        &record);
+        if (slot->status == GATE_OK) {
+            strcpy(slot->license_plate, record->license_plate);
+            slot->in_date = *record->in_date;
+            slot->out_date = *record->out_date;
+            slot->cost_cents = record->cost_cents;
+        }
+    }
+}
+
+// Prints the outcome of an entry or exit as enter_parking and exit_parking
+// do
+static void format_gate(const PipelineSlot *slot, FILE *out) {
+    int entry = slot->args[0][0] == 'e';
+    if (slot->status == GATE_NO_SUCH_PARKING) {
+        fprintf(out, "%s: no such parking.\n", slot->args[1]);
+    } else if (slot->status == GATE_INVALID_PLATE) {
+        fprintf(out, "%s: invalid licence plate.\n", slot->args[2]);
+    } else if (slot->status == GATE_PARKING_FULL) {
+        fprintf(out, "%s: parking is full.\n", slot->args[1]);
+    } else if (slot->status == GATE_INVALID_DATE) {
+        fprintf(out, "invalid date.\n");
+    } else if (slot->status == GATE_INVALID_ENTRY) {
+        fprintf(out, "%s: invalid vehicle entry.\n", slot->args[2]);
+    } else if (slot->status == GATE_INVALID_EXIT) {
+        fprintf(out, "%s: invalid vehicle exit.\n", slot->args[2]);
+    } else if (slot->status == GATE_NO_MEMORY) {
+        fprintf(out, "Memory allocation failed.\n");
+    } else if (entry) {
+        fprintf(out, "%s %d\n", slot->args[1], slot->available_spots);
+    } else {
+        fprintf(out, "%s ", slot->license_plate);
+        printDate(slot->in_date, out);
+        fprintf(out, " ");
+        printTime(slot->in_date, out);
+        fprintf(out, " ");
+        printDate(slot->out_date, out);
+        fprintf(out, " ");
+        printTime(slot->out_date, out);
+        fprintf(out, " ");
+        print_cents(slot->cost_cents, out);
+        fprintf(out, "\n");
+    }
+}
+
+// Body of the formatter thread
+static void *run_formatter(void *argument) {
+    Pipeline *pipeline = (Pipeline *)argument;
+    for (unsigned long long next = 0; ; next++) {
+        wait_for(pipeline, &pipeline->executed, next + 1);
+        const PipelineSlot *slot = &pipeline->slots[next % PIPELINE_SLOTS];
+        if (slot->kind == PIPELINE_GATE) {
+            format_gate(slot, pipeline->output);
+        }
+        // The parser may reuse the slot as soon as the cursor moves
+        int last = slot->last;
+        advance_cursor(pipeline, &pipeline->formatted, next + 1);
+        if (last) {
+            return NULL;
+        }
+    }
+}
+
+int run_pipeline(Parks *parks, FILE *input, FILE *output) {
+    Pipeline pipeline;
+    pipeline.slots = (PipelineSlot *)malloc(PIPELINE_SLOTS *
+                                            sizeof(PipelineSlot));
+    if (pipeline.slots == NULL) {
+        return 0; // Memory allocation failed
+    }
+    pipeline.input = input;
+    pipeline.output = output;
+    pipeline.parsed = 0;
+    pipeline.executed = 0;
+    pipeline.formatted = 0;
+    pipeline.sleepers = 0;
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.moved, NULL);
+    // Signals keep going to the thread that waits for them
+    pthread_t parser;
+    pthread_t formatter;
+    sigset_t all_signals;
+    sigset_t previous;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+    int started = pthread_create(&formatter, NULL, run_formatter,
+                                    &pipeline) == 0;
+    if (started &&
+        pthread_create(&parser, NULL, run_parser, &pipeline) != 0) {
+        // Hand the formatter an end of input so that it stops
+        pipeline.slots[0].kind = PIPELINE_END;
+        pipeline.slots[0].last = 1;
+        advance_cursor(&pipeline, &pipeline.executed, 1);
+        pthread_join(formatter, NULL);
+        started = 0;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (!started) {
+        pthread_mutex_destroy(&pipeline.lock);
+        pthread_cond_destroy(&pipeline.moved);
+        free(pipeline.slots);
+        return 0;
+    }
+
+    int running = 1;
+    for (unsigned long long next = 0; running; next++) {
+        wait_for(&pipeline, &pipeline.parsed, next + 1);
+        PipelineSlot *slot = &pipeline.slots[next % PIPELINE_SLOTS];
+        if (slot->kind == PIPELINE_GATE) {
+            BEGIN_COMMAND_ALLOCATIONS();
+            execute_gate(parks, slot);
+            END_COMMAND_ALLOCATIONS(slot->args[0]);
+        } else {
+            // Its output goes after that of every earlier command
+            wait_for(&pipeline, &pipeline.formatted, next);
+            if (slot->kind == PIPELINE_COMMAND) {
+                BEGIN_COMMAND_ALLOCATIONS();
+                execute_command(parks, slot->args, slot->nargs,
+                                pipeline.output);
+                END_COMMAND_ALLOCATIONS(slot->nargs > 0 ? slot->args[0] :
+                                        NULL);
+            }
+        }
+        running = !slot->last;
+        advance_cursor(&pipeline, &pipeline.executed, next + 1);
+    }
+    pthread_join(parser, NULL);
+    pthread_join(formatter, NULL);
+    pthread_mutex_destroy(&pipeline.lock);
+    pthread_cond_destroy(&pipeline.moved);
+    free(pipeline.slots);
+    return 1;
+}
@@ -0,0 +1,85 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "Parks.h"
+#include "Records.h"
+
+// Slots of the ring shared by the stages, a power of two
+#define PIPELINE_SLOTS 128
+// Largest line read, as in the serial text mode
+#define PIPELINE_LINE_SIZE BUFSIZ
+// Largest number of arguments of a command, as in the serial text mode
+#define PIPELINE_MAX_ARGS 10
+
+// Kinds of a parsed line
+#define PIPELINE_GATE 0         // An e or s the formatter prints
+#define PIPELINE_COMMAND 1      // Any other command, printed as it runs
+#define PIPELINE_END 2          // End of the input
+
+/**
+ * @struct PipelineSlot
+ * @brief One line of input, as it moves through the stages.
+ */
+typedef struct {
+    char line[PIPELINE_LINE_SIZE];
+    char *args[PIPELINE_MAX_ARGS];  // Tokens of line
+    int nargs;
+    int kind;
+    int last;               // Whether no line is read after this one
+    // Filled by the parser for a gate event
+    int plate_valid;
+    int date_valid;
+    Date date;
+    // Filled by the executor for a gate event
+    int status;             // GATE_OK or the reason it was refused
+    int available_spots;
+    char license_plate[LICENSE_PLATE_SIZE]; // Of the stay closed by an exit
+    Date in_date;
+    Date out_date;
+    long long cost_cents;
+} PipelineSlot;
+
+/**
+ * @struct Pipeline
+ * @brief Ring of slots passed from the parser to the executor and then to
+ * the formatter.
+ *
+ * Each stage owns one cursor: the number of slots it is done with. A stage
+ * only reads the slots the previous one is done with, and the parser only
+ * reuses a slot once the formatter is done with it, so the ring needs no
+ * lock. The cursors are on separate cache lines. A stage that waits for
+ * long, such as on input that is idle, stops polling and sleeps until a
+ * cursor moves.
+ */
+typedef struct {
+    PipelineSlot *slots;
+    FILE *input;
+    FILE *output;
+    pthread_mutex_t lock;   // Guards the sleeps on moved
+    pthread_cond_t moved;   // A cursor moved while a stage slept
+    int sleepers;           // Stages asleep or about to sleep
+    unsigned long long parsed __attribute__((aligned(64)));
+    unsigned long long executed __attribute__((aligned(64)));
+    unsigned long long formatted __attribute__((aligned(64)));
+} Pipeline;
+
+/**
+ * Runs the text commands read from a stream until q or the end of the
+ * stream, with the same output as the serial text mode.
+ *
+ * Reading and tokenizing lines and validating the plates and dates of e
+ * and s commands run on a parser thread, and the output of e and s on a
+ * formatter thread; only the calling thread touches the parks. Any other
+ * command first waits for the output of the previous ones and prints its
+ * own as it runs.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param input The stream of commands.
+ * @param output The stream the output is printed to.
+ * @return 1 when done, 0 if the threads could not be started.
+ */
+int run_pipeline(Parks *parks, FILE *input, FILE *output);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,94 @@
+/**
+ * File containing the implementation of the pools of fixed size nodes.
+ * @file Pool.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include "Pool.h"
+
+// Alignment of every node
+#define POOL_ALIGNMENT sizeof(void *)
+
+void init_node_pool(NodePool *pool, size_t node_size) {
+    // Round the size up so every node of a block stays aligned
+    pool->node_size = (node_size + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT *
+                        POOL_ALIGNMENT;
+    pool->free_nodes = NULL;
+    pool->unused = NULL;
+    pool->unused_count = 0;
+    pool->next_block = POOL_FIRST_BLOCK;
+    pool->blocks = NULL;
+    pool->block_bytes = 0;
+    pool->capacity = 0;
+    pool->live = 0;
+}
+
+// Adds a block of a number of nodes to the pool; the nodes left unused in
+// the previous block go to the free list
+static int add_block(NodePool *pool, int nodes) {
+    size_t bytes = sizeof(PoolBlock) + nodes * pool->node_size;
+    PoolBlock *block = (PoolBlock *)malloc(bytes);
+    if (block == NULL) {
+        return 0; // Memory allocation failed
+    }
+    for (; pool->unused_count > 0; pool->unused_count--) {
+        *(void **)pool->unused = pool->free_nodes;
+        pool->free_nodes = pool->unused;
+        pool->unused += pool->node_size;
+    }
+    pool->block_bytes += bytes;
+    pool->capacity += nodes;
+    block->next = pool->blocks;
+    pool->blocks = block;
+    pool->unused = (char *)(block + 1);
+    pool->unused_count = nodes;
+    return 1;
+}
+
+// Adds a new block to the pool, twice as large as the previous one
+static int grow_pool(NodePool *pool) {
+    if (!add_block(pool, pool->next_block)) {
+        return 0;
+    }
+    if (pool->next_block < POOL_MAX_BLOCK) {
+        pool->next_block *= 2;
+    }
+    return 1;
+}
+
+int reserve_pool(NodePool *pool, int count) {
+    int missing = count - (pool->capacity - pool->live);
+    return missing <= 0 || add_block(pool, missing);
+}
+
+void *pool_alloc(NodePool *pool) {
+    if (pool->free_nodes != NULL) {
+        void *node = pool->free_nodes;
+        pool->free_nodes = *(void **)node;
+        pool->live++;
+        return node;
+    }
+    if (pool->unused_count == 0 && !grow_pool(pool)) {
+        return NULL;
+    }
+    void *node = pool->unused;
+    pool->unused += pool->node_size;
+    pool->unused_count--;
+    pool->live++;
+    return node;
+}
+
+void pool_free(NodePool *pool, void *node) {
+    *(void **)node = pool->free_nodes;
+    pool->free_nodes = node;
+    pool->live--;
+}
+
+void destroy_node_pool(NodePool *pool) {
+    while (pool->blocks != NULL) {
+        PoolBlock *next = pool->blocks->next;
+        free(pool->blocks);
+        pool->blocks = next;
+    }
+    init_node_pool(pool, pool->node_size);
+}
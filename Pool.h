@@ -0,0 +1,81 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+// Number of nodes of the first block of a pool
+#define POOL_FIRST_BLOCK 16
+// Largest number of nodes of a block; blocks double in size up to it
+#define POOL_MAX_BLOCK 65536
+
+/**
+ * @struct PoolBlock
+ * @brief Header of a block of nodes, followed by the nodes themselves.
+ */
+typedef struct PoolBlock {
+    struct PoolBlock *next;
+} PoolBlock;
+
+/**
+ * @struct NodePool
+ * @brief Allocator of fixed size nodes, carved out of ever larger blocks.
+ *
+ * Freed nodes are kept on a free list and handed out again, so once the
+ * pool has grown to the largest number of nodes in use, allocating and
+ * freeing nodes never touches the heap. Every node is released at once
+ * when the pool is destroyed.
+ */
+typedef struct {
+    size_t node_size;
+    void *free_nodes;       // Freed nodes, linked through their first bytes
+    char *unused;           // Next node never handed out of the last block
+    int unused_count;
+    int next_block;         // Number of nodes of the next block
+    PoolBlock *blocks;      // Newest first
+    size_t block_bytes;     // Bytes of every block, headers included
+    int capacity;           // Nodes of every block
+    int live;               // Nodes handed out and not given back
+} NodePool;
+
+/**
+ * Initializes an empty pool.
+ *
+ * @param pool The pool to be initialized.
+ * @param node_size The size of each node, at least that of a pointer.
+ */
+void init_node_pool(NodePool *pool, size_t node_size);
+
+/**
+ * Allocates a node.
+ *
+ * @param pool The pool.
+ * @return The uninitialized node, or NULL if memory allocation failed.
+ */
+void *pool_alloc(NodePool *pool);
+
+/**
+ * Makes room for a number of nodes on top of those handed out, so that
+ * allocating them does not touch the heap.
+ *
+ * @param pool The pool.
+ * @param count The number of nodes.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_pool(NodePool *pool, int count);
+
+/**
+ * Gives a node back to its pool.
+ *
+ * @param pool The pool the node was allocated from.
+ * @param node The node.
+ */
+void pool_free(NodePool *pool, void *node);
+
+/**
+ * Frees every node of a pool.
+ *
+ * @param pool The pool.
+ */
+void destroy_node_pool(NodePool *pool);
+
+#endif /* POOL_H */
@@ -0,0 +1,241 @@
+/**
+ * File containing the implementation of the binary frame protocol, an
+ * alternative to the text commands for gate hardware.
+ * @file Protocol.c
+ * @author ist1102716
+*/
+#include <string.h>
+#include "Protocol.h"
+#include "Batch.h"
+#include "Engine.h"
+#include "History.h"
+#include "Records.h"
+
+// Number of bytes read from the input at a time
+#define PROTOCOL_READ_SIZE 65536
+// Bytes of a request after its length field
+#define REQUEST_BODY_SIZE (REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE)
+
+// Reads a little endian 32 bit value
+static uint32_t get_u32(const unsigned char *bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+            (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+// Reads a little endian 64 bit value
+static uint64_t get_u64(const unsigned char *bytes) {
+    return (uint64_t)get_u32(bytes) | (uint64_t)get_u32(bytes + 4) << 32;
+}
+
+// Writes a little endian 32 bit value
+static void put_u32(unsigned char *bytes, uint32_t value) {
+    bytes[0] = value & 0xFF;
+    bytes[1] = (value >> 8) & 0xFF;
+    bytes[2] = (value >> 16) & 0xFF;
+    bytes[3] = (value >> 24) & 0xFF;
+}
+
+// Reads the fields of a request after its length field
+static void decode_body(const unsigned char *body, uint32_t length,
+                        BinaryRequest *request) {
+    if (length >= 1) {
+        request->opcode = body[0];
+    }
+    // Longer frames are accepted, so fields can be added at the end
+    if (length >= REQUEST_BODY_SIZE) {
+        request->park_id = (int32_t)get_u32(body + 4);
+        request->minute = (int32_t)get_u32(body + 8);
+        request->plate = get_u64(body + 12);
+        request->valid = 1;
+    }
+}
+
+// Reads the event count of a batch; a frame too short for its events is
+// left invalid
+static void decode_batch(const unsigned char *body, uint32_t length,
+                            BinaryRequest *request) {
+    if (length < BATCH_HEADER_SIZE - FRAME_LENGTH_SIZE) {
+        return;
+    }
+    uint32_t count = get_u32(body + 4);
+    if (count <= MAX_BATCH_EVENTS &&
+        length >= BATCH_HEADER_SIZE - FRAME_LENGTH_SIZE +
+                    count * REQUEST_BODY_SIZE) {
+        request->events = body + BATCH_HEADER_SIZE - FRAME_LENGTH_SIZE;
+        request->event_count = count;
+        request->valid = 1;
+    }
+}
+
+int decode_request(const unsigned char *buffer, size_t size,
+                    BinaryRequest *request) {
+    if (size < FRAME_LENGTH_SIZE) {
+        return 0;
+    }
+    uint32_t length = get_u32(buffer);
+    if (length > MAX_FRAME_LENGTH) {
+        return -1;
+    }
+    if (size < FRAME_LENGTH_SIZE + length) {
+        return 0;
+    }
+    memset(request, 0, sizeof(BinaryRequest));
+    const unsigned char *body = buffer + FRAME_LENGTH_SIZE;
+    if (length >= 1 && body[0] == OPCODE_BATCH) {
+        request->opcode = OPCODE_BATCH;
+        decode_batch(body, length, request);
+    } else {
+        decode_body(body, length, request);
+    }
+    return FRAME_LENGTH_SIZE + length;
+}
+
+void encode_response(const BinaryResponse *response, unsigned char *buffer) {
+    memset(buffer, 0, RESPONSE_FRAME_SIZE);
+    put_u32(buffer, RESPONSE_FRAME_SIZE - FRAME_LENGTH_SIZE);
+    buffer[4] = response->opcode;
+    buffer[5] = response->status;
+    put_u32(buffer + 8, (uint32_t)response->park_id);
+    put_u32(buffer + 12, (uint32_t)response->available_spots);
+    put_u32(buffer + 16, (uint32_t)response->cost_cents);
+    put_u32(buffer + 20, (uint32_t)response->in_minute);
+    put_u32(buffer + 24, (uint32_t)response->spot);
+}
+
+// Checks the fields a request needs before it is applied; returns GATE_OK
+// or the status of its response
+static int check_request(const BinaryRequest *request) {
+    if (!request->valid) {
+        return GATE_INVALID_FRAME;
+    }
+    if (request->opcode != OPCODE_ENTRY && request->opcode != OPCODE_EXIT) {
+        return GATE_INVALID_OPCODE;
+    }
+    return GATE_OK;
+}
+
+// Turns a checked request into a gate event, with the plate unpacked into
+// the given buffer; returns the park of the request, or NULL
+static Park *prepare_event(Parks *parks, const BinaryRequest *request,
+                            GateEvent *event, char *license_plate) {
+    unpack_license_plate(request->plate, license_plate);
+    Park *park = get_park_by_id(parks, request->park_id);
+    memset(event, 0, sizeof(GateEvent)); // A zeroed date is an invalid one
+    event->type = request->opcode == OPCODE_ENTRY ? BATCH_ENTRY : BATCH_EXIT;
+    event->park_name = park != NULL ? park->name : NULL;
+    event->license_plate = license_plate;
+    if (request->minute >= 0) {
+        event->date = minutes_to_date(request->minute);
+    }
+    return park;
+}
+
+// Fills the response of an applied event
+static void fill_response(const GateEvent *event, const GateResult *result,
+                            BinaryResponse *response) {
+    response->status = result->status;
+    response->available_spots = result->available_spots;
+    if (result->status == GATE_OK) {
+        response->spot = result->spot;
+    }
+    if (result->status == GATE_OK && event->type == BATCH_EXIT) {
+        // The wire field has 32 bits
+        response->cost_cents = result->cost_cents > INT32_MAX ? INT32_MAX :
+                                result->cost_cents < INT32_MIN ? INT32_MIN :
+                                (int32_t)result->cost_cents;
+        response->in_minute = saturate_minute(date_to_minutes(
+                                                result->in_date));
+    }
+}
+
+void handle_request(Parks *parks, const BinaryRequest *request,
+                    BinaryResponse *response) {
+    memset(response, 0, sizeof(BinaryResponse));
+    response->opcode = request->opcode;
+    response->park_id = request->park_id;
+    response->status = check_request(request);
+    if (response->status != GATE_OK) {
+        return;
+    }
+    char license_plate[LICENSE_PLATE_SIZE];
+    GateEvent event;
+    GateResult result;
+    Park *park = prepare_event(parks, request, &event, license_plate);
+    process_gate_event(parks, park, &event, &result);
+    fill_response(&event, &result, response);
+}
+
+// Applies the events of a batch frame in one process_gate_batch call and
+// encodes a response for each; returns the number of bytes encoded
+static size_t handle_batch(Parks *parks, const BinaryRequest *batch,
+                            unsigned char *buffer) {
+    BinaryRequest requests[MAX_BATCH_EVENTS];
+    BinaryResponse responses[MAX_BATCH_EVENTS];
+    GateEvent events[MAX_BATCH_EVENTS];
+    GateResult results[MAX_BATCH_EVENTS];
+    char plates[MAX_BATCH_EVENTS][LICENSE_PLATE_SIZE];
+    int applied[MAX_BATCH_EVENTS];  // Index in events, or -1 if refused
+    int count = 0;
+    for (int i = 0; i < batch->event_count; i++) {
+        memset(&requests[i], 0, sizeof(BinaryRequest));
+        decode_body(batch->events + i * REQUEST_BODY_SIZE, REQUEST_BODY_SIZE,
+                    &requests[i]);
+        memset(&responses[i], 0, sizeof(BinaryResponse));
+        responses[i].opcode = requests[i].opcode;
+        responses[i].park_id = requests[i].park_id;
+        responses[i].status = check_request(&requests[i]);
+        applied[i] = -1;
+        if (responses[i].status == GATE_OK) {
+            prepare_event(parks, &requests[i], &events[count], plates[count]);
+            applied[i] = count++;
+        }
+    }
+    process_gate_batch(parks, events, count, results);
+    for (int i = 0; i < batch->event_count; i++) {
+        if (applied[i] >= 0) {
+            fill_response(&events[applied[i]], &results[applied[i]],
+                            &responses[i]);
+        }
+        encode_response(&responses[i], buffer + i * RESPONSE_FRAME_SIZE);
+    }
+    return (size_t)batch->event_count * RESPONSE_FRAME_SIZE;
+}
+
+size_t respond_to_request(Parks *parks, const BinaryRequest *request,
+                            unsigned char *buffer) {
+    if (request->opcode == OPCODE_BATCH && request->valid) {
+        return handle_batch(parks, request, buffer);
+    }
+    BinaryResponse response;
+    handle_request(parks, request, &response);
+    encode_response(&response, buffer);
+    return RESPONSE_FRAME_SIZE;
+}
+
+int run_binary_protocol(Parks *parks, FILE *in, FILE *out) {
+    static unsigned char buffer[PROTOCOL_READ_SIZE + MAX_FRAME_LENGTH +
+                                FRAME_LENGTH_SIZE];
+    size_t size = 0;
+    size_t read;
+    while ((read = fread(buffer + size, 1, PROTOCOL_READ_SIZE, in)) > 0) {
+        size += read;
+        size_t offset = 0;
+        BinaryRequest request;
+        int used;
+        while ((used = decode_request(buffer + offset, size - offset,
+                                        &request)) > 0) {
+            unsigned char frames[MAX_RESPONSE_SIZE];
+            fwrite(frames, 1, respond_to_request(parks, &request, frames),
+                    out);
+            offset += used;
+        }
+        if (used < 0) {
+            return 0; // Oversized frame: the stream cannot be resynchronized
+        }
+        // Keep the partial frame at the start of the buffer
+        memmove(buffer, buffer + offset, size - offset);
+        size -= offset;
+    }
+    fflush(out);
+    return size == 0;
+}
@@ -0,0 +1,142 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "Parks.h"
+
+/*
+ * Binary frames are made of little endian fields. Each one starts with a
+ * 32 bit length: the number of bytes that follow it.
+ *
+ * Request:  length, opcode (8 bits), 3 reserved bytes, park id (32 bits),
+ *           minute (32 bits, see date_to_minutes), packed plate (64 bits,
+ *           see pack_license_plate).
+ * Batch:    length, opcode (8 bits, OPCODE_BATCH), 3 reserved bytes, event
+ *           count (32 bits), then that many events laid out as the body of
+ *           a request (opcode to plate).
+ * Response: length, opcode (8 bits), status (8 bits, GATE_*), 2 reserved
+ *           bytes, park id, available spots, cost in cents and entry minute
+ *           of the closed stay, and the spot taken by the entry or freed by
+ *           the exit (32 bits each). A batch gets one response per event,
+ *           in order.
+ */
+
+// Bytes a binary connection to the server sends before its first frame;
+// the first one is not a letter, so no text command starts with them
+#define PROTOCOL_MAGIC "\x7fPKF"
+#define PROTOCOL_MAGIC_SIZE 4
+// Size of the length field at the start of every frame
+#define FRAME_LENGTH_SIZE 4
+// Size of a request frame, length field included
+#define REQUEST_FRAME_SIZE 24
+// Size of a response frame, length field included
+#define RESPONSE_FRAME_SIZE 28
+// Largest length accepted in a request, to bound what a bad frame skips
+#define MAX_FRAME_LENGTH 4096
+
+// Opcode of the entry of a vehicle
+#define OPCODE_ENTRY 1
+// Opcode of the exit of a vehicle
+#define OPCODE_EXIT 2
+// Opcode of a batch of entries and exits (see process_gate_batch)
+#define OPCODE_BATCH 3
+// Bytes of a batch frame before its events, length field included
+#define BATCH_HEADER_SIZE 12
+// Largest number of events in a batch frame
+#define MAX_BATCH_EVENTS ((MAX_FRAME_LENGTH + FRAME_LENGTH_SIZE - \
+                            BATCH_HEADER_SIZE) / \
+                            (REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE))
+// Largest size of the responses to one frame
+#define MAX_RESPONSE_SIZE (MAX_BATCH_EVENTS * RESPONSE_FRAME_SIZE)
+
+// Status of a frame with an unknown opcode
+#define GATE_INVALID_OPCODE 7
+// Status of a frame too short for its fields
+#define GATE_INVALID_FRAME 8
+
+/**
+ * @struct BinaryRequest
+ * @brief Fields of a request frame.
+ */
+typedef struct {
+    uint8_t opcode;
+    int32_t park_id;
+    int32_t minute;
+    uint64_t plate;
+    const unsigned char *events;    // First event of a batch, in the frame
+    int event_count;
+    int valid;              // 0 if the frame was too short for its fields
+} BinaryRequest;
+
+/**
+ * @struct BinaryResponse
+ * @brief Fields of a response frame.
+ */
+typedef struct {
+    uint8_t opcode;
+    uint8_t status;
+    int32_t park_id;
+    int32_t available_spots;
+    int32_t cost_cents;
+    int32_t in_minute;
+    int32_t spot;           // NO_SPOT unless the event succeeded
+} BinaryResponse;
+
+/**
+ * Decodes the request frame at the start of a buffer.
+ *
+ * @param buffer The received bytes.
+ * @param size The number of bytes in the buffer.
+ * @param request The decoded request; the events of a batch are read from
+ * the buffer, which must be kept until the request is handled.
+ * @return The size of the frame, 0 if it is not complete yet or -1 if its
+ * length is larger than MAX_FRAME_LENGTH.
+ */
+int decode_request(const unsigned char *buffer, size_t size,
+                    BinaryRequest *request);
+
+/**
+ * Encodes a response frame.
+ *
+ * @param response The response.
+ * @param buffer Space for RESPONSE_FRAME_SIZE bytes.
+ */
+void encode_response(const BinaryResponse *response, unsigned char *buffer);
+
+/**
+ * Applies a request to the parking system through the same engine core as
+ * the e and s commands.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param request The request.
+ * @param response The response to be filled.
+ */
+void handle_request(Parks *parks, const BinaryRequest *request,
+                    BinaryResponse *response);
+
+/**
+ * Applies a request, or every event of a batch through process_gate_batch,
+ * and encodes the responses.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param request The request.
+ * @param buffer Space for MAX_RESPONSE_SIZE bytes.
+ * @return The number of bytes of the response frames.
+ */
+size_t respond_to_request(Parks *parks, const BinaryRequest *request,
+                            unsigned char *buffer);
+
+/**
+ * Reads request frames until the end of the input, writing their responses
+ * in order.
+ *
+ * @param parks The pointer to the Parks struct.
+ * @param in The stream with the requests.
+ * @param out The stream for the responses.
+ * @return 1 if the input ended cleanly, 0 on a truncated or oversized frame.
+ */
+int run_binary_protocol(Parks *parks, FILE *in, FILE *out);
+
+#endif /* PROTOCOL_H */
@@ -0,0 +1,90 @@
+/**
+ * File containing the implementation of the background reclamation of
+ * removed parks.
+ * @file Reclaim.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <signal.h>
+#include "Reclaim.h"
+
+// Destroys and frees a removed park
+static void free_removed_park(Park *park) {
+    destroy_park(park);
+    free(park);
+}
+
+// Body of the thread: frees the pending parks until it is stopped
+static void *run_reclaimer(void *argument) {
+    Reclaimer *reclaimer = (Reclaimer *)argument;
+    pthread_mutex_lock(&reclaimer->lock);
+    while (1) {
+        while (reclaimer->pending == NULL && !reclaimer->stopping) {
+            pthread_cond_wait(&reclaimer->wake, &reclaimer->lock);
+        }
+        ReclaimNode *pending = reclaimer->pending;
+        reclaimer->pending = NULL;
+        if (pending == NULL) {
+            break; // Stopping with nothing left to free
+        }
+        pthread_mutex_unlock(&reclaimer->lock);
+        while (pending != NULL) {
+            ReclaimNode *next = pending->next;
+            free_removed_park(pending->park);
+            free(pending);
+            pending = next;
+        }
+        pthread_mutex_lock(&reclaimer->lock);
+    }
+    pthread_mutex_unlock(&reclaimer->lock);
+    return NULL;
+}
+
+// Starts the thread with every signal blocked, so signals keep going to
+// the thread that waits for them
+static int start_reclaimer(Reclaimer *reclaimer) {
+    sigset_t all_signals;
+    sigset_t previous;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+    reclaimer->started = pthread_create(&reclaimer->thread, NULL,
+                                        run_reclaimer, reclaimer) == 0;
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    return reclaimer->started;
+}
+
+void init_reclaimer(Reclaimer *reclaimer) {
+    pthread_mutex_init(&reclaimer->lock, NULL);
+    pthread_cond_init(&reclaimer->wake, NULL);
+    reclaimer->pending = NULL;
+    reclaimer->started = 0;
+    reclaimer->stopping = 0;
+}
+
+void reclaim_park(Reclaimer *reclaimer, Park *park) {
+    ReclaimNode *node = (ReclaimNode *)malloc(sizeof(ReclaimNode));
+    if (node == NULL || (!reclaimer->started && !start_reclaimer(reclaimer))) {
+        free(node);
+        free_removed_park(park);
+        return;
+    }
+    node->park = park;
+    pthread_mutex_lock(&reclaimer->lock);
+    node->next = reclaimer->pending;
+    reclaimer->pending = node;
+    pthread_cond_signal(&reclaimer->wake);
+    pthread_mutex_unlock(&reclaimer->lock);
+}
+
+void stop_reclaimer(Reclaimer *reclaimer) {
+    if (reclaimer->started) {
+        pthread_mutex_lock(&reclaimer->lock);
+        reclaimer->stopping = 1;
+        pthread_cond_signal(&reclaimer->wake);
+        pthread_mutex_unlock(&reclaimer->lock);
+        pthread_join(reclaimer->thread, NULL);
+        reclaimer->started = 0;
+    }
+    pthread_mutex_destroy(&reclaimer->lock);
+    pthread_cond_destroy(&reclaimer->wake);
+}
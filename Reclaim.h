@@ -0,0 +1,57 @@
+#ifndef RECLAIM_H
+#define RECLAIM_H
+
+#include <pthread.h>
+#include "Park.h"
+
+/**
+ * @struct ReclaimNode
+ * @brief A removed park waiting to be freed.
+ */
+typedef struct ReclaimNode {
+    Park *park;
+    struct ReclaimNode *next;
+} ReclaimNode;
+
+/**
+ * @struct Reclaimer
+ * @brief Background thread that frees the memory of removed parks, so
+ * removing a park does not stall the commands that follow it.
+ *
+ * The thread is only started by the first removal.
+ */
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    ReclaimNode *pending;   // Parks not freed yet, newest first
+    int started;
+    int stopping;
+} Reclaimer;
+
+/**
+ * Initializes a reclaimer, without starting its thread.
+ *
+ * @param reclaimer The reclaimer to be initialized.
+ */
+void init_reclaimer(Reclaimer *reclaimer);
+
+/**
+ * Hands a removed park to the reclaimer, which destroys and frees it.
+ *
+ * The park must no longer be reachable from anything else. It is freed
+ * right away if the thread cannot be started.
+ *
+ * @param reclaimer The reclaimer.
+ * @param park The removed park.
+ */
+void reclaim_park(Reclaimer *reclaimer, Park *park);
+
+/**
+ * Frees the parks still pending and stops the thread.
+ *
+ * @param reclaimer The reclaimer.
+ */
+void stop_reclaimer(Reclaimer *reclaimer);
+
+#endif /* RECLAIM_H */
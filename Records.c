@@ -10,6 +10,15 @@
 #include <string.h>
 #include <stdlib.h>
 
+// Number of characters in a license plate, separators included
+#define PLATE_LENGTH 8
+// Separator between the pairs of a license plate
+#define PLATE_SEPARATOR '-'
+// Number of bits used by each packed character
+#define PLATE_CHAR_BITS 8
+// Mask selecting one packed character
+#define PLATE_CHAR_MASK 0xFF
+
 unsigned int hash(const char *key, int size) {
     unsigned int hash = 0;
     for (int i = 0; key[i] != '\0'; i++) {
@@ -33,12 +42,35 @@ HashMap *create_hash_map() {
     for (int i = 0; i < MAX_SIZE; i++) {
         map->buckets[i] = NULL;
     }
+    init_node_pool(&map->record_nodes, sizeof(RecordNode));
+    init_node_pool(&map->vehicle_nodes, sizeof(HashNode));
     return map;
 }
 
+// Takes a node from the pool of the map and copies a record and its dates
+// into it
+static RecordNode *create_record_node(HashMap *map, const ParkRecord *record) {
+    RecordNode *node = (RecordNode *)pool_alloc(&map->record_nodes);
+    if (node == NULL) {
+        return NULL; // Memory allocation failed
+    }
+    node->record = *record; // Copy the ParkRecord data
+    node->next = NULL;
+    node->timer = NULL;
+    if (record->in_date != NULL) {
+        node->in_storage = *record->in_date;
+        node->record.in_date = &node->in_storage;
+    }
+    if (record->out_date != NULL) {
+        close_record(node, *record->out_date);
+    }
+    return node;
+}
+
 
 // Function to add a record to the hash table
-void add_record(HashMap *map, const char *key, ParkRecord* record) {
+RecordNode *add_record(HashMap *map, const char *key,
+                        const ParkRecord* record) {
     int index = hash(key, map->size);
     HashNode *current = map->buckets[index];
 
@@ -52,35 +84,52 @@ void add_record(HashMap *map, const char *key, ParkRecord* record) {
             }
 
             // Add the new record at the end of the linked list
-            RecordNode *new_record_node = (RecordNode *)malloc(sizeof(RecordNode));
-            if (new_record_node == NULL) {
-                return; // Memory allocation failed
-            }
-            new_record_node->record = *record; // Copy the ParkRecord data
-            new_record_node->next = NULL;
-            last_record_node->next = new_record_node;
-            return;
+            last_record_node->next = create_record_node(map, record);
+            return last_record_node->next;
         }
         current = current->next;
     }
 
     // If the vehicle does not have records in this bucket, create a new HashNode
-    HashNode *new_node = (HashNode *)malloc(sizeof(HashNode));
+    RecordNode *new_record_node = create_record_node(map, record);
+    if (new_record_node == NULL) {
+        return NULL; // Memory allocation failed
+    }
+    HashNode *new_node = (HashNode *)pool_alloc(&map->vehicle_nodes);
     if (new_node == NULL) {
-        return; // Memory allocation failed
+        free_record_node(map, new_record_node);
+        return NULL; // Memory allocation failed
     }
     strcpy(new_node->vehicle_license_plate, key);
     new_node->next = map->buckets[index];
     map->buckets[index] = new_node;
 
     // Add the new record to the linked list of records for this vehicle
-    RecordNode *new_record_node = (RecordNode *)malloc(sizeof(RecordNode));
-    if (new_record_node == NULL) {
-        return; // Memory allocation failed
-    }
-    new_record_node->record = *record; // Copy the ParkRecord data
-    new_record_node->next = NULL;
     new_node->records = new_record_node;
+    return new_record_node;
+}
+
+void close_record(RecordNode *node, Date out_date) {
+    node->out_storage = out_date;
+    node->record.out_date = &node->out_storage;
+}
+
+void free_record_node(HashMap *map, RecordNode *node) {
+    pool_free(&map->record_nodes, node);
+}
+
+void free_vehicle_node(HashMap *map, HashNode *node) {
+    pool_free(&map->vehicle_nodes, node);
+}
+
+void destroy_hash_map(HashMap *map) {
+    if (map == NULL) {
+        return;
+    }
+    destroy_node_pool(&map->record_nodes);
+    destroy_node_pool(&map->vehicle_nodes);
+    free(map->buckets);
+    free(map);
 }
 
 
@@ -99,39 +148,34 @@ RecordNode *get_records(HashMap *map, const char *key) {
 }
 
 
-ParkRecord* createParkRecord(const char* license_plate, Date* in_date) {
-    // Allocate memory for a ParkRecord structure
-    ParkRecord* record = (ParkRecord*)malloc(sizeof(ParkRecord));
-    if (record == NULL) {
-        // Memory allocation failed
-        return NULL;
-    }
-
-    // Copy the license plate to the ParkRecord structure
-    // Allocate memory for in_date
+void init_park_record(ParkRecord *record, const char* license_plate,
+                        Date* in_date) {
     strcpy(record->license_plate, license_plate);
-
     record->in_date = in_date;
-
-    // Copy the entrance date to the ParkRecord structure
-    // record->in_date = (Date*)malloc(sizeof(Date));
-    // if (record->in_date == NULL) {
-    //     free(record);
-    //     return NULL;
-    // }
-    // memcpy(&(record->in_date), in_date, sizeof(Date));
-
-    // Set other fields to default or meaningful values
     record->out_date = NULL;
-
-    record->cost = -1.0;
-
-    return record;
+    record->cost_cents = 0;
+    record->spot = NO_SPOT;
+    record->pass = NO_PASS;
 }
 
+uint64_t pack_license_plate(const char *license_plate) {
+    uint64_t code = 0;
+    for (int i = 0; i < PLATE_LENGTH; i++) {
+        if (license_plate[i] != PLATE_SEPARATOR) {
+            code = (code << PLATE_CHAR_BITS) | (unsigned char)license_plate[i];
+        }
+    }
+    return code;
+}
 
-
-
-
-
-
+void unpack_license_plate(uint64_t code, char *license_plate) {
+    for (int i = PLATE_LENGTH - 1; i >= 0; i--) {
+        if (i % 3 == 2) {
+            license_plate[i] = PLATE_SEPARATOR; // Positions 2 and 5
+        } else {
+            license_plate[i] = (char)(code & PLATE_CHAR_MASK);
+            code >>= PLATE_CHAR_BITS;
+        }
+    }
+    license_plate[PLATE_LENGTH] = '\0';
+}
@@ -2,30 +2,43 @@
 #define RECORDS_H
 
 #include "Date.h"
+#include "Pool.h"
+#include "Spots.h"
+#include "Passes.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 // Define the maximum size of the hash map
 #define MAX_SIZE 500
 
+// Size of a buffer holding a license plate and its terminator
+#define LICENSE_PLATE_SIZE 11
+
 // Structure to represent a park record
 typedef struct {
-    char license_plate[11]; // Vehicle license plate
+    char license_plate[LICENSE_PLATE_SIZE]; // Vehicle license plate
     Date *in_date; // Date of entry
     Date *out_date; // Date of exit
-    float cost; // Cost for parking
+    long long cost_cents; // Cost for parking in cents, once closed
+    int spot; // Spot taken by the vehicle, NO_SPOT if none
+    int pass; // Percent of the price charged by a pass, NO_PASS if none
 } ParkRecord;
 
 // Structure to represent a node in the linked list of records
 typedef struct RecordNode {
     ParkRecord record;
     struct RecordNode *next;
+    Date in_storage; // Storage of the dates the record points to
+    Date out_storage;
+    struct OverstayTimer *timer; // Overstay timer of an open record, or NULL
 } RecordNode;
 
 // Structure to represent a node in the hash table
 typedef struct HashNode {
-    char vehicle_license_plate[11]; // Key: Vehicle license plate
+    // Key: Vehicle license plate
+    char vehicle_license_plate[LICENSE_PLATE_SIZE];
     RecordNode *records; // Linked list of records for this vehicle
     struct HashNode *next; // Pointer to the next node (for handling collisions)
 } HashNode;
@@ -34,6 +47,8 @@ typedef struct HashNode {
 typedef struct {
     int size; // Size of the hash table
     HashNode **buckets; // Array of pointers to hash nodes (the hash table itself)
+    NodePool record_nodes; // Pool of the RecordNodes of the map
+    NodePool vehicle_nodes; // Pool of the HashNodes of the map
 } HashMap;
 
 // Function to calculate the hash value for a given key
@@ -42,13 +57,35 @@ unsigned int hash(const char *key, int size);
 // Function to create a hash map
 HashMap *create_hash_map();
 
-// Function to add a record to the hash map
-void add_record(HashMap *map, const char *key, ParkRecord* record);
+// Function to add a copy of a record, and of its dates, to the hash map,
+// returning its node (NULL if memory allocation failed)
+RecordNode *add_record(HashMap *map, const char *key,
+                        const ParkRecord* record);
+
+// Function to set the exit date of a record, copying it into the node
+void close_record(RecordNode *node, Date out_date);
+
+// Function to give a record node back to the pool of its hash map
+void free_record_node(HashMap *map, RecordNode *node);
+
+// Function to give a vehicle node back to the pool of its hash map
+void free_vehicle_node(HashMap *map, HashNode *node);
+
+// Function to free a hash map with every node in it
+void destroy_hash_map(HashMap *map);
 
 // Function to get records for a given key from the hash map
 RecordNode *get_records(HashMap *map, const char *key);
 
-// Function to create a ParkRecord instance
-ParkRecord* createParkRecord(const char* license_plate, Date* in_date);
+// Function to initialize a ParkRecord of a vehicle that just entered
+void init_park_record(ParkRecord *record, const char* license_plate,
+                        Date* in_date);
+
+// Function to pack the six characters of a license plate into an integer
+// code whose order matches the alphabetical order of the plates
+uint64_t pack_license_plate(const char *license_plate);
+
+// Function to rebuild the license plate (XX-XX-XX) of a packed code
+void unpack_license_plate(uint64_t code, char *license_plate);
 
 #endif /* RECORDS_H */
@@ -0,0 +1,231 @@
+/**
+ * File containing the implementation of the revenue indexes used by the
+ * date range revenue queries.
+ * @file Revenue.c
+ * @author ist1102716
+*/
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Revenue.h"
+
+void init_daily_revenue(DailyRevenue *revenue) {
+    revenue->days = NULL;
+    revenue->prefix = NULL;
+    revenue->count = 0;
+    revenue->capacity = 0;
+}
+
+int reserve_daily_revenue(DailyRevenue *revenue, int days) {
+    if (days <= revenue->capacity) {
+        return 1;
+    }
+    int *day_array = (int *)realloc(revenue->days, days * sizeof(int));
+    if (day_array == NULL) {
+        return 0; // Memory allocation failed
+    }
+    revenue->days = day_array;
+    long long *prefix = (long long *)realloc(revenue->prefix,
+                                            days * sizeof(long long));
+    if (prefix == NULL) {
+        return 0; // Memory allocation failed
+    }
+    revenue->prefix = prefix;
+    revenue->capacity = days;
+    return 1;
+}
+
+int add_daily_revenue(DailyRevenue *revenue, int day, long long cents) {
+    int last = revenue->count - 1;
+    if (last >= 0 && revenue->days[last] == day) {
+        revenue->prefix[last] += cents;
+        return 1;
+    }
+    if (revenue->count == revenue->capacity &&
+        !reserve_daily_revenue(revenue, revenue->capacity > 0 ?
+                                revenue->capacity * 2 : REVENUE_INITIAL_DAYS)) {
+        return 0;
+    }
+    revenue->days[revenue->count] = day;
+    revenue->prefix[revenue->count] = cents +
+                                        (last >= 0 ? revenue->prefix[last] : 0);
+    revenue->count++;
+    return 1;
+}
+
+// Revenue of every day up to and including the given one
+static long long revenue_until(const DailyRevenue *revenue, int day) {
+    int low = 0;
+    int high = revenue->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (revenue->days[middle] <= day) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low > 0 ? revenue->prefix[low - 1] : 0;
+}
+
+void truncate_daily_revenue(DailyRevenue *revenue, int day) {
+    while (revenue->count > 0 && revenue->days[revenue->count - 1] >= day) {
+        revenue->count--;
+    }
+}
+
+long long daily_revenue_between(const DailyRevenue *revenue, int first_day,
+                                int last_day) {
+    if (last_day < first_day) {
+        return 0;
+    }
+    return revenue_until(revenue, last_day) -
+            revenue_until(revenue, first_day - 1);
+}
+
+void destroy_daily_revenue(DailyRevenue *revenue) {
+    free(revenue->days);
+    free(revenue->prefix);
+    init_daily_revenue(revenue);
+}
+
+void init_network_revenue(NetworkRevenue *revenue) {
+    revenue->days = NULL;
+    revenue->daily = NULL;
+    revenue->tree = NULL;
+    revenue->count = 0;
+    revenue->capacity = 0;
+}
+
+// Index of the first known day not before the given one
+static int network_lower_bound(const NetworkRevenue *revenue, int day) {
+    int low = 0;
+    int high = revenue->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (revenue->days[middle] < day) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Revenue of the first days of the tree, up to and including the given index
+static long long network_prefix(const NetworkRevenue *revenue, int index) {
+    long long sum = 0;
+    for (int i = index + 1; i > 0; i -= i & -i) {
+        sum += revenue->tree[i];
+    }
+    return sum;
+}
+
+int reserve_network_revenue(NetworkRevenue *revenue, int days) {
+    if (days <= revenue->capacity) {
+        return 1;
+    }
+    int *day_array = (int *)realloc(revenue->days, days * sizeof(int));
+    if (day_array == NULL) {
+        return 0; // Memory allocation failed
+    }
+    revenue->days = day_array;
+    long long *daily = (long long *)realloc(revenue->daily,
+                                            days * sizeof(long long));
+    if (daily == NULL) {
+        return 0; // Memory allocation failed
+    }
+    revenue->daily = daily;
+    long long *tree = (long long *)realloc(revenue->tree,
+                                            (days + 1) * sizeof(long long));
+    if (tree == NULL) {
+        return 0; // Memory allocation failed
+    }
+    revenue->tree = tree;
+    revenue->capacity = days;
+    return 1;
+}
+
+// Makes room for one more day
+static int reserve_network_day(NetworkRevenue *revenue) {
+    if (revenue->count < revenue->capacity) {
+        return 1;
+    }
+    return reserve_network_revenue(revenue, revenue->capacity > 0 ?
+                                    revenue->capacity * 2 :
+                                    REVENUE_INITIAL_DAYS);
+}
+
+// Rebuilds the tree in O(days) from the daily totals
+static void rebuild_network_tree(NetworkRevenue *revenue) {
+    int count = revenue->count;
+    for (int i = 1; i <= count; i++) {
+        revenue->tree[i] = revenue->daily[i - 1];
+    }
+    for (int i = 1; i <= count; i++) {
+        int parent = i + (i & -i);
+        if (parent <= count) {
+            revenue->tree[parent] += revenue->tree[i];
+        }
+    }
+}
+
+// Adds a day without revenue at the given index of the sorted days
+static int insert_network_day(NetworkRevenue *revenue, int index, int day) {
+    if (!reserve_network_day(revenue)) {
+        return 0;
+    }
+    int count = revenue->count++;
+    if (index == count) {
+        // A node of the tree covers the days (i - lowbit(i), i], all known
+        int node = count + 1;
+        revenue->days[count] = day;
+        revenue->daily[count] = 0;
+        revenue->tree[node] = network_prefix(revenue, count - 1) -
+                                network_prefix(revenue, count - (node & -node));
+        return 1;
+    }
+    memmove(revenue->days + index + 1, revenue->days + index,
+            (count - index) * sizeof(int));
+    memmove(revenue->daily + index + 1, revenue->daily + index,
+            (count - index) * sizeof(long long));
+    revenue->days[index] = day;
+    revenue->daily[index] = 0;
+    rebuild_network_tree(revenue);
+    return 1;
+}
+
+int add_network_revenue(NetworkRevenue *revenue, int day, long long cents) {
+    int index = network_lower_bound(revenue, day);
+    if ((index == revenue->count || revenue->days[index] != day) &&
+        !insert_network_day(revenue, index, day)) {
+        return 0;
+    }
+    revenue->daily[index] += cents;
+    for (int i = index + 1; i <= revenue->count; i += i & -i) {
+        revenue->tree[i] += cents;
+    }
+    return 1;
+}
+
+long long network_revenue_between(const NetworkRevenue *revenue,
+                                    int first_day, int last_day) {
+    if (last_day < first_day) {
+        return 0;
+    }
+    int first = network_lower_bound(revenue, first_day);
+    // Index of the last known day not after last_day
+    int last = last_day == INT_MAX ? revenue->count - 1 :
+                network_lower_bound(revenue, last_day + 1) - 1;
+    if (last < first) {
+        return 0;
+    }
+    return network_prefix(revenue, last) - network_prefix(revenue, first - 1);
+}
+
+void destroy_network_revenue(NetworkRevenue *revenue) {
+    free(revenue->days);
+    free(revenue->daily);
+    free(revenue->tree);
+    init_network_revenue(revenue);
+}
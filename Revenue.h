@@ -0,0 +1,140 @@
+#ifndef REVENUE_H
+#define REVENUE_H
+
+// Initial number of days allocated for a revenue index
+#define REVENUE_INITIAL_DAYS 64
+
+/**
+ * @struct DailyRevenue
+ * @brief Prefix sums of the daily revenue of one park.
+ *
+ * The exits of a park are chronological, so days are only ever appended
+ * (or the last one increased) and the sums stay sorted by day.
+ */
+typedef struct {
+    int *days;              // Days with exits, as minutes / MINUTES_PER_DAY
+    long long *prefix;      // Revenue in cents up to and including each day
+    int count;
+    int capacity;
+} DailyRevenue;
+
+/**
+ * @struct NetworkRevenue
+ * @brief Fenwick tree over the daily revenue of every park.
+ *
+ * The tree is keyed on the days with revenue only, in order, so its size
+ * does not depend on how far apart they are. Parks are only chronological
+ * on their own, so a day may be new and fall between two known ones; the
+ * plain daily totals are kept to rebuild the tree when that happens.
+ */
+typedef struct {
+    int *days;              // Days with revenue, sorted
+    long long *daily;       // Revenue in cents of each of those days
+    long long *tree;        // Fenwick tree over daily, 1-indexed
+    int count;
+    int capacity;
+} NetworkRevenue;
+
+/**
+ * Initializes an empty daily revenue index.
+ *
+ * @param revenue The index to be initialized.
+ */
+void init_daily_revenue(DailyRevenue *revenue);
+
+/**
+ * Makes room for at least a number of days, so that adding revenue to up
+ * to that many days does not touch the heap.
+ *
+ * @param revenue The index.
+ * @param days The number of days, those already in the index included.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_daily_revenue(DailyRevenue *revenue, int days);
+
+/**
+ * Adds revenue to a day not before the last one in the index.
+ *
+ * @param revenue The index.
+ * @param day The day of the revenue.
+ * @param cents The revenue in cents.
+ * @return 1 if the revenue was added, 0 if memory allocation failed.
+ */
+int add_daily_revenue(DailyRevenue *revenue, int day, long long cents);
+
+/**
+ * Removes the revenue of every day from the given one on.
+ *
+ * @param revenue The index.
+ * @param day The first day removed.
+ */
+void truncate_daily_revenue(DailyRevenue *revenue, int day);
+
+/**
+ * Gets the revenue of an inclusive range of days in O(log days).
+ *
+ * @param revenue The index.
+ * @param first_day The first day of the range.
+ * @param last_day The last day of the range.
+ * @return The revenue in cents.
+ */
+long long daily_revenue_between(const DailyRevenue *revenue, int first_day,
+                                int last_day);
+
+/**
+ * Frees the memory of a daily revenue index.
+ *
+ * @param revenue The index to be destroyed.
+ */
+void destroy_daily_revenue(DailyRevenue *revenue);
+
+/**
+ * Initializes an empty network revenue index.
+ *
+ * @param revenue The index to be initialized.
+ */
+void init_network_revenue(NetworkRevenue *revenue);
+
+/**
+ * Makes room for at least a number of days, so that adding revenue to up
+ * to that many days does not touch the heap.
+ *
+ * @param revenue The index.
+ * @param days The number of days, those already in the index included.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int reserve_network_revenue(NetworkRevenue *revenue, int days);
+
+/**
+ * Adds (or, with a negative amount, removes) revenue of any day.
+ *
+ * Takes O(log days) for a known day or one after every known day, and
+ * O(days) for a new day before the last one.
+ *
+ * @param revenue The index.
+ * @param day The day of the revenue.
+ * @param cents The revenue in cents.
+ * @return 1 if the revenue was added, 0 if memory allocation failed.
+ */
+int add_network_revenue(NetworkRevenue *revenue, int day, long long cents);
+
+/**
+ * Gets the revenue of every park in an inclusive range of days in
+ * O(log days).
+ *
+ * @param revenue The index.
+ * @param first_day The first day of the range.
+ * @param last_day The last day of the range.
+ * @return The revenue in cents.
+ */
+long long network_revenue_between(const NetworkRevenue *revenue,
+                                    int first_day, int last_day);
+
+/**
+ * Frees the memory of a network revenue index.
+ *
+ * @param revenue The index to be destroyed.
+ */
+void destroy_network_revenue(NetworkRevenue *revenue);
+
+#endif /* REVENUE_H */
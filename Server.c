@@ -0,0 +1,451 @@
+/**
+ * File containing the implementation of the Unix domain socket server that
+ * shares one parking system between many clients.
+ * @file Server.c
+ * @author ist1102716
+*/
+#define _GNU_SOURCE // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "Server.h"
+#include "Engine.h"
+#include "Protocol.h"
+#include "parser.h"
+
+// Protocol of a connection, known once its first bytes arrive
+#define MODE_UNKNOWN 0
+#define MODE_TEXT 1
+#define MODE_BINARY 2
+// Longest text command accepted from a client
+#define SERVER_MAX_LINE BUFSIZ
+// Maximum number of arguments of a text command
+#define SERVER_MAX_ARGS 10
+
+/**
+ * @struct Buffer
+ * @brief Growable array of bytes.
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} Buffer;
+
+/**
+ * @struct Connection
+ * @brief State of one client connection.
+ */
+typedef struct {
+    int fd;
+    int mode;
+    Buffer in;              // Received bytes not yet handled
+    Buffer out;             // Responses not yet fully written
+    size_t sent;            // Bytes of out already written
+    int peer_closed;        // The client will send nothing else
+    int quit;               // A q command was received
+    uint32_t events;        // Events the connection is registered for
+    int index;              // Position in the list of connections
+} Connection;
+
+/**
+ * @struct Server
+ * @brief State of the event loop.
+ */
+typedef struct {
+    Parks *parks;
+    int epoll_fd;
+    FILE *capture;          // Memory stream the text commands print to
+    char *captured;
+    size_t captured_size;
+    Connection **connections;
+    int count;
+    int capacity;
+} Server;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+// Signal handler asking the event loop to stop
+static void request_stop(int signal) {
+    (void)signal;
+    stop_requested = 1;
+}
+
+// Makes room for more bytes at the end of a buffer
+static int reserve_buffer(Buffer *buffer, size_t extra) {
+    if (buffer->size + extra <= buffer->capacity) {
+        return 1;
+    }
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity : extra;
+    while (capacity < buffer->size + extra) {
+        capacity *= 2;
+    }
+    char *data = (char *)realloc(buffer->data, capacity);
+    if (data == NULL) {
+        return 0; // Memory allocation failed
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+static int append_buffer(Buffer *buffer, const void *data, size_t size) {
+    if (!reserve_buffer(buffer, size)) {
+        return 0;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return 1;
+}
+
+// Drops the first bytes of a buffer
+static void consume_buffer(Buffer *buffer, size_t size) {
+    memmove(buffer->data, buffer->data + size, buffer->size - size);
+    buffer->size -= size;
+}
+
+// Number of response bytes still to be written to a connection
+static size_t pending_output(const Connection *connection) {
+    return connection->out.size - connection->sent;
+}
+
+// Runs one text command, queueing what it prints as its response
+static int run_text_command(Server *server, Connection *connection,
+                            char *line) {
+    char *args[SERVER_MAX_ARGS];
+    int nargs = tokenize_input(line, args, SERVER_MAX_ARGS);
+
+    rewind(server->capture);
+    if (!execute_command(server->parks, args, nargs, server->capture)) {
+        connection->quit = 1;
+    }
+    fflush(server->capture);
+    return append_buffer(&connection->out, server->captured,
+                            server->captured_size);
+}
+
+// Applies one binary request, queueing its response frames
+static int run_binary_request(Server *server, Connection *connection,
+                                const BinaryRequest *request) {
+    unsigned char frames[MAX_RESPONSE_SIZE];
+    size_t size = respond_to_request(server->parks, request, frames);
+    return append_buffer(&connection->out, frames, size);
+}
+
+// Picks the protocol of a connection once its first bytes arrive: a letter
+// starts a text connection and PROTOCOL_MAGIC, which is dropped, a binary
+// one; returns 0 if they start neither
+static int select_mode(Connection *connection) {
+    Buffer *in = &connection->in;
+    if (connection->mode != MODE_UNKNOWN || in->size == 0) {
+        return 1;
+    }
+    if (isalpha((unsigned char)in->data[0])) {
+        connection->mode = MODE_TEXT;
+        return 1;
+    }
+    size_t size = in->size < PROTOCOL_MAGIC_SIZE ? in->size :
+                    PROTOCOL_MAGIC_SIZE;
+    if (memcmp(in->data, PROTOCOL_MAGIC, size) != 0) {
+        return 0;
+    }
+    if (size == PROTOCOL_MAGIC_SIZE) {
+        consume_buffer(in, PROTOCOL_MAGIC_SIZE);
+        connection->mode = MODE_BINARY;
+    }
+    return 1;
+}
+
+// Handles the complete requests received, in order, until too much output
+// is queued; returns 0 if the connection must be dropped
+static int process_requests(Server *server, Connection *connection) {
+    Buffer *in = &connection->in;
+    if (!select_mode(connection)) {
+        return 0;
+    }
+    size_t offset = 0;
+    int ok = 1;
+    while (ok && !connection->quit &&
+            pending_output(connection) < SERVER_MAX_PENDING) {
+        if (connection->mode == MODE_TEXT) {
+            char *line = in->data + offset;
+            char *end = memchr(line, '\n', in->size - offset);
+            if (end == NULL) {
+                ok = in->size - offset < SERVER_MAX_LINE;
+                break;
+            }
+            *end = '\0';
+            if (end > line && end[-1] == '\r') {
+                end[-1] = '\0';
+            }
+            offset = end + 1 - in->data;
+            ok = run_text_command(server, connection, line);
+        } else if (connection->mode == MODE_BINARY) {
+            BinaryRequest request;
+            int used = decode_request((unsigned char *)in->data + offset,
+                                        in->size - offset, &request);
+            if (used <= 0) {
+                ok = used == 0;
+                break;
+            }
+            offset += used;
+            ok = run_binary_request(server, connection, &request);
+        } else {
+            break;
+        }
+    }
+    if (offset > 0) {
+        consume_buffer(in, offset);
+    }
+    return ok;
+}
+
+// Writes as much queued output as the socket takes
+static int flush_output(Connection *connection) {
+    while (pending_output(connection) > 0) {
+        ssize_t written = send(connection->fd,
+                                connection->out.data + connection->sent,
+                                pending_output(connection), MSG_NOSIGNAL);
+        if (written < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection->sent += written;
+    }
+    connection->out.size = 0;
+    connection->sent = 0;
+    return 1;
+}
+
+// Reads one chunk from the socket; returns 0 on a connection error
+static int read_input(Connection *connection) {
+    if (!reserve_buffer(&connection->in, SERVER_READ_SIZE)) {
+        return 0;
+    }
+    ssize_t received = read(connection->fd,
+                            connection->in.data + connection->in.size,
+                            SERVER_READ_SIZE);
+    if (received > 0) {
+        connection->in.size += received;
+    } else if (received == 0) {
+        connection->peer_closed = 1;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        return 0;
+    }
+    return 1;
+}
+
+static void close_connection(Server *server, Connection *connection) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    Connection *last = server->connections[--server->count];
+    server->connections[connection->index] = last;
+    last->index = connection->index;
+    free(connection->in.data);
+    free(connection->out.data);
+    free(connection);
+}
+
+// Registers a connection for reading while it may send more requests and
+// for writing while it has queued output
+static void update_interest(Server *server, Connection *connection) {
+    uint32_t events = 0;
+    if (!connection->peer_closed && !connection->quit &&
+        pending_output(connection) < SERVER_MAX_PENDING) {
+        events |= EPOLLIN;
+    }
+    if (pending_output(connection) > 0) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection->events) {
+        struct epoll_event event;
+        event.events = events;
+        event.data.ptr = connection;
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+static void handle_connection(Server *server, Connection *connection,
+                                uint32_t events) {
+    int ok = 1;
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        ok = read_input(connection);
+    }
+    // Output drained by a write may let buffered requests run
+    while (ok) {
+        size_t before = connection->in.size;
+        ok = process_requests(server, connection) &&
+                flush_output(connection);
+        if (connection->in.size == before ||
+            pending_output(connection) > 0) {
+            break;
+        }
+    }
+    if (!ok || ((connection->peer_closed || connection->quit) &&
+                pending_output(connection) == 0)) {
+        close_connection(server, connection);
+    } else {
+        update_interest(server, connection);
+    }
+}
+
+// Adds a new client to the list of connections and to the event loop
+static int add_connection(Server *server, int fd) {
+    if (server->count == server->capacity) {
+        int capacity = server->capacity > 0 ? server->capacity * 2 : 16;
+        Connection **connections = (Connection **)realloc(
+            server->connections, capacity * sizeof(Connection *));
+        if (connections == NULL) {
+            return 0; // Memory allocation failed
+        }
+        server->connections = connections;
+        server->capacity = capacity;
+    }
+    Connection *connection = (Connection *)calloc(1, sizeof(Connection));
+    if (connection == NULL) {
+        return 0; // Memory allocation failed
+    }
+    connection->fd = fd;
+    connection->events = EPOLLIN;
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        free(connection);
+        return 0;
+    }
+    connection->index = server->count;
+    server->connections[server->count++] = connection;
+    return 1;
+}
+
+static void accept_clients(Server *server, int listen_fd) {
+    int fd;
+    while ((fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+        if (!add_connection(server, fd)) {
+            close(fd);
+        }
+    }
+}
+
+// Creates the listening socket, replacing a stale socket file but nothing
+// else, and keeps the identity of the socket file it bound
+static int open_listener(const char *path, struct stat *bound) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    struct stat existing;
+    if (lstat(path, &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode) || unlink(path) != 0) {
+            return -1;
+        }
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (lstat(path, bound) != 0 || listen(fd, SERVER_BACKLOG) != 0) {
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    return fd;
+}
+
+// Removes the socket file of the listener, unless something else has
+// replaced it since
+static void remove_listener(const char *path, const struct stat *bound) {
+    struct stat current;
+    if (lstat(path, &current) == 0 && S_ISSOCK(current.st_mode) &&
+        current.st_dev == bound->st_dev && current.st_ino == bound->st_ino) {
+        unlink(path);
+    }
+}
+
+// Runs the event loop until a stop signal arrives
+static void serve(Server *server, int listen_fd, const sigset_t *wait_mask) {
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!stop_requested) {
+        // Signals are only delivered while waiting, so none is missed
+        int count = epoll_pwait(server->epoll_fd, events, SERVER_MAX_EVENTS,
+                                -1, wait_mask);
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == NULL) {
+                accept_clients(server, listen_fd);
+            } else {
+                handle_connection(server, events[i].data.ptr,
+                                    events[i].events);
+            }
+        }
+    }
+}
+
+int run_server(Parks *parks, const char *path) {
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.parks = parks;
+
+    struct stat bound;
+    int listen_fd = open_listener(path, &bound);
+    if (listen_fd < 0) {
+        return 0;
+    }
+    server.epoll_fd = epoll_create1(0);
+    server.capture = open_memstream(&server.captured, &server.captured_size);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; // The listening socket
+    if (server.epoll_fd < 0 || server.capture == NULL ||
+        epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) != 0) {
+        if (server.capture != NULL) {
+            fclose(server.capture);
+        }
+        free(server.captured);
+        close(server.epoll_fd);
+        close(listen_fd);
+        remove_listener(path, &bound);
+        return 0;
+    }
+
+    // Block the stop signals outside of epoll_pwait
+    sigset_t stop_signals, wait_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stop_signals, &wait_mask);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    serve(&server, listen_fd, &wait_mask);
+
+    while (server.count > 0) {
+        close_connection(&server, server.connections[0]);
+    }
+    free(server.connections);
+    fclose(server.capture);
+    free(server.captured);
+    close(server.epoll_fd);
+    close(listen_fd);
+    remove_listener(path, &bound);
+    return 1;
+}
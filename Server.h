@@ -0,0 +1,34 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "Parks.h"
+
+// Number of pending connections the listening socket queues
+#define SERVER_BACKLOG 128
+// Largest number of epoll events handled per wake up
+#define SERVER_MAX_EVENTS 64
+// Number of bytes read from a connection at a time
+#define SERVER_READ_SIZE 65536
+// Queued response bytes above which a connection is no longer read
+#define SERVER_MAX_PENDING (1 << 20)
+
+/**
+ * Serves the parking system on a Unix domain socket until SIGINT or
+ * SIGTERM.
+ *
+ * Every connection speaks either the text commands, one per line, or the
+ * binary frames of Protocol.h, chosen by its first bytes: a letter starts a
+ * text connection and PROTOCOL_MAGIC a binary one; a connection that starts
+ * with anything else is closed. Clients may pipeline requests; each
+ * connection gets its responses in the order of its requests. A q command
+ * closes only its own connection.
+ *
+ * @param parks The pointer to the Parks struct shared by every client.
+ * @param path The path of the socket. A stale socket there is replaced;
+ * anything else there makes the server fail to start. The socket is
+ * removed on the way out, unless something else has replaced it.
+ * @return 1 if the server stopped on a signal, 0 if it could not start.
+ */
+int run_server(Parks *parks, const char *path);
+
+#endif /* SERVER_H */
@@ -0,0 +1,617 @@
+/**
+ * File containing the implementation of the binary snapshot of the parking
+ * system, used to restart without replaying the whole event log.
+ * @file Snapshot.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Snapshot.h"
+#include "Records.h"
+#include "Date.h"
+
+// Suffix of the temporary file written before it replaces the snapshot
+#define SNAPSHOT_TMP_SUFFIX ".tmp"
+// Alignment of the records section inside the file
+#define SNAPSHOT_ALIGNMENT 8
+
+// Rounds an offset up to the alignment of the records section
+static uint64_t align_offset(uint64_t offset) {
+    uint64_t mask = SNAPSHOT_ALIGNMENT - 1;
+    return (offset + mask) & ~mask;
+}
+
+// Counts the records of a park, wherever they currently live
+static uint64_t count_park_records(Park *park) {
+    if (park->snapshot_records != NULL) {
+        return park->snapshot_record_count;
+    }
+    uint64_t count = 0;
+    for (int i = 0; i < park->records_map->size; i++) {
+        for (HashNode *node = park->records_map->buckets[i]; node != NULL;
+                node = node->next) {
+            for (RecordNode *rec = node->records; rec != NULL;
+                    rec = rec->next) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Writes the records of a park in hash map traversal order
+static int write_park_records(FILE *file, Park *park) {
+    if (park->snapshot_records != NULL) {
+        size_t count = park->snapshot_record_count;
+        return fwrite(park->snapshot_records, sizeof(SnapshotRecord), count,
+                        file) == count;
+    }
+    for (int i = 0; i < park->records_map->size; i++) {
+        for (HashNode *node = park->records_map->buckets[i]; node != NULL;
+                node = node->next) {
+            for (RecordNode *rec = node->records; rec != NULL;
+                    rec = rec->next) {
+                SnapshotRecord saved;
+                memset(&saved, 0, sizeof(saved));
+                strcpy(saved.license_plate, rec->record.license_plate);
+                saved.in_minute = saturate_minute(
+                    date_to_minutes(*rec->record.in_date));
+                saved.out_minute = rec->record.out_date == NULL ?
+                    SNAPSHOT_NO_DATE :
+                    saturate_minute(date_to_minutes(*rec->record.out_date));
+                saved.cost_cents = rec->record.cost_cents;
+                saved.spot = rec->record.spot;
+                if (fwrite(&saved, sizeof(saved), 1, file) != 1) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Size in bytes of the columns of a history with the given number of rows
+static uint64_t history_size(uint64_t count) {
+    return count * (sizeof(uint64_t) + sizeof(int64_t) +
+                    3 * sizeof(int32_t));
+}
+
+// Writes the columns of a park's history back to back
+static int write_park_history(FILE *file, const History *history) {
+    size_t count = history->count;
+    if (count == 0) {
+        return 1; // An empty history may have no columns at all
+    }
+    return fwrite(history->plates, sizeof(uint64_t), count, file) == count &&
+        fwrite(history->cost_cents, sizeof(long long), count, file) ==
+            count &&
+        fwrite(history->in_minutes, sizeof(int), count, file) == count &&
+        fwrite(history->out_minutes, sizeof(int), count, file) == count &&
+        fwrite(history->tariff_ids, sizeof(int), count, file) == count;
+}
+
+// Size in bytes of an occupancy timeline with the given number of events
+static uint64_t occupancy_size(uint64_t count) {
+    return count * sizeof(uint32_t) +
+            occupancy_checkpoints(count) * sizeof(int32_t);
+}
+
+// Writes the events of a park's occupancy timeline and then its checkpoints
+static int write_park_occupancy(FILE *file, const Occupancy *occupancy) {
+    size_t count = occupancy->count;
+    if (count == 0) {
+        return 1; // An empty timeline may have no arrays at all
+    }
+    size_t checkpoints = occupancy_checkpoints(occupancy->count);
+    return fwrite(occupancy->events, sizeof(uint32_t), count, file) == count &&
+        fwrite(occupancy->checkpoints, sizeof(int), checkpoints, file) ==
+            checkpoints;
+}
+
+// Writes zeroes until the file reaches the given offset
+static int write_padding(FILE *file, uint64_t from, uint64_t to) {
+    for (; from < to; from++) {
+        if (fputc(0, file) == EOF) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Fills the park table and returns the total size of the file
+static uint64_t layout_snapshot(Parks *parks, SnapshotPark *table) {
+    uint64_t offset = sizeof(SnapshotHeader) +
+                        parks->size * sizeof(SnapshotPark);
+    int count = 0;
+    for (int i = 0; i < parks->capacity; i++) {
+        Park *park = parks->parks[i];
+        if (park == NULL) {
+            continue;
+        }
+        SnapshotPark *entry = &table[count++];
+        entry->id = park->id;
+        entry->capacity = park->capacity;
+        entry->available_spots = parks->free_spots[i];
+        entry->price_15 = park->price_15;
+        entry->price_15_1h = park->price_15_1h;
+        entry->price_1h = park->price_1h;
+        entry->last_minute = parks->last_minutes[i] == NO_MINUTE ?
+                                SNAPSHOT_NO_DATE :
+                                saturate_minute(parks->last_minutes[i]);
+        entry->name_length = strlen(park->name);
+        entry->archived_count = park->archived_count;
+        entry->occupied = park->occupancy.occupied;
+        entry->next_tariff_id = park->tariffs.next_id;
+        entry->tariff_count = park->tariffs.count;
+        entry->zone_count = park->zones.count - 1;
+        entry->name_offset = offset;
+        offset += entry->name_length + 1;
+    }
+    offset = align_offset(offset);
+    count = 0;
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            SnapshotPark *entry = &table[count++];
+            entry->records_offset = offset;
+            entry->record_count = count_park_records(parks->parks[i]);
+            offset += entry->record_count * sizeof(SnapshotRecord);
+        }
+    }
+    count = 0;
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            SnapshotPark *entry = &table[count++];
+            offset = align_offset(offset);
+            entry->history_offset = offset;
+            entry->history_count = parks->parks[i]->history.count;
+            offset += history_size(entry->history_count);
+        }
+    }
+    count = 0;
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            SnapshotPark *entry = &table[count++];
+            offset = align_offset(offset);
+            entry->occupancy_offset = offset;
+            entry->occupancy_count = parks->parks[i]->occupancy.count;
+            offset += occupancy_size(entry->occupancy_count);
+        }
+    }
+    count = 0;
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            SnapshotPark *entry = &table[count++];
+            offset = align_offset(offset);
+            entry->tariff_offset = offset;
+            offset += entry->tariff_count * sizeof(Tariff);
+        }
+    }
+    count = 0;
+    for (int i = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            SnapshotPark *entry = &table[count++];
+            offset = align_offset(offset);
+            entry->zone_offset = offset;
+            offset += entry->zone_count * sizeof(Zone);
+        }
+    }
+    return offset;
+}
+
+// Size in bytes of a pass table with the given passes and buckets
+static uint64_t passes_size(uint64_t count, uint64_t bucket_count) {
+    return count * sizeof(PassEntry) + bucket_count * sizeof(uint32_t);
+}
+
+// Fills the pass fields of the header, the table being saved after the
+// given offset; returns the total size of the file
+static uint64_t layout_passes(const PassTable *passes, SnapshotHeader *header,
+                                uint64_t offset) {
+    if (passes == NULL) {
+        return offset;
+    }
+    header->has_passes = 1;
+    header->pass_count = passes->count;
+    header->pass_bucket_count = passes->bucket_count;
+    header->pass_salt = passes->salt;
+    header->pass_offset = align_offset(offset);
+    return header->pass_offset +
+            passes_size(passes->count, passes->bucket_count);
+}
+
+// Writes the header, park table, names and records of a snapshot
+static int write_snapshot(FILE *file, Parks *parks, SnapshotPark *table) {
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.record_size = sizeof(SnapshotRecord);
+    header.park_count = parks->size;
+    header.parks_id = parks->parks_id;
+    const PassTable *passes = parks->passes.current;
+    uint64_t end = layout_snapshot(parks, table);
+    header.file_size = layout_passes(passes, &header, end);
+
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(table, sizeof(SnapshotPark), parks->size, file) !=
+            (size_t)parks->size) {
+        return 0;
+    }
+    uint64_t offset = sizeof(header) + parks->size * sizeof(SnapshotPark);
+    for (int i = 0, n = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            size_t length = table[n++].name_length + 1;
+            if (fwrite(parks->parks[i]->name, 1, length, file) != length) {
+                return 0;
+            }
+            offset += length;
+        }
+    }
+    if (!write_padding(file, offset, align_offset(offset))) {
+        return 0;
+    }
+    offset = align_offset(offset);
+    for (int i = 0, n = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            if (!write_park_records(file, parks->parks[i])) {
+                return 0;
+            }
+            offset += table[n++].record_count * sizeof(SnapshotRecord);
+        }
+    }
+    for (int i = 0, n = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            if (!write_padding(file, offset, table[n].history_offset) ||
+                !write_park_history(file, &parks->parks[i]->history)) {
+                return 0;
+            }
+            offset = table[n].history_offset +
+                        history_size(table[n].history_count);
+            n++;
+        }
+    }
+    for (int i = 0, n = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            if (!write_padding(file, offset, table[n].occupancy_offset) ||
+                !write_park_occupancy(file, &parks->parks[i]->occupancy)) {
+                return 0;
+            }
+            offset = table[n].occupancy_offset +
+                        occupancy_size(table[n].occupancy_count);
+            n++;
+        }
+    }
+    for (int i = 0, n = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            const TariffPlan *tariffs = &parks->parks[i]->tariffs;
+            size_t count = tariffs->count;
+            if (!write_padding(file, offset, table[n].tariff_offset) ||
+                fwrite(tariffs->versions, sizeof(Tariff), count, file) !=
+                    count) {
+                return 0;
+            }
+            offset = table[n].tariff_offset + count * sizeof(Tariff);
+            n++;
+        }
+    }
+    for (int i = 0, n = 0; i < parks->capacity; i++) {
+        if (parks->parks[i] != NULL) {
+            // The park itself is not saved as a zone
+            const ZoneTree *zones = &parks->parks[i]->zones;
+            size_t count = zones->count - 1;
+            if (!write_padding(file, offset, table[n].zone_offset) ||
+                fwrite(zones->zones + 1, sizeof(Zone), count, file) !=
+                    count) {
+                return 0;
+            }
+            offset = table[n].zone_offset + count * sizeof(Zone);
+            n++;
+        }
+    }
+    if (passes != NULL) {
+        size_t count = passes->count;
+        size_t bucket_count = passes->bucket_count;
+        if (!write_padding(file, offset, header.pass_offset) ||
+            (count > 0 && fwrite(passes->entries, sizeof(PassEntry), count,
+                                    file) != count) ||
+            (bucket_count > 0 && fwrite(passes->seeds, sizeof(uint32_t),
+                                        bucket_count, file) != bucket_count)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int save_snapshot(Parks *parks, const char *path) {
+    price_parks(parks);
+    finish_pass_load(&parks->passes, 1);
+    char *tmp_path = (char *)malloc(strlen(path) +
+                                    sizeof(SNAPSHOT_TMP_SUFFIX));
+    SnapshotPark *table = (SnapshotPark *)calloc(parks->size + 1,
+                                                 sizeof(SnapshotPark));
+    if (tmp_path == NULL || table == NULL) {
+        free(tmp_path);
+        free(table);
+        return 0; // Memory allocation failed
+    }
+    strcpy(tmp_path, path);
+    strcat(tmp_path, SNAPSHOT_TMP_SUFFIX);
+
+    int ok = 0;
+    FILE *file = fopen(tmp_path, "wb");
+    if (file != NULL) {
+        ok = write_snapshot(file, parks, table);
+        ok = (fclose(file) == 0) && ok;
+        // Replace the old snapshot only once the new one is complete
+        ok = ok && rename(tmp_path, path) == 0;
+        if (!ok) {
+            remove(tmp_path);
+        }
+    }
+    free(tmp_path);
+    free(table);
+    return ok;
+}
+
+// Checks that a park entry only refers to bytes inside the mapped file
+static int isSnapshotParkValid(const char *base, uint64_t size,
+                                const SnapshotPark *entry) {
+    if (entry->capacity <= 0 || entry->available_spots < 0 ||
+        entry->available_spots > entry->capacity ||
+        entry->name_offset >= size ||
+        entry->name_length >= size - entry->name_offset ||
+        base[entry->name_offset + entry->name_length] != '\0' ||
+        entry->records_offset % sizeof(int32_t) != 0 ||
+        entry->records_offset > size ||
+        entry->record_count > (size - entry->records_offset) /
+                                sizeof(SnapshotRecord) ||
+        entry->history_offset % sizeof(uint64_t) != 0 ||
+        entry->history_offset > size || entry->history_count > INT32_MAX ||
+        entry->archived_count < 0 ||
+        (uint64_t)entry->archived_count > entry->history_count ||
+        history_size(entry->history_count) > size - entry->history_offset ||
+        entry->occupancy_offset % sizeof(uint64_t) != 0 ||
+        entry->occupancy_offset > size ||
+        entry->occupancy_count > INT32_MAX ||
+        occupancy_size(entry->occupancy_count) >
+            size - entry->occupancy_offset ||
+        entry->tariff_offset % sizeof(int32_t) != 0 ||
+        entry->tariff_offset > size || entry->tariff_count == 0 ||
+        entry->tariff_count > (size - entry->tariff_offset) /
+                                sizeof(Tariff) ||
+        entry->zone_offset % sizeof(int32_t) != 0 ||
+        entry->zone_offset > size ||
+        entry->zone_count > (size - entry->zone_offset) / sizeof(Zone)) {
+        return 0;
+    }
+    return 1;
+}
+
+// Checks the header of a mapped snapshot against this build
+static int isSnapshotHeaderValid(const SnapshotHeader *header, uint64_t size) {
+    return size >= sizeof(SnapshotHeader) &&
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+        header->version == SNAPSHOT_VERSION &&
+        header->byte_order == SNAPSHOT_BYTE_ORDER &&
+        header->record_size == sizeof(SnapshotRecord) &&
+        header->file_size == size && header->park_count <= MAX_LOTS &&
+        header->park_count <= (size - sizeof(SnapshotHeader)) /
+                                sizeof(SnapshotPark) &&
+        (!header->has_passes ||
+        (header->pass_offset % sizeof(uint64_t) == 0 &&
+        header->pass_offset <= size && header->pass_count <= INT32_MAX &&
+        header->pass_bucket_count <= INT32_MAX &&
+        passes_size(header->pass_count, header->pass_bucket_count) <=
+            size - header->pass_offset));
+}
+
+// Adds the saved zones to a restored park, checking each of them
+static int restore_park_zones(Park *park, const Zone *zones, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (memchr(zones[i].name, '\0', ZONE_NAME_SIZE) == NULL ||
+            memchr(zones[i].type, '\0', ZONE_NAME_SIZE) == NULL ||
+            add_park_zone(park, &zones[i]) != ZONE_OK) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Takes the spots of the vehicles still inside a restored park, checking
+// that each is in the park and held by one vehicle only
+static int claim_snapshot_spots(Park *park) {
+    const SnapshotRecord *records = park->snapshot_records;
+    for (int i = 0; i < park->snapshot_record_count; i++) {
+        if (records[i].out_minute != SNAPSHOT_NO_DATE) {
+            continue;
+        }
+        if (!claim_zone_spot(&park->zones, records[i].spot)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Creates the park described by a snapshot entry, leaving its records mapped
+static Park *restore_park(const char *base, const SnapshotPark *entry) {
+    Park *park = create_park(base + entry->name_offset, entry->capacity,
+                                entry->price_15, entry->price_15_1h,
+                                entry->price_1h, entry->id);
+    if (park == NULL) {
+        return NULL;
+    }
+    if (entry->record_count > 0) {
+        park->snapshot_records = base + entry->records_offset;
+        park->snapshot_record_count = entry->record_count;
+    }
+    if (entry->history_count > 0) {
+        borrow_history(&park->history, base + entry->history_offset,
+                        entry->history_count);
+    }
+    park->archived_count = entry->archived_count;
+    if (entry->occupancy_count > 0) {
+        borrow_occupancy(&park->occupancy, base + entry->occupancy_offset,
+                            entry->occupancy_count, entry->occupied);
+    }
+    // The saved costs were priced by the saved tariffs
+    destroy_tariff_plan(&park->tariffs);
+    if (!load_tariff_plan(&park->tariffs,
+                            (const Tariff *)(base + entry->tariff_offset),
+                            entry->tariff_count, entry->next_tariff_id) ||
+        !restore_park_zones(park, (const Zone *)(base + entry->zone_offset),
+                            entry->zone_count) ||
+        !claim_snapshot_spots(park)) {
+        destroy_park(park);
+        free(park);
+        return NULL;
+    }
+    park->priced_rows = park->history.count;
+    return park;
+}
+
+// Adds the vehicles of a restored park to the network wide index: those
+// with records in it, those still inside and their archived rows
+static int index_snapshot_vehicles(Parks *parks, Park *park) {
+    const SnapshotRecord *records = park->snapshot_records;
+    char license_plate[LICENSE_PLATE_SIZE];
+    for (int i = 0; i < park->snapshot_record_count; i++) {
+        memcpy(license_plate, records[i].license_plate,
+                sizeof(license_plate) - 1);
+        license_plate[sizeof(license_plate) - 1] = '\0';
+        uint64_t plate = pack_license_plate(license_plate);
+        add_vehicle_visit(&parks->vehicles, plate, park->handle,
+                            &parks->names);
+        if (records[i].out_minute == SNAPSHOT_NO_DATE) {
+            set_vehicle_park(&parks->vehicles, plate, park->handle);
+        }
+    }
+    return link_archived_rows(parks, park, park->archived_count);
+}
+
+// Rebuilds the parks described by a mapped snapshot
+static Parks *restore_parks(const char *base, uint64_t size) {
+    const SnapshotHeader *header = (const SnapshotHeader *)base;
+    const SnapshotPark *table = (const SnapshotPark *)(header + 1);
+    Parks *parks = create_parks();
+    if (parks == NULL) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < header->park_count; i++) {
+        Park *park = NULL;
+        if (isSnapshotParkValid(base, size, &table[i])) {
+            park = restore_park(base, &table[i]);
+        }
+        if (park == NULL) {
+            free_parks(parks);
+            return NULL;
+        }
+        add_park(parks, park);
+        parks->free_spots[park->handle] = table[i].available_spots;
+        if (table[i].last_minute != SNAPSHOT_NO_DATE) {
+            parks->last_minutes[park->handle] = table[i].last_minute;
+        }
+        index_park_history(parks, park);
+        if (!index_snapshot_vehicles(parks, park)) {
+            free_parks(parks);
+            return NULL;
+        }
+    }
+    parks->parks_id = header->parks_id;
+    const PassEntry *entries = (const PassEntry *)(base + header->pass_offset);
+    if (header->has_passes &&
+        !restore_pass_table(&parks->passes, header->pass_salt,
+                            (const uint32_t *)(entries + header->pass_count),
+                            header->pass_bucket_count, entries,
+                            header->pass_count)) {
+        free_parks(parks);
+        return NULL;
+    }
+    return parks;
+}
+
+Parks *load_snapshot(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+    uint64_t size = info.st_size;
+    char *base = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    Parks *parks = NULL;
+    if (isSnapshotHeaderValid((const SnapshotHeader *)base, size)) {
+        parks = restore_parks(base, size);
+    }
+    if (parks == NULL) {
+        munmap(base, size);
+        return NULL;
+    }
+    parks->snapshot = base;
+    parks->snapshot_size = size;
+    return parks;
+}
+
+// Adds one saved record to the hash map of a park
+static void add_snapshot_record(Park *park, const SnapshotRecord *saved) {
+    ParkRecord record;
+    memcpy(record.license_plate, saved->license_plate,
+            sizeof(record.license_plate) - 1);
+    record.license_plate[sizeof(record.license_plate) - 1] = '\0';
+    // add_record copies the dates into the node it adds
+    Date in_date = minutes_to_date(saved->in_minute);
+    Date out_date;
+    record.in_date = &in_date;
+    record.out_date = NULL;
+    if (saved->out_minute != SNAPSHOT_NO_DATE) {
+        out_date = minutes_to_date(saved->out_minute);
+        record.out_date = &out_date;
+    }
+    record.cost_cents = saved->cost_cents;
+    record.spot = saved->spot;
+    record.pass = NO_PASS;
+    add_record(park->records_map, record.license_plate, &record);
+}
+
+void materialize_snapshot_records(Park *park) {
+    const SnapshotRecord *records = park->snapshot_records;
+    int end = park->snapshot_record_count;
+    park->snapshot_records = NULL;
+    park->snapshot_record_count = 0;
+
+    // Vehicles are added from the last to the first: add_record puts a new
+    // vehicle at the head of its bucket, which restores the saved order
+    while (end > 0) {
+        int start = end - 1;
+        while (start > 0 && strncmp(records[start - 1].license_plate,
+                                    records[end - 1].license_plate,
+                                    sizeof(records->license_plate)) == 0) {
+            start--;
+        }
+        for (int i = start; i < end; i++) {
+            add_snapshot_record(park, &records[i]);
+        }
+        end = start;
+    }
+}
+
+void release_snapshot(Parks *parks) {
+    if (parks->snapshot != NULL) {
+        munmap(parks->snapshot, parks->snapshot_size);
+        parks->snapshot = NULL;
+        parks->snapshot_size = 0;
+    }
+}
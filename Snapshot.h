@@ -0,0 +1,129 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "Parks.h"
+#include "Park.h"
+
+// Magic bytes at the start of every snapshot file
+#define SNAPSHOT_MAGIC "PKSNAP"
+// Version of the binary layout, bumped on every incompatible change
+#define SNAPSHOT_VERSION 9
+// Known value written in the header to detect a foreign byte order
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+// Minute value used for a missing date (open record or park without events)
+#define SNAPSHOT_NO_DATE -1
+
+/**
+ * @struct SnapshotHeader
+ * @brief Header at the start of a snapshot file.
+ *
+ * Every offset in the file is relative to its first byte, so the image is
+ * position independent and can be mapped at any address.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t record_size;   // sizeof(SnapshotRecord) of the writer
+    uint32_t park_count;
+    int32_t parks_id;       // Next id to be given to a new park
+    uint32_t pass_count;    // Passes of the table in force
+    uint64_t file_size;
+    uint64_t pass_salt;     // Salt of the pass table in force
+    uint64_t pass_offset;   // Pass entries by slot, then the bucket seeds
+    uint32_t pass_bucket_count;
+    uint32_t has_passes;    // Whether a pass table was in force
+} SnapshotHeader;
+
+/**
+ * @struct SnapshotPark
+ * @brief Fixed size description of one park, stored right after the header.
+ */
+typedef struct {
+    int32_t id;
+    int32_t capacity;
+    int32_t available_spots;
+    float price_15;
+    float price_15_1h;
+    float price_1h;
+    int32_t last_minute;    // Minute of the last event or SNAPSHOT_NO_DATE
+    uint32_t name_length;   // Length of the name, without the terminator
+    int32_t archived_count; // Leading history rows not in the records
+    int32_t occupied;       // Occupancy after the last timeline event
+    int32_t next_tariff_id; // Id of the next tariff version of the park
+    uint32_t tariff_count;
+    uint32_t zone_count;    // Zones added to the park
+    uint32_t reserved;
+    uint64_t name_offset;
+    uint64_t records_offset;
+    uint64_t record_count;
+    uint64_t history_offset;    // Columns of the park's History, back to back
+    uint64_t history_count;
+    uint64_t occupancy_offset;  // Timeline events followed by checkpoints
+    uint64_t occupancy_count;
+    uint64_t tariff_offset;     // Tariff structs, by their first minute
+    uint64_t zone_offset;       // Zone structs, in the order they were added
+} SnapshotPark;
+
+/**
+ * @struct SnapshotRecord
+ * @brief One park record, with its dates stored as minutes.
+ *
+ * Records of the same vehicle are contiguous and kept in entry order; the
+ * vehicles follow the traversal order of the park's hash map.
+ */
+typedef struct {
+    int64_t cost_cents;     // 0 while the vehicle is inside
+    char license_plate[12];
+    int32_t in_minute;
+    int32_t out_minute;     // SNAPSHOT_NO_DATE while the vehicle is inside
+    int32_t spot;           // Spot taken by the vehicle, NO_SPOT if none
+} SnapshotRecord;
+
+/**
+ * Writes the whole state of the parking system into a snapshot file.
+ *
+ * Closed stays left to be re-priced after a tariff change are priced
+ * first, so the saved costs are current. A pass file still loading is
+ * waited for, and the pass table in force is saved with the parks.
+ *
+ * The file is first written next to its destination and then renamed over
+ * it, so a snapshot that is currently mapped is never modified in place.
+ *
+ * @param parks The parking system to be saved.
+ * @param path The path of the snapshot file.
+ * @return 1 if the snapshot was written, 0 otherwise.
+ */
+int save_snapshot(Parks *parks, const char *path);
+
+/**
+ * Maps a snapshot file and rebuilds the parking system from it.
+ *
+ * The pass table in force when the snapshot was written is in force
+ * again. Only the parks themselves are created; the records of each park
+ * stay in the mapped file until they are first needed (see
+ * get_records_map), and histories and occupancy timelines are read from
+ * the mapping until they next grow.
+ *
+ * @param path The path of the snapshot file.
+ * @return A pointer to the restored Parks, or NULL if the file is invalid.
+ */
+Parks *load_snapshot(const char *path);
+
+/**
+ * Moves the records of a park still held by the mapped snapshot into its
+ * hash map.
+ *
+ * @param park The park whose records are to be materialized.
+ */
+void materialize_snapshot_records(Park *park);
+
+/**
+ * Unmaps the snapshot file backing the given parking system, if any.
+ *
+ * @param parks The parking system.
+ */
+void release_snapshot(Parks *parks);
+
+#endif /* SNAPSHOT_H */
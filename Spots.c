@@ -0,0 +1,138 @@
+/**
+ * File containing the implementation of the bitmaps of the free spots of a
+ * park.
+ * @file Spots.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include "Spots.h"
+
+// Number of bits of a bitmap word
+#define SPOT_WORD_BITS 64
+
+// Number of words needed for a number of bits
+static int words_for(int bits) {
+    return (bits + SPOT_WORD_BITS - 1) / SPOT_WORD_BITS;
+}
+
+// Bitmap word with the lowest bits set, for the last word of a bitmap
+static uint64_t low_bits(int count) {
+    return count >= SPOT_WORD_BITS ? ~0ull : (1ull << count) - 1;
+}
+
+void init_spot_map(SpotMap *map, int capacity) {
+    map->words = NULL;
+    map->summary = NULL;
+    map->capacity = capacity;
+    map->word_count = 0;
+    map->summary_count = 0;
+    map->first_summary = 0;
+}
+
+// Allocates at least a number of words, doubling the ones allocated; the
+// new words have every spot free
+static int grow_spot_map(SpotMap *map, int min_words) {
+    int word_count = map->word_count > 0 ? 2 * map->word_count : 1;
+    if (word_count < min_words) {
+        word_count = min_words;
+    }
+    if (word_count > words_for(map->capacity)) {
+        word_count = words_for(map->capacity);
+    }
+    int summary_count = words_for(word_count);
+    uint64_t *words = (uint64_t *)realloc(map->words,
+                                            word_count * sizeof(uint64_t));
+    if (words == NULL) {
+        return 0; // Memory allocation failed
+    }
+    map->words = words;
+    uint64_t *summary = (uint64_t *)realloc(map->summary,
+                                            summary_count * sizeof(uint64_t));
+    if (summary == NULL) {
+        return 0; // Memory allocation failed; the new words stay unused
+    }
+    map->summary = summary;
+    for (int i = map->summary_count; i < summary_count; i++) {
+        map->summary[i] = 0;
+    }
+    for (int i = map->word_count; i < word_count; i++) {
+        map->words[i] = low_bits(map->capacity - i * SPOT_WORD_BITS);
+        map->summary[i / SPOT_WORD_BITS] |= 1ull << (i % SPOT_WORD_BITS);
+    }
+    if (map->first_summary > map->word_count / SPOT_WORD_BITS) {
+        map->first_summary = map->word_count / SPOT_WORD_BITS;
+    }
+    map->word_count = word_count;
+    map->summary_count = summary_count;
+    return 1;
+}
+
+// Marks a spot taken, clearing the summary bit of its word once it is full
+static void mark_taken(SpotMap *map, int index) {
+    int word = index / SPOT_WORD_BITS;
+    map->words[word] &= ~(1ull << (index % SPOT_WORD_BITS));
+    if (map->words[word] == 0) {
+        map->summary[word / SPOT_WORD_BITS] &=
+            ~(1ull << (word % SPOT_WORD_BITS));
+    }
+}
+
+int take_spot(SpotMap *map) {
+    // Summary words before first_summary are all zero, so skipping them as
+    // they fill up keeps the search amortized constant
+    while (map->first_summary < map->summary_count &&
+            map->summary[map->first_summary] == 0) {
+        map->first_summary++;
+    }
+    if (map->first_summary == map->summary_count) {
+        // Every allocated spot is taken: the next one is in new words
+        if (map->word_count == words_for(map->capacity) ||
+            !grow_spot_map(map, map->word_count + 1)) {
+            return NO_SPOT;
+        }
+        return take_spot(map);
+    }
+    int word = map->first_summary * SPOT_WORD_BITS +
+                __builtin_ctzll(map->summary[map->first_summary]);
+    int index = word * SPOT_WORD_BITS + __builtin_ctzll(map->words[word]);
+    mark_taken(map, index);
+    return index + 1;
+}
+
+int claim_spot(SpotMap *map, int spot) {
+    int index = spot - 1;
+    if (index / SPOT_WORD_BITS >= map->word_count &&
+        !grow_spot_map(map, index / SPOT_WORD_BITS + 1)) {
+        return 0;
+    }
+    mark_taken(map, index);
+    return 1;
+}
+
+void release_spot(SpotMap *map, int spot) {
+    if (spot == NO_SPOT) {
+        return;
+    }
+    int index = spot - 1;
+    int word = index / SPOT_WORD_BITS;
+    map->words[word] |= 1ull << (index % SPOT_WORD_BITS);
+    map->summary[word / SPOT_WORD_BITS] |= 1ull << (word % SPOT_WORD_BITS);
+    if (word / SPOT_WORD_BITS < map->first_summary) {
+        map->first_summary = word / SPOT_WORD_BITS;
+    }
+}
+
+int is_spot_free(const SpotMap *map, int spot) {
+    int word = (spot - 1) / SPOT_WORD_BITS;
+    return word >= map->word_count ||
+            ((map->words[word] >> ((spot - 1) % SPOT_WORD_BITS)) & 1);
+}
+
+void destroy_spot_map(SpotMap *map) {
+    free(map->words);
+    free(map->summary);
+    map->words = NULL;
+    map->summary = NULL;
+    map->word_count = 0;
+    map->summary_count = 0;
+}
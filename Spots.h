@@ -0,0 +1,81 @@
+#ifndef SPOTS_H
+#define SPOTS_H
+
+#include <stdint.h>
+
+// Spot of a record that holds none (see SpotMap)
+#define NO_SPOT 0
+
+/**
+ * @struct SpotMap
+ * @brief Which spots of a park are free, one bit per spot.
+ *
+ * Spots are numbered from 1 to the capacity. A set bit of a word marks a
+ * free spot, and a set bit of the summary marks a word with some free
+ * spot, so the lowest free spot is found with two find-first-set
+ * operations once the first summary word with a free spot is known.
+ *
+ * Only the words up to the highest spot ever taken are allocated (the
+ * others are all free), doubling as they are needed, so a large park that
+ * is never full does not pay for its whole capacity.
+ */
+typedef struct {
+    uint64_t *words;        // Bit i of word w: spot 64 * w + i + 1 is free
+    uint64_t *summary;      // Bit i of word s: word 64 * s + i has a free spot
+    int capacity;
+    int word_count;         // Words allocated
+    int summary_count;
+    int first_summary;      // No summary word before it has a free spot
+} SpotMap;
+
+/**
+ * Initializes a map with every spot free, without allocating it.
+ *
+ * @param map The map to be initialized.
+ * @param capacity The number of spots.
+ */
+void init_spot_map(SpotMap *map, int capacity);
+
+/**
+ * Takes the lowest free spot.
+ *
+ * @param map The map.
+ * @return The spot, or NO_SPOT if every spot is taken or memory allocation
+ * failed.
+ */
+int take_spot(SpotMap *map);
+
+/**
+ * Takes a given spot, e.g. one restored from a snapshot.
+ *
+ * @param map The map.
+ * @param spot The spot, free.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int claim_spot(SpotMap *map, int spot);
+
+/**
+ * Frees a taken spot.
+ *
+ * @param map The map.
+ * @param spot The spot, or NO_SPOT to do nothing.
+ */
+void release_spot(SpotMap *map, int spot);
+
+/**
+ * Checks whether a spot is free.
+ *
+ * @param map The map.
+ * @param spot The spot, from 1 to the capacity.
+ * @return 1 if it is free, 0 otherwise.
+ */
+int is_spot_free(const SpotMap *map, int spot);
+
+/**
+ * Frees the memory of a map.
+ *
+ * @param map The map.
+ */
+void destroy_spot_map(SpotMap *map);
+
+#endif /* SPOTS_H */
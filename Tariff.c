@@ -0,0 +1,93 @@
+/**
+ * File containing the implementation of the versioned tariffs of a park.
+ * @file Tariff.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Tariff.h"
+
+int init_tariff_plan(TariffPlan *plan, float price_15, float price_15_1h,
+                        float price_1h) {
+    plan->versions = (Tariff *)malloc(TARIFF_INITIAL_VERSIONS *
+                                        sizeof(Tariff));
+    plan->count = 0;
+    plan->capacity = plan->versions != NULL ? TARIFF_INITIAL_VERSIONS : 0;
+    plan->next_id = 0;
+    Tariff tariff = {TARIFF_ALWAYS, 0, price_15, price_15_1h, price_1h};
+    return plan->versions != NULL && set_tariff(plan, &tariff);
+}
+
+int load_tariff_plan(TariffPlan *plan, const Tariff *versions, int count,
+                        int next_id) {
+    if (count <= 0 || versions[0].from_minute != TARIFF_ALWAYS) {
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (versions[i].id < 0 || versions[i].id >= next_id ||
+            (i > 0 && versions[i].from_minute <= versions[i - 1].from_minute)) {
+            return 0;
+        }
+    }
+    plan->versions = (Tariff *)malloc(count * sizeof(Tariff));
+    if (plan->versions == NULL) {
+        return 0; // Memory allocation failed
+    }
+    memcpy(plan->versions, versions, count * sizeof(Tariff));
+    plan->count = count;
+    plan->capacity = count;
+    plan->next_id = next_id;
+    return 1;
+}
+
+// Index of the last version that starts at or before the minute
+static int version_at(const TariffPlan *plan, int minute) {
+    int low = 0;
+    int high = plan->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (plan->versions[middle].from_minute <= minute) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low - 1;
+}
+
+int set_tariff(TariffPlan *plan, Tariff *tariff) {
+    // Versions starting at or after the new one are superseded by it
+    int count = version_at(plan, tariff->from_minute) + 1;
+    if (count > 0 && plan->versions[count - 1].from_minute ==
+                        tariff->from_minute) {
+        count--;
+    }
+    if (count == plan->capacity) {
+        int capacity = plan->capacity * 2;
+        Tariff *versions = (Tariff *)realloc(plan->versions,
+                                                capacity * sizeof(Tariff));
+        if (versions == NULL) {
+            return 0; // Memory allocation failed
+        }
+        plan->versions = versions;
+        plan->capacity = capacity;
+    }
+    tariff->id = plan->next_id++;
+    plan->versions[count] = *tariff;
+    plan->count = count + 1;
+    return 1;
+}
+
+const Tariff *tariff_at(const TariffPlan *plan, int in_minute) {
+    if (plan->count == 1) {
+        return plan->versions; // The common case: the tariff never changed
+    }
+    return &plan->versions[version_at(plan, in_minute)];
+}
+
+void destroy_tariff_plan(TariffPlan *plan) {
+    free(plan->versions);
+    plan->versions = NULL;
+    plan->count = 0;
+    plan->capacity = 0;
+}
@@ -0,0 +1,89 @@
+#ifndef TARIFF_H
+#define TARIFF_H
+
+#include <limits.h>
+
+// Start of the first tariff of a park, before any possible minute
+#define TARIFF_ALWAYS INT_MIN
+// Initial number of versions allocated for a tariff plan
+#define TARIFF_INITIAL_VERSIONS 4
+
+/**
+ * @struct Tariff
+ * @brief Prices of a park from a given minute on.
+ */
+typedef struct {
+    int from_minute;        // First entry minute it applies to
+    int id;                 // Version, unique within the park
+    float price_15;
+    float price_15_1h;
+    float price_1h;
+} Tariff;
+
+/**
+ * @struct TariffPlan
+ * @brief Versions of the tariff of a park, sorted by their first minute.
+ *
+ * A stay is charged by the tariff in force when the vehicle entered.
+ */
+typedef struct {
+    Tariff *versions;
+    int count;
+    int capacity;
+    int next_id;            // Id of the next version to be added
+} TariffPlan;
+
+/**
+ * Initializes a plan with a single tariff that always applies.
+ *
+ * @param plan The plan to be initialized.
+ * @param price_15 The price for each 15 minutes of the first hour.
+ * @param price_15_1h The price for each 15 minutes after the first hour.
+ * @param price_1h The largest price of a day.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int init_tariff_plan(TariffPlan *plan, float price_15, float price_15_1h,
+                        float price_1h);
+
+/**
+ * Initializes a plan with saved versions, keeping their ids.
+ *
+ * @param plan The plan to be initialized.
+ * @param versions The versions, the first one starting at TARIFF_ALWAYS
+ * and the others sorted by their first minute.
+ * @param count The number of versions.
+ * @param next_id The id of the next version to be added, larger than any
+ * of the saved ones.
+ * @return 1 on success, 0 if the versions are not valid or memory
+ * allocation failed.
+ */
+int load_tariff_plan(TariffPlan *plan, const Tariff *versions, int count,
+                        int next_id);
+
+/**
+ * Changes the tariff from a given minute on, replacing every version that
+ * starts at or after it.
+ *
+ * @param plan The plan.
+ * @param tariff The new prices and their first minute; its id is set.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int set_tariff(TariffPlan *plan, Tariff *tariff);
+
+/**
+ * Gets the tariff that charges a stay.
+ *
+ * @param plan The plan.
+ * @param in_minute The minute the vehicle entered (see date_to_minutes).
+ * @return The tariff in force at that minute.
+ */
+const Tariff *tariff_at(const TariffPlan *plan, int in_minute);
+
+/**
+ * Frees the memory of a plan.
+ *
+ * @param plan The plan.
+ */
+void destroy_tariff_plan(TariffPlan *plan);
+
+#endif /* TARIFF_H */
@@ -0,0 +1,382 @@
+/**
+ * File containing the implementation of the network wide index of the
+ * vehicles inside the parks.
+ * @file Vehicles.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Vehicles.h"
+
+// Home slot of a plate (splitmix64 finalizer)
+static int home_slot(uint64_t plate, int slot_count) {
+    plate ^= plate >> 30;
+    plate *= 0xBF58476D1CE4E5B9ull;
+    plate ^= plate >> 27;
+    plate *= 0x94D049BB133111EBull;
+    plate ^= plate >> 31;
+    return plate & (slot_count - 1);
+}
+
+// Slot holding the plate, or the empty slot where it would be inserted
+static int find_slot(const VehicleSlot *slots, int slot_count,
+                        uint64_t plate) {
+    int slot = home_slot(plate, slot_count);
+    while (slots[slot].plate != 0 && slots[slot].plate != plate) {
+        slot = (slot + 1) & (slot_count - 1);
+    }
+    return slot;
+}
+
+// Checks whether a vehicle still has records in a park that was not removed
+static int has_live_visits(const VehicleIndex *index,
+                            const VehicleSlot *slot) {
+    for (int i = 0; i < slot->visit_count; i++) {
+        if (slot->visits[i].epoch == index->epochs[slot->visits[i].park]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Rebuilds the filter from the vehicles with records in the current parks,
+// sized for the current number of slots
+static void rebuild_filter(VehicleIndex *index) {
+    index->seen_stale = 0;
+    if (!reset_bloom_filter(&index->seen, index->slot_count /
+                                            VEHICLES_SLOTS_PER_BLOOM_BLOCK)) {
+        return; // Without blocks the filter lets every plate through
+    }
+    for (int i = 0; i < index->slot_count; i++) {
+        if (index->slots[i].plate != 0 &&
+            has_live_visits(index, &index->slots[i])) {
+            bloom_add(&index->seen, index->slots[i].plate);
+        }
+    }
+}
+
+// Moves the vehicles to a table with a new number of slots
+static int resize_index(VehicleIndex *index, int slot_count) {
+    VehicleSlot *slots = (VehicleSlot *)calloc(slot_count,
+                                                sizeof(VehicleSlot));
+    if (slots == NULL) {
+        return 0; // Memory allocation failed
+    }
+    for (int i = 0; i < index->slot_count; i++) {
+        if (index->slots[i].plate != 0) {
+            slots[find_slot(slots, slot_count, index->slots[i].plate)] =
+                index->slots[i];
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->slot_count = slot_count;
+    rebuild_filter(index);
+    return 1;
+}
+
+// Doubles the number of slots, keeping the load factor at most one half
+static int grow_index(VehicleIndex *index) {
+    return resize_index(index, index->slot_count > 0 ?
+                        2 * index->slot_count : VEHICLES_INITIAL_SLOTS);
+}
+
+// Empties a slot, moving back the vehicles probed past it so that every
+// vehicle stays reachable from its home slot
+static void remove_slot(VehicleIndex *index, int slot) {
+    int mask = index->slot_count - 1;
+    int hole = slot;
+    for (int next = (hole + 1) & mask; index->slots[next].plate != 0;
+            next = (next + 1) & mask) {
+        int home = home_slot(index->slots[next].plate, index->slot_count);
+        // It may fill the hole if the hole is between its home and it
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->slots[hole] = index->slots[next];
+            hole = next;
+        }
+    }
+    memset(&index->slots[hole], 0, sizeof(VehicleSlot));
+    index->count--;
+}
+
+// Drops the visits of a vehicle to parks removed since
+static void drop_stale_visits(const VehicleIndex *index, VehicleSlot *slot) {
+    int kept = 0;
+    for (int i = 0; i < slot->visit_count; i++) {
+        if (slot->visits[i].epoch == index->epochs[slot->visits[i].park]) {
+            slot->visits[kept++] = slot->visits[i];
+        }
+    }
+    slot->visit_count = kept;
+}
+
+int init_vehicle_index(VehicleIndex *index, int handles) {
+    index->slots = NULL;
+    index->count = 0;
+    index->slot_count = 0;
+    index->epochs = (unsigned *)calloc(handles, sizeof(unsigned));
+    init_bloom_filter(&index->seen);
+    index->seen_stale = 0;
+    index->archived = NULL;
+    index->archived_count = 0;
+    index->archived_slot_count = 0;
+    return index->epochs != NULL;
+}
+
+// Checks whether a plate is certainly not in the index with live records;
+// a vehicle inside a park always has records in it
+static int surely_unseen(const VehicleIndex *index, uint64_t plate) {
+    return index->slot_count == 0 ||
+            (!index->seen_stale && !bloom_may_contain(&index->seen, plate));
+}
+
+int vehicle_park(const VehicleIndex *index, uint64_t plate) {
+    if (surely_unseen(index, plate)) {
+        return NO_PARK;
+    }
+    const VehicleSlot *slot = &index->slots[find_slot(index->slots,
+                                            index->slot_count, plate)];
+    if (slot->plate == 0 || slot->park == NO_PARK ||
+        slot->epoch != index->epochs[slot->park]) {
+        return NO_PARK;
+    }
+    return slot->park;
+}
+
+// Slot of a plate, added outside every park if it is new (NULL if memory
+// allocation failed)
+static VehicleSlot *get_slot(VehicleIndex *index, uint64_t plate) {
+    if (2 * (index->count + 1) > index->slot_count && !grow_index(index)) {
+        return NULL;
+    }
+    VehicleSlot *slot = &index->slots[find_slot(index->slots,
+                                        index->slot_count, plate)];
+    if (slot->plate == 0) {
+        slot->plate = plate;
+        slot->park = NO_PARK;
+        index->count++;
+    }
+    return slot;
+}
+
+void set_vehicle_park(VehicleIndex *index, uint64_t plate, int park) {
+    VehicleSlot *slot = get_slot(index, plate);
+    if (slot != NULL) {
+        slot->park = park;
+        slot->epoch = park == NO_PARK ? 0 : index->epochs[park];
+    }
+}
+
+void add_vehicle_visit(VehicleIndex *index, uint64_t plate, int park,
+                        const NameTable *names) {
+    VehicleSlot *slot = get_slot(index, plate);
+    if (slot == NULL) {
+        return;
+    }
+    bloom_add(&index->seen, plate);
+    drop_stale_visits(index, slot);
+    int rank = 0;
+    for (int i = 0; i < slot->visit_count; i++) {
+        if (slot->visits[i].park == park) {
+            return;
+        }
+        if (strcmp(names->names[slot->visits[i].park],
+                    names->names[park]) < 0) {
+            rank = i + 1;
+        }
+    }
+    // The array grows whenever its size reaches a power of two
+    int count = slot->visit_count;
+    if ((count & (count - 1)) == 0) {
+        VehicleVisit *visits = (VehicleVisit *)realloc(slot->visits,
+                                    (count > 0 ? 2 * count : 1) *
+                                    sizeof(VehicleVisit));
+        if (visits == NULL) {
+            return; // Memory allocation failed
+        }
+        slot->visits = visits;
+    }
+    memmove(slot->visits + rank + 1, slot->visits + rank,
+            (count - rank) * sizeof(VehicleVisit));
+    slot->visits[rank].park = park;
+    slot->visits[rank].epoch = index->epochs[park];
+    slot->visit_count++;
+}
+
+const VehicleVisit *vehicle_visits(VehicleIndex *index, uint64_t plate,
+                                    int *count) {
+    *count = 0;
+    if (index->seen_stale && index->slot_count > 0) {
+        rebuild_filter(index);
+    }
+    if (surely_unseen(index, plate)) {
+        return NULL;
+    }
+    VehicleSlot *slot = &index->slots[find_slot(index->slots,
+                                        index->slot_count, plate)];
+    drop_stale_visits(index, slot);
+    *count = slot->visit_count;
+    return slot->visits;
+}
+
+void drop_vehicle_visit(VehicleIndex *index, uint64_t plate, int park) {
+    if (index->slot_count == 0) {
+        return;
+    }
+    int position = find_slot(index->slots, index->slot_count, plate);
+    VehicleSlot *slot = &index->slots[position];
+    if (slot->plate == 0) {
+        return;
+    }
+    drop_stale_visits(index, slot);
+    int kept = 0;
+    for (int i = 0; i < slot->visit_count; i++) {
+        if (slot->visits[i].park != park) {
+            slot->visits[kept++] = slot->visits[i];
+        }
+    }
+    slot->visit_count = kept;
+    // A vehicle inside a park has records in it
+    if (kept > 0 || (slot->park != NO_PARK &&
+                        slot->epoch == index->epochs[slot->park])) {
+        return;
+    }
+    free(slot->visits);
+    remove_slot(index, position);
+    // The table shrinks with the vehicles; a failed shrink changes nothing
+    if (index->slot_count > VEHICLES_INITIAL_SLOTS &&
+        8 * index->count < index->slot_count) {
+        resize_index(index, index->slot_count / 2);
+    }
+}
+
+// Slot of the archive table holding the plate, or the empty slot where it
+// would be inserted
+static int find_archived_slot(const ArchivedVehicle *slots, int slot_count,
+                                uint64_t plate) {
+    int slot = home_slot(plate, slot_count);
+    while (slots[slot].plate != 0 && slots[slot].plate != plate) {
+        slot = (slot + 1) & (slot_count - 1);
+    }
+    return slot;
+}
+
+// Doubles the number of slots of the archive table
+static int grow_archive(VehicleIndex *index) {
+    int slot_count = index->archived_slot_count > 0 ?
+                        2 * index->archived_slot_count :
+                        VEHICLES_INITIAL_SLOTS;
+    ArchivedVehicle *slots = (ArchivedVehicle *)calloc(slot_count,
+                                                sizeof(ArchivedVehicle));
+    if (slots == NULL) {
+        return 0; // Memory allocation failed
+    }
+    for (int i = 0; i < index->archived_slot_count; i++) {
+        if (index->archived[i].plate != 0) {
+            slots[find_archived_slot(slots, slot_count,
+                    index->archived[i].plate)] = index->archived[i];
+        }
+    }
+    free(index->archived);
+    index->archived = slots;
+    index->archived_slot_count = slot_count;
+    return 1;
+}
+
+// Drops the archived rows of a vehicle in parks removed since
+static void drop_stale_archive(const VehicleIndex *index,
+                                ArchivedVehicle *vehicle) {
+    int kept = 0;
+    for (int i = 0; i < vehicle->visit_count; i++) {
+        if (vehicle->visits[i].epoch ==
+            index->epochs[vehicle->visits[i].park]) {
+            vehicle->visits[kept++] = vehicle->visits[i];
+        }
+    }
+    vehicle->visit_count = kept;
+}
+
+int archive_vehicle_row(VehicleIndex *index, uint64_t plate, int park,
+                        int row, int *links, const NameTable *names) {
+    if (2 * (index->archived_count + 1) > index->archived_slot_count &&
+        !grow_archive(index)) {
+        return 0;
+    }
+    ArchivedVehicle *vehicle = &index->archived[find_archived_slot(
+                        index->archived, index->archived_slot_count, plate)];
+    if (vehicle->plate == 0) {
+        vehicle->plate = plate;
+        index->archived_count++;
+    }
+    drop_stale_archive(index, vehicle);
+    links[row] = NO_ROW;
+    int rank = 0;
+    for (int i = 0; i < vehicle->visit_count; i++) {
+        if (vehicle->visits[i].park == park) {
+            links[vehicle->visits[i].last_row] = row;
+            vehicle->visits[i].last_row = row;
+            return 1;
+        }
+        if (strcmp(names->names[vehicle->visits[i].park],
+                    names->names[park]) < 0) {
+            rank = i + 1;
+        }
+    }
+    // The array grows whenever its size reaches a power of two
+    int count = vehicle->visit_count;
+    if ((count & (count - 1)) == 0) {
+        ArchivedVisit *visits = (ArchivedVisit *)realloc(vehicle->visits,
+                                    (count > 0 ? 2 * count : 1) *
+                                    sizeof(ArchivedVisit));
+        if (visits == NULL) {
+            return 0; // Memory allocation failed
+        }
+        vehicle->visits = visits;
+    }
+    memmove(vehicle->visits + rank + 1, vehicle->visits + rank,
+            (count - rank) * sizeof(ArchivedVisit));
+    vehicle->visits[rank].park = park;
+    vehicle->visits[rank].epoch = index->epochs[park];
+    vehicle->visits[rank].first_row = row;
+    vehicle->visits[rank].last_row = row;
+    vehicle->visit_count++;
+    return 1;
+}
+
+const ArchivedVisit *archived_visits(VehicleIndex *index, uint64_t plate,
+                                        int *count) {
+    *count = 0;
+    if (index->archived_count == 0) {
+        return NULL;
+    }
+    ArchivedVehicle *vehicle = &index->archived[find_archived_slot(
+                        index->archived, index->archived_slot_count, plate)];
+    drop_stale_archive(index, vehicle);
+    *count = vehicle->visit_count;
+    return vehicle->visits;
+}
+
+void forget_park_vehicles(VehicleIndex *index, int park) {
+    index->epochs[park]++;
+    index->seen_stale = 1; // Rebuilt by the next vehicle_visits
+}
+
+void destroy_vehicle_index(VehicleIndex *index) {
+    for (int i = 0; i < index->slot_count; i++) {
+        free(index->slots[i].visits);
+    }
+    for (int i = 0; i < index->archived_slot_count; i++) {
+        free(index->archived[i].visits);
+    }
+    free(index->slots);
+    free(index->archived);
+    free(index->epochs);
+    destroy_bloom_filter(&index->seen);
+    index->slots = NULL;
+    index->archived = NULL;
+    index->archived_count = 0;
+    index->archived_slot_count = 0;
+    index->epochs = NULL;
+    index->count = 0;
+    index->slot_count = 0;
+}
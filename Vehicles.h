@@ -0,0 +1,201 @@
+#ifndef VEHICLES_H
+#define VEHICLES_H
+
+#include <stdint.h>
+#include "Names.h"
+#include "Bloom.h"
+
+// Park handle of a vehicle that is not inside any park
+#define NO_PARK -1
+// Initial number of slots of the index, a power of two
+#define VEHICLES_INITIAL_SLOTS 1024
+// Number of slots of the index per block of its Bloom filter, so the
+// filter has 8 bits per slot and at least 16 per vehicle
+#define VEHICLES_SLOTS_PER_BLOOM_BLOCK 64
+// End of a chain of archived history rows
+#define NO_ROW -1
+
+/**
+ * @struct VehicleVisit
+ * @brief A park a vehicle has records in.
+ */
+typedef struct {
+    int park;               // Handle of the park
+    unsigned epoch;         // Epoch of the handle when the visit was added
+} VehicleVisit;
+
+/**
+ * @struct ArchivedVisit
+ * @brief The archived history rows of a vehicle in one park.
+ *
+ * The rows are chained, oldest first, through the archive_links of the
+ * park, so they are read without scanning the rest of its history.
+ */
+typedef struct {
+    int park;               // Handle of the park
+    unsigned epoch;         // Epoch of the handle when the visit was added
+    int first_row;
+    int last_row;
+} ArchivedVisit;
+
+/**
+ * @struct ArchivedVehicle
+ * @brief One vehicle of the archive table.
+ */
+typedef struct {
+    uint64_t plate;         // Packed plate, 0 if the slot is empty
+    int visit_count;
+    ArchivedVisit *visits;  // Parks it has archived rows in, in name order
+} ArchivedVehicle;
+
+/**
+ * @struct VehicleSlot
+ * @brief One vehicle of the index.
+ */
+typedef struct {
+    uint64_t plate;         // Packed plate, 0 if the slot is empty
+    int park;               // Handle of the park it is inside, or NO_PARK
+    unsigned epoch;         // Epoch of that handle when it entered
+    int visit_count;
+    VehicleVisit *visits;   // Parks it has records in, in name order
+} VehicleSlot;
+
+/**
+ * @struct VehicleIndex
+ * @brief Network wide index from a packed license plate to the park the
+ * vehicle is currently inside and to the parks it has records in.
+ *
+ * A vehicle stays in the index while it is inside a park or has records
+ * that are not archived, so the index is bounded by recent activity.
+ * Removing a park only bumps the epoch of its handle: references stamped
+ * with an older epoch are stale and are ignored, and dropped the next time
+ * their vehicle is updated.
+ *
+ * A Bloom filter over the plates with records answers most lookups of
+ * plates never seen without probing the table. It is rebuilt when the
+ * table grows and, after a park is removed, before it is used again.
+ *
+ * A second table keeps, for each plate with archived history rows, where
+ * those rows are in each park (see ArchivedVisit).
+ */
+typedef struct {
+    VehicleSlot *slots;     // Open addressing table, linear probing
+    int count;
+    int slot_count;         // Power of two
+    unsigned *epochs;       // Current epoch of each park handle
+    BloomFilter seen;       // Plates with records in some park
+    int seen_stale;         // Whether a park was removed since it was built
+    ArchivedVehicle *archived;  // Open addressing table, linear probing
+    int archived_count;
+    int archived_slot_count;    // Power of two
+} VehicleIndex;
+
+/**
+ * Initializes an empty index.
+ *
+ * @param index The index to be initialized.
+ * @param handles The number of park handles.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int init_vehicle_index(VehicleIndex *index, int handles);
+
+/**
+ * Gets the park a vehicle is inside.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @return The handle of the park, or NO_PARK.
+ */
+int vehicle_park(const VehicleIndex *index, uint64_t plate);
+
+/**
+ * Sets the park a vehicle is inside.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param park The handle of the park, or NO_PARK once it left.
+ */
+void set_vehicle_park(VehicleIndex *index, uint64_t plate, int park);
+
+/**
+ * Adds a park to the ones a vehicle has records in, unless it is there
+ * already.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param park The handle of the park.
+ * @param names The table with the names of the parks, to keep the visits
+ * in name order.
+ */
+void add_vehicle_visit(VehicleIndex *index, uint64_t plate, int park,
+                        const NameTable *names);
+
+/**
+ * Gets the parks a vehicle has records in.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param count The number of parks.
+ * @return The parks, in name order.
+ */
+const VehicleVisit *vehicle_visits(VehicleIndex *index, uint64_t plate,
+                                    int *count);
+
+/**
+ * Removes a park from the ones a vehicle has records in, once all of its
+ * records there are archived. A vehicle left outside every park and
+ * without records is removed from the index, which shrinks as vehicles
+ * leave it; its archived rows stay in the archive table.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param park The handle of the park.
+ */
+void drop_vehicle_visit(VehicleIndex *index, uint64_t plate, int park);
+
+/**
+ * Adds an archived history row of a park to the rows of its vehicle.
+ *
+ * Rows of a park have to be added in history order.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param park The handle of the park.
+ * @param row The row in the history of the park.
+ * @param links The archive_links of the park; the row is chained to the
+ * previous archived row of the vehicle in it.
+ * @param names The table with the names of the parks, to keep the visits
+ * in name order.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int archive_vehicle_row(VehicleIndex *index, uint64_t plate, int park,
+                        int row, int *links, const NameTable *names);
+
+/**
+ * Gets the parks a vehicle has archived history rows in.
+ *
+ * @param index The index.
+ * @param plate The packed license plate (see pack_license_plate).
+ * @param count The number of parks.
+ * @return The parks, in name order.
+ */
+const ArchivedVisit *archived_visits(VehicleIndex *index, uint64_t plate,
+                                        int *count);
+
+/**
+ * Forgets every reference to a park, before the park is removed, in
+ * constant time.
+ *
+ * @param index The index.
+ * @param park The handle of the park.
+ */
+void forget_park_vehicles(VehicleIndex *index, int park);
+
+/**
+ * Frees the memory of an index.
+ *
+ * @param index The index.
+ */
+void destroy_vehicle_index(VehicleIndex *index);
+
+#endif /* VEHICLES_H */
@@ -0,0 +1,140 @@
+/**
+ * File containing the implementation of the pool of threads that runs the
+ * parallel jobs.
+ * @file Workers.c
+ * @author ist1102716
+*/
+#include <signal.h>
+#include <unistd.h>
+#include "Workers.h"
+
+// Number of threads a job runs on, the caller included; 0 uses one per
+// online processor (it can be set at build time, e.g. -DWORKERS_THREADS=4)
+#ifndef WORKERS_THREADS
+#define WORKERS_THREADS 0
+#endif
+
+// Runs the task on the items not claimed yet
+static void claim_items(WorkerPool *pool, WorkerTask task, void *context) {
+    int item;
+    while ((item = __atomic_fetch_add(&pool->next_item, 1,
+                                        __ATOMIC_RELAXED)) < pool->items) {
+        task(context, item);
+    }
+}
+
+// Body of the threads: runs each job posted until the pool is stopped
+static void *run_worker(void *argument) {
+    WorkerPool *pool = (WorkerPool *)argument;
+    // The threads are started before the first job is posted, however late
+    // they get to run
+    unsigned done = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->job == done && !pool->stopping) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        done = pool->job;
+        WorkerTask task = pool->task;
+        void *context = pool->context;
+        pthread_mutex_unlock(&pool->lock);
+        claim_items(pool, task, context);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->finished);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Number of threads a job should run on, the caller included
+static int wanted_threads(void) {
+    long threads = WORKERS_THREADS;
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1) {
+        return 1;
+    }
+    return threads < WORKERS_MAX_THREADS ? (int)threads : WORKERS_MAX_THREADS;
+}
+
+// Starts the threads with every signal blocked, so signals keep going to
+// the thread that waits for them
+static void start_workers(WorkerPool *pool) {
+    sigset_t all_signals;
+    sigset_t previous;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &previous);
+    int wanted = wanted_threads() - 1;
+    while (pool->thread_count < wanted &&
+            pthread_create(&pool->threads[pool->thread_count], NULL,
+                            run_worker, pool) == 0) {
+        pool->thread_count++;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    pool->started = 1;
+}
+
+void init_worker_pool(WorkerPool *pool) {
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    pool->thread_count = 0;
+    pool->started = 0;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->items = 0;
+    pool->next_item = 0;
+    pool->busy = 0;
+    pool->job = 0;
+    pool->stopping = 0;
+}
+
+void run_in_parallel(WorkerPool *pool, WorkerTask task, void *context,
+                        int items) {
+    if (!pool->started) {
+        start_workers(pool);
+    }
+    if (pool->thread_count == 0 || items < 2) {
+        for (int i = 0; i < items; i++) {
+            task(context, i);
+        }
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->items = items;
+    __atomic_store_n(&pool->next_item, 0, __ATOMIC_RELAXED);
+    pool->busy = pool->thread_count;
+    pool->job++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    claim_items(pool, task, context);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void stop_worker_pool(WorkerPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->thread_count = 0;
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->finished);
+}
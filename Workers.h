@@ -0,0 +1,69 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <pthread.h>
+
+// Largest number of threads a pool runs a job on, the caller included
+#define WORKERS_MAX_THREADS 16
+
+/**
+ * A task run for each item of a parallel job.
+ *
+ * @param context The context of the job.
+ * @param item The item, from 0 to the number of items - 1.
+ */
+typedef void (*WorkerTask)(void *context, int item);
+
+/**
+ * @struct WorkerPool
+ * @brief Threads that share the items of a job with the thread that runs
+ * it.
+ *
+ * The threads are only started by the first job, one less than the online
+ * processors, and then wait for the next one.
+ */
+typedef struct {
+    pthread_t threads[WORKERS_MAX_THREADS - 1];
+    int thread_count;       // Threads started
+    int started;            // Whether the threads were started
+    pthread_mutex_t lock;
+    pthread_cond_t wake;    // A job was posted or the pool is stopping
+    pthread_cond_t finished; // Every thread is done with the job
+    WorkerTask task;
+    void *context;
+    int items;
+    int next_item;          // First item not claimed yet
+    int busy;               // Threads still working on the job
+    unsigned job;           // Number of jobs posted
+    int stopping;
+} WorkerPool;
+
+/**
+ * Initializes a pool, without starting its threads.
+ *
+ * @param pool The pool to be initialized.
+ */
+void init_worker_pool(WorkerPool *pool);
+
+/**
+ * Runs a task for every item of a job, on the calling thread and on the
+ * threads of the pool, and waits for all of them.
+ *
+ * Items are claimed one at a time, so the order they run in is unspecified.
+ *
+ * @param pool The pool.
+ * @param task The task.
+ * @param context The context passed to every run of the task.
+ * @param items The number of items.
+ */
+void run_in_parallel(WorkerPool *pool, WorkerTask task, void *context,
+                        int items);
+
+/**
+ * Stops the threads of a pool.
+ *
+ * @param pool The pool.
+ */
+void stop_worker_pool(WorkerPool *pool);
+
+#endif /* WORKERS_H */
@@ -0,0 +1,328 @@
+/**
+ * File containing the implementation of the zones of a park and of the
+ * segment tree that finds their free spots.
+ * @file Zones.c
+ * @author ist1102716
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "Zones.h"
+
+/**
+ * @struct ZoneLayout
+ * @brief Arrays of a layout being built, swapped in once complete.
+ */
+typedef struct {
+    ZonePool *pools;
+    int *zone_pools;
+    ZoneNode *nodes;
+    int leaves;
+    char (*types)[ZONE_NAME_SIZE];
+    int type_count;
+    int pool_count;         // Pools placed so far
+} ZoneLayout;
+
+// Gets the index of a type of the layout, adding it if it is new
+static int intern_type(ZoneLayout *layout, const char *type) {
+    for (int i = 0; i < layout->type_count; i++) {
+        if (strcmp(layout->types[i], type) == 0) {
+            return i;
+        }
+    }
+    strcpy(layout->types[layout->type_count], type);
+    return layout->type_count++;
+}
+
+// Places the pool of a zone and then those of its subzones, depth first,
+// numbering their spots from first_spot on; zones are few, so the children
+// of each zone are found by scanning all of them
+static void place_zone(const ZoneTree *tree, ZoneLayout *layout, int zone,
+                        int first_spot, int parent_tariff) {
+    const Zone *zones = tree->zones;
+    int own = zones[zone].capacity;
+    for (int i = zone + 1; i < tree->count; i++) {
+        if (zones[i].parent == zone) {
+            own -= zones[i].capacity;
+        }
+    }
+    int p = layout->pool_count++;
+    ZonePool *pool = &layout->pools[p];
+    pool->zone = zone;
+    pool->first_spot = first_spot;
+    pool->own = own;
+    pool->type = intern_type(layout, zones[zone].type);
+    pool->tariff_zone = zones[zone].has_tariff ? zone : parent_tariff;
+    init_spot_map(&pool->spots, own);
+    layout->zone_pools[zone] = p;
+
+    int spot = first_spot + own;
+    // A child is always defined after its parent
+    for (int i = zone + 1; i < tree->count; i++) {
+        if (zones[i].parent == zone) {
+            place_zone(tree, layout, i, spot, pool->tariff_zone);
+            spot += zones[i].capacity;
+        }
+    }
+    layout->pools[p].subtree_end = layout->pool_count;
+}
+
+// Sums the free spots and types of the two children of a node
+static void combine_node(ZoneNode *nodes, int node) {
+    nodes[node].free = nodes[2 * node].free + nodes[2 * node + 1].free;
+    nodes[node].free_types = nodes[2 * node].free_types |
+                                nodes[2 * node + 1].free_types;
+}
+
+// Frees the arrays of a layout
+static void free_layout(ZonePool *pools, int count, int *zone_pools,
+                        ZoneNode *nodes, char (*types)[ZONE_NAME_SIZE]) {
+    for (int i = 0; pools != NULL && i < count; i++) {
+        destroy_spot_map(&pools[i].spots);
+    }
+    free(pools);
+    free(zone_pools);
+    free(nodes);
+    free(types);
+}
+
+// Lays out the pools of every zone with all their spots free and builds the
+// segment tree over them, replacing the current layout
+static int layout_zones(ZoneTree *tree) {
+    ZoneLayout layout;
+    layout.leaves = 1;
+    while (layout.leaves < tree->count) {
+        layout.leaves *= 2;
+    }
+    layout.pools = (ZonePool *)calloc(tree->count, sizeof(ZonePool));
+    layout.zone_pools = (int *)malloc(tree->count * sizeof(int));
+    layout.nodes = (ZoneNode *)calloc(2 * layout.leaves, sizeof(ZoneNode));
+    layout.types = (char (*)[ZONE_NAME_SIZE])malloc(tree->count *
+                                                    ZONE_NAME_SIZE);
+    if (layout.pools == NULL || layout.zone_pools == NULL ||
+        layout.nodes == NULL || layout.types == NULL) {
+        free_layout(layout.pools, 0, layout.zone_pools, layout.nodes,
+                    layout.types);
+        return 0; // Memory allocation failed
+    }
+    layout.type_count = 0;
+    layout.pool_count = 0;
+    place_zone(tree, &layout, ZONE_PARK, 1, NO_ZONE);
+
+    for (int p = 0; p < tree->count; p++) {
+        ZoneNode *leaf = &layout.nodes[layout.leaves + p];
+        leaf->free = layout.pools[p].own;
+        leaf->free_types = leaf->free > 0 ? 1u << layout.pools[p].type : 0;
+    }
+    for (int node = layout.leaves - 1; node > 0; node--) {
+        combine_node(layout.nodes, node);
+    }
+
+    // The zone being added, if any, has no pool in the current layout
+    free_layout(tree->pools, tree->count - 1, tree->zone_pools, tree->nodes,
+                tree->types);
+    tree->pools = layout.pools;
+    tree->zone_pools = layout.zone_pools;
+    tree->nodes = layout.nodes;
+    tree->leaves = layout.leaves;
+    tree->types = layout.types;
+    tree->type_count = layout.type_count;
+    return 1;
+}
+
+int init_zone_tree(ZoneTree *tree, int capacity) {
+    tree->zones = (Zone *)calloc(1, sizeof(Zone));
+    tree->count = 1;
+    tree->pools = NULL;
+    tree->zone_pools = NULL;
+    tree->nodes = NULL;
+    tree->types = NULL;
+    tree->type_count = 0;
+    if (tree->zones == NULL) {
+        return 0; // Memory allocation failed
+    }
+    strcpy(tree->zones[ZONE_PARK].type, ZONE_DEFAULT_TYPE_NAME);
+    tree->zones[ZONE_PARK].parent = NO_ZONE;
+    tree->zones[ZONE_PARK].capacity = capacity;
+    if (!layout_zones(tree)) {
+        free(tree->zones);
+        tree->zones = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+// Finds the enclosing zone of a path: the park, or the zone named by the
+// path up to its last separator
+static int find_parent(const ZoneTree *tree, const char *name) {
+    const char *separator = strrchr(name, ZONE_SEPARATOR);
+    if (separator == NULL) {
+        return ZONE_PARK;
+    }
+    char parent[ZONE_NAME_SIZE];
+    memcpy(parent, name, separator - name);
+    parent[separator - name] = '\0';
+    return find_zone(tree, parent);
+}
+
+int add_zone(ZoneTree *tree, const Zone *zone) {
+    if (find_zone(tree, zone->name) != NO_ZONE) {
+        return ZONE_EXISTS;
+    }
+    int parent = find_parent(tree, zone->name);
+    if (parent == NO_ZONE) {
+        return ZONE_NO_PARENT;
+    }
+    if (zone->capacity <= 0 ||
+        zone->capacity > tree->pools[tree->zone_pools[parent]].own) {
+        return ZONE_INVALID_CAPACITY;
+    }
+    if (find_zone_type(tree, zone->type) == NO_ZONE &&
+        tree->type_count == ZONE_MAX_TYPES) {
+        return ZONE_TOO_MANY_TYPES;
+    }
+    Zone *zones = (Zone *)realloc(tree->zones,
+                                    (tree->count + 1) * sizeof(Zone));
+    if (zones == NULL) {
+        return ZONE_NO_MEMORY;
+    }
+    tree->zones = zones;
+    zones[tree->count] = *zone;
+    zones[tree->count].parent = parent;
+    zones[tree->count].tariff.id = ZONE_TARIFF_ID;
+    tree->count++;
+    if (!layout_zones(tree)) {
+        tree->count--;
+        return ZONE_NO_MEMORY;
+    }
+    return ZONE_OK;
+}
+
+int find_zone(const ZoneTree *tree, const char *name) {
+    for (int i = 0; i < tree->count; i++) {
+        if (strcmp(tree->zones[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return NO_ZONE;
+}
+
+int find_zone_type(const ZoneTree *tree, const char *type) {
+    for (int i = 0; i < tree->type_count; i++) {
+        if (strcmp(tree->types[i], type) == 0) {
+            return i;
+        }
+    }
+    return NO_ZONE;
+}
+
+int has_free_zone_spot(const ZoneTree *tree, int type) {
+    return (tree->nodes[1].free_types >> type) & 1;
+}
+
+// Adds to the free spots of a pool, updating the nodes above it
+static void update_pool(ZoneTree *tree, int pool, int delta) {
+    int node = tree->leaves + pool;
+    tree->nodes[node].free += delta;
+    tree->nodes[node].free_types = tree->nodes[node].free > 0 ?
+                                    1u << tree->pools[pool].type : 0;
+    for (node /= 2; node > 0; node /= 2) {
+        combine_node(tree->nodes, node);
+    }
+}
+
+// Finds the pool holding a spot: the last one starting at or before it,
+// since a pool without spots of its own starts where its first child does
+static int pool_of_spot(const ZoneTree *tree, int spot) {
+    int low = 0;
+    int high = tree->count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (tree->pools[middle].first_spot <= spot) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+int take_zone_spot(ZoneTree *tree, int type) {
+    uint32_t bit = 1u << type;
+    if (!(tree->nodes[1].free_types & bit)) {
+        return NO_SPOT;
+    }
+    // Go down to the leftmost pool with a free spot of the type
+    int node = 1;
+    while (node < tree->leaves) {
+        node = (tree->nodes[2 * node].free_types & bit) ? 2 * node :
+                                                            2 * node + 1;
+    }
+    int pool = node - tree->leaves;
+    int local = take_spot(&tree->pools[pool].spots);
+    if (local == NO_SPOT) {
+        return NO_SPOT; // Memory allocation failed
+    }
+    update_pool(tree, pool, -1);
+    return tree->pools[pool].first_spot + local - 1;
+}
+
+int claim_zone_spot(ZoneTree *tree, int spot) {
+    if (spot < 1 || spot > tree->zones[ZONE_PARK].capacity) {
+        return 0;
+    }
+    int pool = pool_of_spot(tree, spot);
+    int local = spot - tree->pools[pool].first_spot + 1;
+    if (!is_spot_free(&tree->pools[pool].spots, local) ||
+        !claim_spot(&tree->pools[pool].spots, local)) {
+        return 0;
+    }
+    update_pool(tree, pool, -1);
+    return 1;
+}
+
+void release_zone_spot(ZoneTree *tree, int spot) {
+    if (spot == NO_SPOT) {
+        return;
+    }
+    int pool = pool_of_spot(tree, spot);
+    release_spot(&tree->pools[pool].spots,
+                    spot - tree->pools[pool].first_spot + 1);
+    update_pool(tree, pool, 1);
+}
+
+const Tariff *zone_tariff(const ZoneTree *tree, int spot) {
+    if (tree->count == 1 || spot == NO_SPOT) {
+        return NULL; // A park without zones is charged by its own tariffs
+    }
+    int tariff_zone = tree->pools[pool_of_spot(tree, spot)].tariff_zone;
+    return tariff_zone == NO_ZONE ? NULL : &tree->zones[tariff_zone].tariff;
+}
+
+int zone_free_spots(const ZoneTree *tree, int zone) {
+    int first = tree->zone_pools[zone];
+    int free = 0;
+    // Sum the nodes that cover the pools of the zone, bottom up
+    for (int low = tree->leaves + first,
+            high = tree->leaves + tree->pools[first].subtree_end;
+            low < high; low /= 2, high /= 2) {
+        if (low & 1) {
+            free += tree->nodes[low++].free;
+        }
+        if (high & 1) {
+            free += tree->nodes[--high].free;
+        }
+    }
+    return free;
+}
+
+void destroy_zone_tree(ZoneTree *tree) {
+    free_layout(tree->pools, tree->count, tree->zone_pools, tree->nodes,
+                tree->types);
+    free(tree->zones);
+    tree->zones = NULL;
+    tree->pools = NULL;
+    tree->zone_pools = NULL;
+    tree->nodes = NULL;
+    tree->types = NULL;
+    tree->count = 0;
+}
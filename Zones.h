@@ -0,0 +1,196 @@
+#ifndef ZONES_H
+#define ZONES_H
+
+#include <stdint.h>
+#include "Spots.h"
+#include "Tariff.h"
+
+// Size of a zone path or type name, terminator included
+#define ZONE_NAME_SIZE 32
+// Separator of the levels of a zone path, e.g. "P1/ev"
+#define ZONE_SEPARATOR '/'
+// Most distinct zone types in a park
+#define ZONE_MAX_TYPES 32
+// Type of the spots that are not in any zone, and of untyped entries
+#define ZONE_DEFAULT_TYPE_NAME "std"
+// Index of that type, the first one laid out
+#define ZONE_DEFAULT_TYPE 0
+// Index of the whole park among its zones
+#define ZONE_PARK 0
+// Zone or type index of a missing one
+#define NO_ZONE -1
+// Tariff id recorded in the history for stays charged by a zone tariff,
+// which never change
+#define ZONE_TARIFF_ID -1
+
+// Outcomes of add_zone
+#define ZONE_OK 0
+#define ZONE_EXISTS 1
+#define ZONE_NO_PARENT 2
+#define ZONE_INVALID_CAPACITY 3
+#define ZONE_TOO_MANY_TYPES 4
+#define ZONE_NO_MEMORY 5
+
+/**
+ * @struct Zone
+ * @brief A floor or area of a park, as it was defined.
+ *
+ * A zone takes its spots from its parent; the spots the parent keeps for
+ * itself are of the parent's type.
+ */
+typedef struct {
+    char name[ZONE_NAME_SIZE];  // Path from the park, "" for the park
+    char type[ZONE_NAME_SIZE];
+    int32_t parent;             // Index of the enclosing zone, or NO_ZONE
+    int32_t capacity;           // Spots, those of its subzones included
+    int32_t has_tariff;         // Whether it has its own prices
+    Tariff tariff;              // Its prices, id ZONE_TARIFF_ID
+} Zone;
+
+/**
+ * @struct ZonePool
+ * @brief The spots a zone keeps for itself, outside its subzones.
+ */
+typedef struct {
+    int zone;               // Index of the zone
+    int first_spot;         // Its spots are first_spot .. first_spot + own - 1
+    int own;
+    int subtree_end;        // Pools of the zone and its subzones end here
+    int type;               // Index of the type of its spots
+    int tariff_zone;        // Zone whose prices charge it, NO_ZONE: the park's
+    SpotMap spots;
+} ZonePool;
+
+/**
+ * @struct ZoneNode
+ * @brief A node of the segment tree over the pools.
+ */
+typedef struct {
+    int free;               // Free spots of the pools below it
+    uint32_t free_types;    // Bit t: some pool below has a free spot of type t
+} ZoneNode;
+
+/**
+ * @struct ZoneTree
+ * @brief The zones of a park and the free spots of each type.
+ *
+ * The pools are laid out in depth-first order, so the spots of a zone and
+ * of its subzones are contiguous, and so are their pools. A segment tree
+ * over the pools keeps their free spots and the types with a free spot, so
+ * the lowest free spot of a type is found by one walk from the root and
+ * the free spots of a zone are a range sum, both in O(log zones).
+ */
+typedef struct {
+    Zone *zones;            // By definition order, the park first
+    int count;
+    ZonePool *pools;        // By depth-first order
+    int *zone_pools;        // Pool of each zone
+    ZoneNode *nodes;        // Root at 1, leaf of pool p at leaves + p
+    int leaves;
+    char (*types)[ZONE_NAME_SIZE];
+    int type_count;
+} ZoneTree;
+
+/**
+ * Initializes the zones of a park with the whole park as a single zone of
+ * the default type.
+ *
+ * @param tree The tree to be initialized.
+ * @param capacity The number of spots of the park.
+ * @return 1 on success, 0 if memory allocation failed.
+ */
+int init_zone_tree(ZoneTree *tree, int capacity);
+
+/**
+ * Adds a zone, taking its spots from its parent; the spots are numbered
+ * again, so every spot must be free.
+ *
+ * @param tree The tree.
+ * @param zone The zone; its parent is looked up from its path, and its
+ * name and type must be terminated.
+ * @return ZONE_OK, or ZONE_EXISTS, ZONE_NO_PARENT, ZONE_INVALID_CAPACITY if
+ * the parent does not keep that many spots, ZONE_TOO_MANY_TYPES or
+ * ZONE_NO_MEMORY.
+ */
+int add_zone(ZoneTree *tree, const Zone *zone);
+
+/**
+ * Looks up a zone by its path.
+ *
+ * @param tree The tree.
+ * @param name The path of the zone.
+ * @return The index of the zone, or NO_ZONE.
+ */
+int find_zone(const ZoneTree *tree, const char *name);
+
+/**
+ * Looks up a zone type by its name.
+ *
+ * @param tree The tree.
+ * @param type The name of the type.
+ * @return The index of the type, or NO_ZONE.
+ */
+int find_zone_type(const ZoneTree *tree, const char *type);
+
+/**
+ * Checks whether some spot of a type is free.
+ *
+ * @param tree The tree.
+ * @param type The index of the type.
+ * @return 1 if there is one, 0 otherwise.
+ */
+int has_free_zone_spot(const ZoneTree *tree, int type);
+
+/**
+ * Takes the lowest free spot of a type.
+ *
+ * @param tree The tree.
+ * @param type The index of the type.
+ * @return The spot, or NO_SPOT if none is free or memory allocation failed.
+ */
+int take_zone_spot(ZoneTree *tree, int type);
+
+/**
+ * Takes a given free spot, e.g. one restored from a snapshot.
+ *
+ * @param tree The tree.
+ * @param spot The spot, from 1 to the capacity of the park.
+ * @return 1 on success, 0 if it is not free or memory allocation failed.
+ */
+int claim_zone_spot(ZoneTree *tree, int spot);
+
+/**
+ * Frees a taken spot.
+ *
+ * @param tree The tree.
+ * @param spot The spot, or NO_SPOT to do nothing.
+ */
+void release_zone_spot(ZoneTree *tree, int spot);
+
+/**
+ * Gets the prices of the zone of a spot, if it has its own.
+ *
+ * @param tree The tree.
+ * @param spot The spot.
+ * @return The tariff of the zone or of its nearest enclosing zone with one,
+ * or NULL if the park's tariffs apply.
+ */
+const Tariff *zone_tariff(const ZoneTree *tree, int spot);
+
+/**
+ * Counts the free spots of a zone, those of its subzones included.
+ *
+ * @param tree The tree.
+ * @param zone The index of the zone.
+ * @return The number of free spots.
+ */
+int zone_free_spots(const ZoneTree *tree, int zone);
+
+/**
+ * Frees the memory of a tree.
+ *
+ * @param tree The tree.
+ */
+void destroy_zone_tree(ZoneTree *tree);
+
+#endif /* ZONES_H */
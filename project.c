@@ -16,19 +16,73 @@
 #include "Invariants.h"
 #include "Records.h"
 #include "Engine.h"
+#include "Snapshot.h"
+#include "Protocol.h"
+#include "Server.h"
+#include "Pipeline.h"
+#include "Alloc.h"
 
 // Maximum input size for reading commands
 #define MAX_INPUT_SIZE BUFSIZ
 // Maximum number of arguments for a command
 #define MAX_ARGS 10
+// Option selecting the binary frame protocol instead of text commands
+#define BINARY_OPTION "-b"
+// Option serving the parks on a Unix domain socket
+#define SERVER_OPTION "-s"
+// Option running the text commands through the pipelined stages
+#define PIPELINE_OPTION "-p"
 
 
-int main() {
+int main(int argc, char *argv[]) {
     char input[MAX_INPUT_SIZE];
     char *args[MAX_ARGS];
 
-    // Create a Parks object to store the parks
-    Parks *parks = create_parks();
+    // Usage: proj1 [-b | -p | -s <socket>] [snapshot]
+    int binary = argc > 1 && strcmp(argv[1], BINARY_OPTION) == 0;
+    int pipelined = argc > 1 && strcmp(argv[1], PIPELINE_OPTION) == 0;
+    const char *socket_path = NULL;
+    int first = 1 + binary + pipelined;
+    if (argc > 2 && strcmp(argv[1], SERVER_OPTION) == 0) {
+        socket_path = argv[2];
+        first = 3;
+    }
+
+    // Restore the parks from a snapshot if one is given, or start empty
+    Parks *parks;
+    if (argc > first) {
+        parks = load_snapshot(argv[first]);
+        if (parks == NULL) {
+            fprintf(stderr, "%s: invalid snapshot.\n", argv[first]);
+            return 1;
+        }
+    } else {
+        parks = create_parks();
+    }
+
+    if (socket_path != NULL) {
+        int ok = run_server(parks, socket_path);
+        free_parks(parks);
+        if (!ok) {
+            fprintf(stderr, "%s: cannot listen.\n", socket_path);
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (binary) {
+        int ok = run_binary_protocol(parks, stdin, stdout);
+        free_parks(parks);
+        if (!ok) {
+            fprintf(stderr, "invalid frame.\n");
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (pipelined && run_pipeline(parks, stdin, stdout)) {
+        free_parks(parks);
+        PRINT_ALLOC_REPORT(stderr);
+        return 0;
+    }
 
     while (1) {
         // Read a line of input from the terminal
@@ -37,29 +91,17 @@ int main() {
         input[strcspn(input, "\n")] = '\0'; // Remove trailing newline
         
         // Tokenize the input into arguments
-        int argc = tokenize_input(input, args, MAX_ARGS);
+        int nargs = tokenize_input(input, args, MAX_ARGS);
         
         // Process the input command
-        if (argc > 0) {
-            if (strcmp(args[0], "q") == 0) {
-                // Free the memory and exit
-                free_parks(parks);
-                exit(0);
-            } else if (strcmp(args[0], "p") == 0) {
-                add_park_command(parks, args, argc);
-            } else if (strcmp(args[0], "e") == 0) {
-                enter_parking(parks, args);
-            } else if (strcmp(args[0], "s") == 0) {
-                exit_parking(parks, args);
-            } else if (strcmp(args[0], "v") == 0) {
-                print_vehicle_history(parks, args);
-            } else if (strcmp(args[0], "f") == 0) {
-                calculate_cost_command(parks, args, argc);
-            } else if (strcmp(args[0], "r") == 0) {
-                remove_park_command(parks, args);
-            } else {
-                printf("Unknown command: %s\n", args[0]);
-            }
+        BEGIN_COMMAND_ALLOCATIONS();
+        int running = execute_command(parks, args, nargs, stdout);
+        END_COMMAND_ALLOCATIONS(args[0]);
+        if (!running) {
+            // Free the memory and exit
+            free_parks(parks);
+            PRINT_ALLOC_REPORT(stderr);
+            exit(0);
         }
     }
     return 0;
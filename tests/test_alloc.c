@@ -0,0 +1,126 @@
+/**
+ * Test of the allocation-free hot path, built with the counting allocator.
+ *
+ * Warms a parking system up with a fleet of vehicles going in and out of
+ * two parks over several days, with billing queries in between. The parks
+ * then reserve room for the stays to come with the k command and the same
+ * loop runs again: from then on every e, s and f command must make no heap
+ * call at all. Everything goes through execute_command.
+ *
+ * Build: gcc -O2 -DTRACK_ALLOC -o test_alloc tests/test_alloc.c \
+ *            $(ls *.c | grep -v project.c) -lpthread
+ * Usage: test_alloc
+ * @file test_alloc.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <string.h>
+#include "../Alloc.h"
+#include "../Engine.h"
+
+#ifndef TRACK_ALLOC
+#error "test_alloc needs the counting allocator: build it with -DTRACK_ALLOC"
+#endif
+
+// Number of vehicles of the fleet
+#define TEST_FLEET 40
+// Rounds, each one an entry and an exit of every vehicle, of the warm up
+#define TEST_WARM_ROUNDS 60
+// Rounds checked for heap calls
+#define TEST_ROUNDS 200
+// Rounds that fit in one day
+#define TEST_ROUNDS_PER_DAY 10
+// Largest number of tokens of a command
+#define TEST_MAX_ARGS 8
+
+static const char *park_names[] = {"North", "South"};
+#define TEST_PARKS 2
+
+// Runs one command; when checked, reports it if it made any heap call
+static int run(Parks *parks, FILE *sink, int checked, const char *line) {
+    char buffer[BUFSIZ];
+    char *args[TEST_MAX_ARGS];
+    int nargs = 0;
+    strcpy(buffer, line);
+    for (char *token = strtok(buffer, " "); token != NULL &&
+            nargs < TEST_MAX_ARGS; token = strtok(NULL, " ")) {
+        args[nargs++] = token;
+    }
+    AllocCounts before;
+    AllocCounts after;
+    get_alloc_counts(&before);
+    execute_command(parks, args, nargs, sink);
+    get_alloc_counts(&after);
+    if (checked && (after.allocations != before.allocations ||
+                    after.frees != before.frees)) {
+        fprintf(stderr, "%s: %llu allocations, %llu frees\n", line,
+                after.allocations - before.allocations,
+                after.frees - before.frees);
+        return 1;
+    }
+    return 0;
+}
+
+// Runs one round: every vehicle enters one of the parks, the billing of
+// the day is queried, and every vehicle leaves; returns the commands that
+// made heap calls
+static int run_round(Parks *parks, FILE *sink, int checked, int round) {
+    int day = 1 + round / TEST_ROUNDS_PER_DAY;
+    int hour = round % TEST_ROUNDS_PER_DAY * 2;
+    // Months of 28 days keep every date valid
+    int month = 1 + (day - 1) / 28;
+    day = 1 + (day - 1) % 28;
+    char line[BUFSIZ];
+    int failures = 0;
+    for (int i = 0; i < TEST_FLEET; i++) {
+        snprintf(line, sizeof(line), "e %s AA-%02d-BB %02d-%02d-2024 %02d:00",
+                    park_names[i % TEST_PARKS], i, day, month, hour);
+        failures += run(parks, sink, checked, line);
+    }
+    for (int i = 0; i < TEST_FLEET; i++) {
+        snprintf(line, sizeof(line), "s %s AA-%02d-BB %02d-%02d-2024 %02d:%02d",
+                    park_names[i % TEST_PARKS], i, day, month, hour + 1,
+                    i % 60);
+        failures += run(parks, sink, checked, line);
+    }
+    for (int i = 0; i < TEST_PARKS; i++) {
+        snprintf(line, sizeof(line), "f %s %02d-%02d-2024", park_names[i],
+                    day, month);
+        failures += run(parks, sink, checked, line);
+        snprintf(line, sizeof(line), "f %s", park_names[i]);
+        failures += run(parks, sink, checked, line);
+    }
+    failures += run(parks, sink, checked, "f");
+    return failures;
+}
+
+int main(void) {
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink == NULL) {
+        perror("/dev/null");
+        return 1;
+    }
+    Parks *parks = create_parks();
+    run(parks, sink, 0, "p North 100 0.25 0.40 7.00");
+    run(parks, sink, 0, "p South 100 0.30 0.50 8.00");
+    int round = 0;
+    for (; round < TEST_WARM_ROUNDS; round++) {
+        run_round(parks, sink, 0, round);
+    }
+    int stays = TEST_ROUNDS * TEST_FLEET / TEST_PARKS;
+    int days = TEST_ROUNDS / TEST_ROUNDS_PER_DAY + 1;
+    for (int i = 0; i < TEST_PARKS; i++) {
+        char line[BUFSIZ];
+        snprintf(line, sizeof(line), "k %s %d %d", park_names[i], stays,
+                    days);
+        run(parks, sink, 0, line);
+    }
+    int failures = 0;
+    for (int end = round + TEST_ROUNDS; round < end; round++) {
+        failures += run_round(parks, sink, 1, round);
+    }
+    free_parks(parks);
+    fclose(sink);
+    printf("test_alloc: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+/**
+ * Test of the batch frames of the binary protocol.
+ *
+ * Replays the same random entries and exits on two parking systems: one
+ * gets them as batch frames (OPCODE_BATCH, applied by process_gate_batch),
+ * the other one frame per event. The response bytes must be the same.
+ * Events without a park name or a plate must be refused, not crash, and a
+ * batch frame too short for its count must get one invalid frame response.
+ *
+ * Build: gcc -O2 -o test_batch tests/test_batch.c \
+ *            $(ls *.c | grep -v project.c) -lpthread
+ * Usage: test_batch [seed]
+ * @file test_batch.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../Batch.h"
+#include "../Engine.h"
+#include "../Protocol.h"
+
+// Number of random events replayed
+#define TEST_EVENTS 20000
+// Number of distinct plates the events use
+#define TEST_PLATES 40
+// Minute of the first event: 01-01-2024 08:00 (see date_to_minutes)
+#define TEST_FIRST_MINUTE 1063994880
+// Park id no park has
+#define TEST_NO_PARK 1000
+
+static const char *park_names[] = {"North", "South", "East"};
+#define TEST_PARKS 3
+
+// Writes a little endian 32 bit value
+static void put_u32(unsigned char *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// Writes the body of a request: opcode to plate
+static void put_body(unsigned char *body, int opcode, int park_id,
+                        int minute, uint64_t plate) {
+    memset(body, 0, REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE);
+    body[0] = opcode;
+    put_u32(body + 4, park_id);
+    put_u32(body + 8, minute);
+    put_u32(body + 12, (uint32_t)plate);
+    put_u32(body + 16, (uint32_t)(plate >> 32));
+}
+
+// Creates a parking system with small parks, so that some get full
+static Parks *create_test_parks(FILE *sink) {
+    Parks *parks = create_parks();
+    for (int i = 0; i < TEST_PARKS; i++) {
+        char *args[] = {"p", (char *)park_names[i], "12", "0.25", "0.40",
+                        "7.00"};
+        add_park_command(parks, args, 6, sink);
+    }
+    return parks;
+}
+
+// Decodes one frame and appends its responses; returns the bytes appended
+static size_t apply_frame(Parks *parks, const unsigned char *frame,
+                            size_t size, unsigned char *responses) {
+    BinaryRequest request;
+    if (decode_request(frame, size, &request) != (int)size) {
+        fprintf(stderr, "frame not decoded\n");
+        exit(1);
+    }
+    return respond_to_request(parks, &request, responses);
+}
+
+// Replays random events one frame at a time and in batches, comparing the
+// responses; returns the number of differences
+static int compare_random_events(unsigned seed, FILE *sink) {
+    Parks *single = create_test_parks(sink);
+    Parks *batched = create_test_parks(sink);
+    int ids[TEST_PARKS + 1];
+    for (int i = 0; i < TEST_PARKS; i++) {
+        ids[i] = get_park(single, (char *)park_names[i])->id;
+    }
+    ids[TEST_PARKS] = TEST_NO_PARK;
+
+    srand(seed);
+    static unsigned char bodies[TEST_EVENTS][REQUEST_FRAME_SIZE -
+                                                FRAME_LENGTH_SIZE];
+    int minute = TEST_FIRST_MINUTE;
+    for (int i = 0; i < TEST_EVENTS; i++) {
+        char plate[LICENSE_PLATE_SIZE];
+        int n = rand() % TEST_PLATES;
+        snprintf(plate, sizeof(plate), "AA-%02d-BB", n);
+        // Mostly valid events, with some of every kind of refusal
+        int opcode = rand() % 50 == 0 ? OPCODE_BATCH + 1 : 1 + rand() % 2;
+        int event_minute = rand() % 40 == 0 ? minute - 60 : minute;
+        if (rand() % 100 == 0) {
+            event_minute = -1;
+        }
+        uint64_t packed = rand() % 100 == 0 ? 0 : pack_license_plate(plate);
+        put_body(bodies[i], opcode, ids[rand() % (TEST_PARKS + 1)],
+                    event_minute, packed);
+        minute += rand() % 30;
+    }
+
+    static unsigned char expected[TEST_EVENTS * RESPONSE_FRAME_SIZE];
+    static unsigned char actual[TEST_EVENTS * RESPONSE_FRAME_SIZE];
+    size_t expected_size = 0;
+    for (int i = 0; i < TEST_EVENTS; i++) {
+        unsigned char frame[REQUEST_FRAME_SIZE];
+        put_u32(frame, REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE);
+        memcpy(frame + FRAME_LENGTH_SIZE, bodies[i],
+                REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE);
+        expected_size += apply_frame(single, frame, sizeof(frame),
+                                        expected + expected_size);
+    }
+    size_t actual_size = 0;
+    static unsigned char frame[FRAME_LENGTH_SIZE + MAX_FRAME_LENGTH];
+    for (int i = 0; i < TEST_EVENTS; ) {
+        int count = 1 + rand() % MAX_BATCH_EVENTS;
+        if (count > TEST_EVENTS - i) {
+            count = TEST_EVENTS - i;
+        }
+        size_t body_size = REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE;
+        size_t size = BATCH_HEADER_SIZE + count * body_size;
+        memset(frame, 0, BATCH_HEADER_SIZE);
+        put_u32(frame, size - FRAME_LENGTH_SIZE);
+        frame[FRAME_LENGTH_SIZE] = OPCODE_BATCH;
+        put_u32(frame + 8, count);
+        memcpy(frame + BATCH_HEADER_SIZE, bodies[i], count * body_size);
+        actual_size += apply_frame(batched, frame, size,
+                                    actual + actual_size);
+        i += count;
+    }
+
+    int differences = 0;
+    if (expected_size != actual_size) {
+        fprintf(stderr, "seed %u: %zu response bytes, %zu batched\n", seed,
+                expected_size, actual_size);
+        differences++;
+    } else {
+        for (size_t i = 0; i < expected_size; i += RESPONSE_FRAME_SIZE) {
+            if (memcmp(expected + i, actual + i, RESPONSE_FRAME_SIZE) != 0) {
+                fprintf(stderr, "seed %u: event %zu differs\n", seed,
+                        i / RESPONSE_FRAME_SIZE);
+                differences++;
+            }
+        }
+    }
+    free_parks(single);
+    free_parks(batched);
+    return differences;
+}
+
+// Checks that events without a park name or a plate are refused
+static int check_missing_fields(FILE *sink) {
+    Parks *parks = create_test_parks(sink);
+    Date date = minutes_to_date(TEST_FIRST_MINUTE);
+    GateEvent events[] = {
+        {BATCH_ENTRY, NULL, "AA-00-BB", date},
+        {BATCH_ENTRY, NULL, "AA-01-BB", date},
+        {BATCH_ENTRY, park_names[0], NULL, date},
+        {BATCH_ENTRY, park_names[0], "AA-02-BB", date},
+    };
+    int expected[] = {GATE_NO_SUCH_PARKING, GATE_NO_SUCH_PARKING,
+                        GATE_INVALID_PLATE, GATE_OK};
+    GateResult results[4];
+    process_gate_batch(parks, events, 4, results);
+    int failures = 0;
+    for (int i = 0; i < 4; i++) {
+        if (results[i].status != expected[i]) {
+            fprintf(stderr, "missing fields: event %d got status %d\n", i,
+                    results[i].status);
+            failures++;
+        }
+    }
+    free_parks(parks);
+    return failures;
+}
+
+// Checks that a batch frame too short for its count is refused as a whole
+static int check_short_batch(FILE *sink) {
+    Parks *parks = create_test_parks(sink);
+    unsigned char frame[BATCH_HEADER_SIZE];
+    memset(frame, 0, sizeof(frame));
+    put_u32(frame, BATCH_HEADER_SIZE - FRAME_LENGTH_SIZE);
+    frame[FRAME_LENGTH_SIZE] = OPCODE_BATCH;
+    put_u32(frame + 8, 2);
+    unsigned char responses[MAX_RESPONSE_SIZE];
+    size_t size = apply_frame(parks, frame, sizeof(frame), responses);
+    free_parks(parks);
+    if (size != RESPONSE_FRAME_SIZE || responses[5] != GATE_INVALID_FRAME) {
+        fprintf(stderr, "short batch: %zu bytes, status %d\n", size,
+                responses[5]);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 1;
+    FILE *sink = fopen("/dev/null", "w");
+    if (sink == NULL) {
+        perror("/dev/null");
+        return 1;
+    }
+    int failures = compare_random_events(seed, sink) +
+                    check_missing_fields(sink) + check_short_batch(sink);
+    fclose(sink);
+    printf("test_batch: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+/**
+ * Test of the worker pool, with its threads forced on.
+ *
+ * Every round starts a fresh pool and runs a few jobs on it, checking that
+ * each item ran exactly once. The first job of a pool is posted while its
+ * threads may still be starting, and a thread that missed it used to leave
+ * the caller waiting forever, so a round that hangs fails the test.
+ *
+ * Build: gcc -O2 -DWORKERS_THREADS=8 -o test_workers tests/test_workers.c \
+ *            Workers.c -lpthread
+ * Usage: test_workers
+ * @file test_workers.c
+ * @author ist1102716
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../Workers.h"
+
+// Number of fresh pools
+#define TEST_ROUNDS 500
+// Jobs run on each pool
+#define TEST_JOBS 4
+// Largest number of items of a job
+#define TEST_MAX_ITEMS 64
+// Seconds every round together may take before the test counts as hung
+#define TEST_TIMEOUT 60
+
+// Counts the runs of each item
+static void count_item(void *context, int item) {
+    int *runs = (int *)context;
+    __atomic_fetch_add(&runs[item], 1, __ATOMIC_RELAXED);
+}
+
+// Runs the jobs of one pool; returns the number of items not run once
+static int run_round(int round) {
+    WorkerPool pool;
+    init_worker_pool(&pool);
+    int failures = 0;
+    for (int job = 0; job < TEST_JOBS; job++) {
+        int runs[TEST_MAX_ITEMS];
+        int items = 2 + (round + job) % (TEST_MAX_ITEMS - 1);
+        memset(runs, 0, sizeof(runs));
+        run_in_parallel(&pool, count_item, runs, items);
+        for (int i = 0; i < items; i++) {
+            if (runs[i] != 1) {
+                fprintf(stderr, "round %d job %d: item %d ran %d times\n",
+                        round, job, i, runs[i]);
+                failures++;
+            }
+        }
+    }
+    stop_worker_pool(&pool);
+    return failures;
+}
+
+int main(void) {
+    // A hung round never returns, so the alarm ends the test instead
+    alarm(TEST_TIMEOUT);
+    int failures = 0;
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        failures += run_round(round);
+    }
+    printf("test_workers: %s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
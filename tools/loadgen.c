@@ -0,0 +1,279 @@
+/**
+ * Load generator for the socket server mode (proj1 -s <socket>).
+ *
+ * Opens several connections, keeps a fixed number of pipelined requests in
+ * flight on each one, and reports the throughput and the latency
+ * percentiles of the whole run. Every connection alternates the entry and
+ * the exit of its own vehicles in its own park, all at the same minute, so
+ * every request is valid whatever the order the server interleaves them.
+ *
+ * Build: gcc -O2 -o loadgen tools/loadgen.c
+ * Usage: loadgen -s <socket> [-c connections] [-d depth] [-n requests]
+ *                [-i first park id] [-t]
+ *
+ * The parks are created by the load generator, so the server should start
+ * without parks, or -i must give the id the first new park will get.
+ * -t sends text commands instead of binary frames.
+ * @file loadgen.c
+ * @author ist1102716
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../Protocol.h"
+
+// Number of parks the server accepts (MAX_LOTS)
+#define LOADGEN_PARKS MAX_LOTS
+// Capacity of each park, larger than the vehicles ever inside
+#define LOADGEN_CAPACITY 100000
+// Minute of every request: 01-01-2024 08:00 (see date_to_minutes)
+#define LOADGEN_MINUTE 1063994880
+// Date and time of every text request, the same as LOADGEN_MINUTE
+#define LOADGEN_DATE "01-01-2024 08:00"
+// Number of plates used by each connection before reusing them
+#define LOADGEN_PLATES (26 * 26 * 100)
+// Bytes read from a connection at a time
+#define LOADGEN_READ_SIZE 65536
+// Percentiles of the latency reported, in thousandths
+#define LOADGEN_PERCENTILES {500, 900, 990, 999}
+
+typedef struct {
+    int fd;
+    long long sent;             // Requests written
+    long long received;         // Responses read
+    double *sent_at;            // Send time of the requests in flight (ring)
+    size_t partial;             // Bytes of an incomplete binary response
+    long long refused;          // Responses with an error status
+} Client;
+
+static int depth = 16;
+static long long requests = 100000;
+static int text_mode = 0;
+static int first_park_id = 0;
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static int connect_to(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address,
+                            sizeof(address)) != 0) {
+        perror(path);
+        exit(1);
+    }
+    return fd;
+}
+
+static void write_all(int fd, const void *data, size_t size) {
+    const char *bytes = data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0) {
+            perror("write");
+            exit(1);
+        }
+        bytes += written;
+        size -= written;
+    }
+}
+
+// License plate number i of a connection, as LL-DD-LL
+static void make_plate(int client, long long i, char *plate) {
+    int k = i % LOADGEN_PLATES;
+    sprintf(plate, "%c%c-%02d-%c%c", 'A' + k / 2600, 'A' + k / 100 % 26,
+            k % 100, 'A' + client / 26 % 26, 'A' + client % 26);
+}
+
+// Same packing as pack_license_plate
+static uint64_t pack_plate(const char *plate) {
+    uint64_t code = 0;
+    for (int i = 0; plate[i] != '\0'; i++) {
+        if (plate[i] != '-') {
+            code = (code << 8) | (unsigned char)plate[i];
+        }
+    }
+    return code;
+}
+
+static void put_u32(unsigned char *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// Sends request number client->sent: even ones enter, odd ones exit
+static void send_request(Client *client, int index) {
+    char plate[16];
+    int park = index % LOADGEN_PARKS;
+    int is_exit = client->sent % 2;
+    make_plate(index, client->sent / 2, plate);
+    if (text_mode) {
+        char line[128];
+        int length = sprintf(line, "%c lg%02d %s %s\n", is_exit ? 's' : 'e',
+                                park, plate, LOADGEN_DATE);
+        write_all(client->fd, line, length);
+    } else {
+        unsigned char frame[REQUEST_FRAME_SIZE];
+        memset(frame, 0, sizeof(frame));
+        put_u32(frame, REQUEST_FRAME_SIZE - FRAME_LENGTH_SIZE);
+        frame[4] = is_exit ? OPCODE_EXIT : OPCODE_ENTRY;
+        put_u32(frame + 8, first_park_id + park);
+        put_u32(frame + 12, LOADGEN_MINUTE);
+        uint64_t code = pack_plate(plate);
+        put_u32(frame + 16, (uint32_t)code);
+        put_u32(frame + 20, (uint32_t)(code >> 32));
+        write_all(client->fd, frame, sizeof(frame));
+    }
+    client->sent_at[client->sent % depth] = now();
+    client->sent++;
+}
+
+// Creates the parks of the run on a text connection
+static void create_load_parks(const char *path) {
+    int fd = connect_to(path);
+    char line[128];
+    for (int i = 0; i < LOADGEN_PARKS; i++) {
+        int length = sprintf(line, "p lg%02d %d 0.25 0.40 20.00\n", i,
+                                LOADGEN_CAPACITY);
+        write_all(fd, line, length);
+    }
+    write_all(fd, "q\n", 2);
+    while (read(fd, line, sizeof(line)) > 0) {
+        // Wait for the server to close the connection
+    }
+    close(fd);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Reads the responses available on a connection and records their latency
+static void read_responses(Client *client, double *latencies,
+                            long long *count) {
+    unsigned char buffer[LOADGEN_READ_SIZE];
+    ssize_t size = read(client->fd, buffer, sizeof(buffer));
+    if (size <= 0) {
+        fprintf(stderr, "connection closed by the server\n");
+        exit(1);
+    }
+    double arrived = now();
+    for (ssize_t i = 0; i < size; i++) {
+        int complete = 0;
+        if (text_mode) {
+            complete = buffer[i] == '\n';
+        } else {
+            // The status is the sixth byte of a response frame
+            if (client->partial == 5 && buffer[i] != 0) {
+                client->refused++;
+            }
+            client->partial++;
+            complete = client->partial == RESPONSE_FRAME_SIZE;
+        }
+        if (complete) {
+            client->partial = 0;
+            latencies[(*count)++] = arrived -
+                client->sent_at[client->received % depth];
+            client->received++;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    int connections = 4;
+    int option;
+    while ((option = getopt(argc, argv, "s:c:d:n:i:t")) != -1) {
+        switch (option) {
+            case 's': path = optarg; break;
+            case 'c': connections = atoi(optarg); break;
+            case 'd': depth = atoi(optarg); break;
+            case 'n': requests = atoll(optarg); break;
+            case 'i': first_park_id = atoi(optarg); break;
+            case 't': text_mode = 1; break;
+            default: path = NULL; break;
+        }
+    }
+    if (path == NULL || connections <= 0 || depth <= 0 || requests <= 0) {
+        fprintf(stderr, "usage: %s -s <socket> [-c connections] [-d depth] "
+                "[-n requests] [-i first park id] [-t]\n", argv[0]);
+        return 1;
+    }
+    create_load_parks(path);
+
+    Client *clients = calloc(connections, sizeof(Client));
+    struct pollfd *polls = calloc(connections, sizeof(struct pollfd));
+    double *latencies = malloc(requests * connections * sizeof(double));
+    long long count = 0;
+    for (int i = 0; i < connections; i++) {
+        clients[i].fd = connect_to(path);
+        if (!text_mode) {
+            write_all(clients[i].fd, PROTOCOL_MAGIC, PROTOCOL_MAGIC_SIZE);
+        }
+        clients[i].sent_at = calloc(depth, sizeof(double));
+        polls[i].fd = clients[i].fd;
+        polls[i].events = POLLIN;
+    }
+
+    double start = now();
+    for (int i = 0; i < connections; i++) {
+        while (clients[i].sent < depth && clients[i].sent < requests) {
+            send_request(&clients[i], i);
+        }
+    }
+    while (count < requests * connections) {
+        if (poll(polls, connections, -1) < 0) {
+            perror("poll");
+            return 1;
+        }
+        for (int i = 0; i < connections; i++) {
+            if (!(polls[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            read_responses(&clients[i], latencies, &count);
+            // Refill the pipeline
+            while (clients[i].sent - clients[i].received < depth &&
+                    clients[i].sent < requests) {
+                send_request(&clients[i], i);
+            }
+        }
+    }
+    double elapsed = now() - start;
+
+    long long refused = 0;
+    for (int i = 0; i < connections; i++) {
+        refused += clients[i].refused;
+        close(clients[i].fd);
+    }
+    qsort(latencies, count, sizeof(double), compare_doubles);
+    printf("%lld requests, %d connections, depth %d, %s\n", count,
+            connections, depth, text_mode ? "text" : "binary");
+    printf("%.0f requests/s", count / elapsed);
+    if (!text_mode) {
+        printf(", %lld refused", refused);
+    }
+    printf("\n");
+    int percentiles[] = LOADGEN_PERCENTILES;
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(int); i++) {
+        printf("p%g %.1f us\n", percentiles[i] / 10.0,
+                latencies[count * percentiles[i] / 1000] * 1e6);
+    }
+    printf("max %.1f us\n", latencies[count - 1] * 1e6);
+    return 0;
+}